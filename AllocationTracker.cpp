@@ -0,0 +1,270 @@
+#include "AllocationTracker.hpp"
+
+#include "StateHash.hpp"
+
+#include <new>
+#include <mutex>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#define ALLOCATION_TRACKER_BACKTRACE
+#include <execinfo.h>
+#include <cxxabi.h>
+#endif
+
+std::atomic< bool > AllocationTracker::is_enabled(false);
+
+//NOTE: operator new can run before main() (and before other translation units' static constructors),
+// so everything the hook touches is constant-initialized: atomics, plain arrays, and thread_local PODs.
+
+static std::atomic< uint64_t > total_allocations(0);
+static std::atomic< uint64_t > total_bytes(0);
+static std::atomic< uint64_t > scope_allocations[AllocationTracker::MaxScopes];
+static std::atomic< uint64_t > scope_bytes[AllocationTracker::MaxScopes];
+
+static thread_local uint32_t current_scope = 0;
+static thread_local bool in_hook = false; //(set while sampling, since backtrace() may allocate)
+
+static std::atomic< uint32_t > sample_period(0);
+static std::atomic< uint64_t > sample_counter(0);
+
+//sampled stacks, in an open-addressed hash table (full => new stacks are dropped):
+struct StackSample {
+	static const uint32_t MaxDepth = 24;
+	uint64_t hash;
+	uint32_t depth;
+	void *frames[MaxDepth];
+	uint64_t count;
+	uint64_t bytes;
+};
+static const uint32_t SampleSlots = 1024;
+static StackSample samples[SampleSlots];
+static std::atomic_flag samples_lock = ATOMIC_FLAG_INIT;
+static uint64_t dropped_samples = 0;
+
+void AllocationTracker::sample_stack(size_t bytes) {
+#ifdef ALLOCATION_TRACKER_BACKTRACE
+	//(frames[0] is this function, so is left out)
+	void *captured[StackSample::MaxDepth + 1];
+	int depth = backtrace(captured, int(StackSample::MaxDepth + 1)) - 1;
+	if (depth <= 0) return;
+	void **frames = captured + 1;
+
+	StateHash hash;
+	hash.add_bytes(frames, sizeof(void *) * size_t(depth));
+	if (hash.value == 0) hash.value = 1; //(0 marks an empty slot)
+
+	while (samples_lock.test_and_set(std::memory_order_acquire)) { }
+	uint32_t slot = uint32_t(hash.value % SampleSlots);
+	for (uint32_t probe = 0; probe < SampleSlots; ++probe) {
+		StackSample &s = samples[(slot + probe) % SampleSlots];
+		if (s.hash == 0) {
+			s.hash = hash.value;
+			s.depth = uint32_t(depth);
+			std::memcpy(s.frames, frames, sizeof(void *) * size_t(depth));
+		}
+		if (s.hash == hash.value && s.depth == uint32_t(depth) && std::memcmp(s.frames, frames, sizeof(void *) * size_t(depth)) == 0) {
+			s.count += 1;
+			s.bytes += bytes;
+			samples_lock.clear(std::memory_order_release);
+			return;
+		}
+	}
+	dropped_samples += 1;
+	samples_lock.clear(std::memory_order_release);
+#else
+	(void)bytes;
+#endif
+}
+
+void AllocationTracker::record(size_t bytes) {
+	if (in_hook) return;
+
+	total_allocations.fetch_add(1, std::memory_order_relaxed);
+	total_bytes.fetch_add(bytes, std::memory_order_relaxed);
+	scope_allocations[current_scope].fetch_add(1, std::memory_order_relaxed);
+	scope_bytes[current_scope].fetch_add(bytes, std::memory_order_relaxed);
+
+	uint32_t period = sample_period.load(std::memory_order_relaxed);
+	if (period != 0 && sample_counter.fetch_add(1, std::memory_order_relaxed) % period == 0) {
+		in_hook = true;
+		sample_stack(bytes);
+		in_hook = false;
+	}
+}
+
+void AllocationTracker::enable(uint32_t sample_period_) {
+	sample_period.store(sample_period_, std::memory_order_relaxed);
+	Frame discard;
+	end_frame(&discard); //(start the first frame from zero)
+	is_enabled.store(true, std::memory_order_relaxed);
+#ifndef ALLOCATION_TRACKER_BACKTRACE
+	if (sample_period_ != 0) {
+		std::cerr << "WARNING: allocation stacks can't be sampled on this platform (no backtrace())." << std::endl;
+	}
+#endif
+}
+
+void AllocationTracker::disable() {
+	is_enabled.store(false, std::memory_order_relaxed);
+}
+
+void AllocationTracker::end_frame(Frame *frame) {
+	frame->total.allocations = total_allocations.exchange(0, std::memory_order_relaxed);
+	frame->total.bytes = total_bytes.exchange(0, std::memory_order_relaxed);
+	for (uint32_t i = 0; i < MaxScopes; ++i) {
+		frame->scopes[i].allocations = scope_allocations[i].exchange(0, std::memory_order_relaxed);
+		frame->scopes[i].bytes = scope_bytes[i].exchange(0, std::memory_order_relaxed);
+	}
+}
+
+//----- scopes -----
+
+static std::mutex &names_mutex() {
+	static std::mutex mutex;
+	return mutex;
+}
+static std::vector< std::string > &names() {
+	static std::vector< std::string > names{ "(unscoped)" };
+	return names;
+}
+
+uint32_t AllocationTracker::scope_id(char const *name) {
+	std::lock_guard< std::mutex > lock(names_mutex());
+	std::vector< std::string > &list = names();
+	auto f = std::find(list.begin(), list.end(), std::string(name));
+	if (f != list.end()) return uint32_t(f - list.begin());
+	if (list.size() >= MaxScopes) {
+		std::cerr << "WARNING: more than " << MaxScopes << " allocation scopes; '" << name << "' counts as unscoped." << std::endl;
+		return 0;
+	}
+	list.emplace_back(name);
+	return uint32_t(list.size() - 1);
+}
+
+std::vector< std::string > AllocationTracker::scope_names() {
+	std::lock_guard< std::mutex > lock(names_mutex());
+	return names();
+}
+
+AllocationTracker::Scope::Scope(uint32_t id) : previous(current_scope) {
+	current_scope = id;
+}
+
+AllocationTracker::Scope::~Scope() {
+	current_scope = previous;
+}
+
+//----- report -----
+
+void AllocationTracker::print_top_stacks(std::ostream &out, uint32_t count) {
+#ifdef ALLOCATION_TRACKER_BACKTRACE
+	//copy the table (reserving first, so nothing allocates while the lock is held):
+	std::vector< StackSample > sampled;
+	sampled.reserve(SampleSlots);
+	uint64_t dropped;
+	while (samples_lock.test_and_set(std::memory_order_acquire)) { }
+	for (uint32_t i = 0; i < SampleSlots; ++i) {
+		if (samples[i].hash != 0) sampled.emplace_back(samples[i]);
+	}
+	dropped = dropped_samples;
+	samples_lock.clear(std::memory_order_release);
+
+	std::sort(sampled.begin(), sampled.end(), [](StackSample const &a, StackSample const &b) {
+		return a.count > b.count;
+	});
+	if (sampled.size() > count) sampled.resize(count);
+
+	uint32_t period = sample_period.load(std::memory_order_relaxed);
+	out << "  top allocation stacks (sampling 1 in " << period << " allocations";
+	if (dropped) out << "; " << dropped << " samples dropped, table full";
+	out << "):\n";
+
+	//name of the function in a backtrace_symbols() line (demangled if possible):
+	auto function_name = [](char const *symbol) -> std::string {
+		std::string line = symbol;
+		//glibc: "binary(mangled+0x12) [0x...]"; macOS: "3 binary 0x... mangled + 18":
+		size_t begin = line.find('(');
+		size_t end = line.find('+', begin);
+		if (begin == std::string::npos || end == std::string::npos) return line;
+		if (end == begin + 1) return line.substr(0, line.find(')') + 1); //(no symbol: "binary(+0x12)", for addr2line)
+		std::string mangled = line.substr(begin + 1, end - begin - 1);
+		int status = 0;
+		char *demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+		if (status != 0 || !demangled) return mangled;
+		std::string name = demangled;
+		std::free(demangled);
+		return name;
+	};
+
+	for (auto const &s : sampled) {
+		out << "    " << s.count << " samples, " << s.bytes << " bytes:\n";
+		char **symbols = backtrace_symbols(s.frames, int(s.depth));
+		std::vector< std::string > names;
+		for (uint32_t f = 0; f < s.depth; ++f) {
+			names.emplace_back(symbols ? function_name(symbols[f]) : std::string("?"));
+		}
+		//skip the tracker's own frames (through operator new; the compiler may have made unnamed copies of some):
+		uint32_t first = 0;
+		for (uint32_t f = 0; f < s.depth; ++f) {
+			if (names[f].find("AllocationTracker::") != std::string::npos || names[f].find("operator new") != std::string::npos) first = f + 1;
+		}
+		for (uint32_t f = first; f < s.depth; ++f) {
+			out << "      " << names[f] << " [" << s.frames[f] << "]\n";
+		}
+		std::free(symbols);
+	}
+#else
+	out << "  (allocation stacks can't be sampled on this platform)\n";
+	(void)count;
+#endif
+}
+
+//----- the hook -----
+
+void *AllocationTracker::allocate(size_t size) {
+	if (enabled()) record(size);
+	if (size == 0) size = 1;
+	while (true) {
+		void *ptr = std::malloc(size);
+		if (ptr) return ptr;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
+	}
+}
+
+static void *allocate_nothrow(size_t size) noexcept {
+	try {
+		return AllocationTracker::allocate(size);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void *operator new(size_t size) {
+	return AllocationTracker::allocate(size);
+}
+void *operator new[](size_t size) {
+	return AllocationTracker::allocate(size);
+}
+void *operator new(size_t size, std::nothrow_t const &) noexcept {
+	return allocate_nothrow(size);
+}
+void *operator new[](size_t size, std::nothrow_t const &) noexcept {
+	return allocate_nothrow(size);
+}
+void operator delete(void *ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete[](void *ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void *ptr, std::nothrow_t const &) noexcept {
+	std::free(ptr);
+}
+void operator delete[](void *ptr, std::nothrow_t const &) noexcept {
+	std::free(ptr);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+/*
+ * AllocationTracker counts heap allocations (every operator new, replaced globally in AllocationTracker.cpp)
+ * per frame and per scope, and samples the call stacks of some of them to find the worst offenders:
+ *
+ *   { //(2) update:
+ *       ALLOC_SCOPE("update"); //allocations on this thread count toward "update" until the end of the block
+ *       ...
+ *   }
+ *
+ * Tracking is off until AllocationTracker::enable() (main.cpp's --allocs or --alloc-budget);
+ * while off, operator new costs one relaxed atomic load more than malloc.
+ * Allocations from every thread count toward the frame; each one counts toward the innermost scope
+ * on its own thread (or "(unscoped)").
+ *
+ * Stacks are sampled (every sample_period'th allocation) with backtrace(), where available,
+ * into a fixed-size table, so sampling itself never allocates. Function names in the report
+ * need symbols exported to the dynamic table (-rdynamic); otherwise use addr2line on the addresses.
+ */
+
+struct AllocationTracker {
+	static const uint32_t MaxScopes = 16; //(scopes past this count toward "(unscoped)")
+
+	//start counting; sample one of every 'sample_period' allocations' stacks (0 => don't sample):
+	static void enable(uint32_t sample_period = 16);
+	static void disable();
+	static bool enabled() { return is_enabled.load(std::memory_order_relaxed); }
+
+	struct Counts {
+		uint64_t allocations = 0;
+		uint64_t bytes = 0;
+	};
+	//what was allocated since the previous end_frame() (in total and per scope id):
+	struct Frame {
+		Counts total;
+		Counts scopes[MaxScopes];
+	};
+	//called by the main loop at the end of each frame:
+	static void end_frame(Frame *frame);
+
+	//scope ids are handed out in order of first use; id 0 is "(unscoped)":
+	static uint32_t scope_id(char const *name);
+	static std::vector< std::string > scope_names();
+
+	//print the 'count' most frequently sampled allocation stacks:
+	static void print_top_stacks(std::ostream &out, uint32_t count);
+
+	//----- recording -----
+	struct Scope {
+		Scope(uint32_t id);
+		~Scope();
+		Scope(Scope const &) = delete;
+		Scope &operator=(Scope const &) = delete;
+
+		uint32_t previous;
+	};
+
+	//operator new (records, then mallocs):
+	static void *allocate(size_t bytes);
+	static void record(size_t bytes);
+	static void sample_stack(size_t bytes);
+
+	static std::atomic< bool > is_enabled;
+};
+
+#define ALLOC_CONCAT2(A, B) A ## B
+#define ALLOC_CONCAT(A, B) ALLOC_CONCAT2(A, B)
+
+//(the scope's id is looked up once per call site)
+#define ALLOC_SCOPE(NAME) \
+	static uint32_t const ALLOC_CONCAT(alloc_scope_id_, __LINE__) = AllocationTracker::scope_id(NAME); \
+	AllocationTracker::Scope ALLOC_CONCAT(alloc_scope_, __LINE__)(ALLOC_CONCAT(alloc_scope_id_, __LINE__))
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+//BallTrail remembers where a ball has been over the last 'length' seconds, for drawing trails:
+// samples live in a fixed-size ring with absolute timestamps (ages are computed when read),
+// so adding a sample and dropping old ones is O(1) per frame and never allocates.
+//At high frame rates samples closer together than 2 * length / Capacity are merged (the newest one moves),
+// so the ring covers the whole trail no matter how fast frames come.
+struct BallTrail {
+	static const uint32_t Capacity = 256; //(a power of two)
+	float length = 1.3f; //seconds of trail to keep
+
+	struct Sample {
+		glm::vec2 position;
+		double time;
+	};
+	Sample samples[Capacity];
+	uint32_t head = 0; //index of the oldest sample
+	uint32_t count = 0;
+	double now = 0.0; //time of the latest add() (seconds)
+
+	//i'th oldest sample (0 <= i < count):
+	Sample const &operator[](uint32_t i) const { return samples[(head + i) & (Capacity - 1)]; }
+	float age(uint32_t i) const { return float(now - (*this)[i].time); }
+
+	//where the ball was 'age' seconds ago, interpolated between the samples around it
+	// (the same lookup TrailProgram's vertex shader does); false if there aren't two samples:
+	bool position_at(float age_, glm::vec2 *position) const {
+		if (count < 2) return false;
+		//first sample after the oldest that is no older than age_ (ages decrease from oldest to newest):
+		uint32_t lo = 1, hi = count;
+		while (lo < hi) {
+			uint32_t mid = (lo + hi) / 2;
+			if (age(mid) > age_) lo = mid + 1;
+			else hi = mid;
+		}
+		if (lo == count) return false;
+		float a_age = age(lo - 1);
+		float b_age = age(lo);
+		glm::vec2 a = (*this)[lo - 1].position;
+		glm::vec2 b = (*this)[lo].position;
+		*position = (b_age == a_age ? b : (age_ - a_age) / (b_age - a_age) * (b - a) + a);
+		return true;
+	}
+
+	//forget everything, as if the ball has been at 'at' forever:
+	void reset(glm::vec2 const &at) {
+		head = 0;
+		count = 2;
+		samples[0].position = at;
+		samples[0].time = now - length;
+		samples[1].position = at;
+		samples[1].time = now;
+	}
+
+	//'elapsed' seconds have passed and the ball is now at 'at':
+	void add(float elapsed, glm::vec2 const &at) {
+		now += elapsed;
+		double min_spacing = 2.0 * length / Capacity;
+		if (count >= 2 && now - (*this)[count - 2].time < min_spacing) {
+			//(merge into the newest sample)
+			Sample &newest = samples[(head + count - 1) & (Capacity - 1)];
+			newest.position = at;
+			newest.time = now;
+		} else {
+			if (count == Capacity) {
+				head = (head + 1) & (Capacity - 1);
+				count -= 1;
+			}
+			Sample &s = samples[(head + count) & (Capacity - 1)];
+			s.position = at;
+			s.time = now;
+			count += 1;
+		}
+		//drop samples that are too old:
+		//NOTE: since trail drawing interpolates between samples, only drops the oldest if the next-oldest is too old:
+		while (count >= 2 && age(1) > length) {
+			head = (head + 1) & (Capacity - 1);
+			count -= 1;
+		}
+	}
+};
+
+//colors of the trail's segments, from newest (just behind the ball) to oldest:
+// (some nice colors from the course web page)
+inline std::vector< glm::u8vec4 > const &rainbow_colors() {
+	#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
+	static const std::vector< glm::u8vec4 > colors = {
+		HEX_TO_U8VEC4(0xe2ff70ff), HEX_TO_U8VEC4(0xcbff70ff), HEX_TO_U8VEC4(0xaeff5dff),
+		HEX_TO_U8VEC4(0x88ff52ff), HEX_TO_U8VEC4(0x6cff47ff), HEX_TO_U8VEC4(0x3aff37ff),
+		HEX_TO_U8VEC4(0x2eff94ff), HEX_TO_U8VEC4(0x2effa5ff), HEX_TO_U8VEC4(0x17ffc1ff),
+		HEX_TO_U8VEC4(0x00f4e7ff), HEX_TO_U8VEC4(0x00cbe4ff), HEX_TO_U8VEC4(0x00b0d8ff),
+		HEX_TO_U8VEC4(0x00a5d1ff), HEX_TO_U8VEC4(0x0098cfd8), HEX_TO_U8VEC4(0x0098cf54),
+		HEX_TO_U8VEC4(0x0098cf54), HEX_TO_U8VEC4(0x0098cf54), HEX_TO_U8VEC4(0x0098cf54),
+		HEX_TO_U8VEC4(0x0098cf54), HEX_TO_U8VEC4(0x0098cf54), HEX_TO_U8VEC4(0x0098cf54),
+		HEX_TO_U8VEC4(0x0098cf54)
+	};
+	#undef HEX_TO_U8VEC4
+	return colors;
+}
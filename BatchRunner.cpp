@@ -0,0 +1,216 @@
+#include "BatchRunner.hpp"
+
+#include "BreakoutGame.hpp"
+#include "BreakoutLanes.hpp"
+#include "ThreadPool.hpp"
+#include "percentile.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+
+//how one game ended:
+struct GameOutcome {
+	bool cleared = false;
+	float seconds = 0.0f; //simulated time played
+	uint32_t frames = 0;
+	int score = 0;
+	int misses = 0;
+	uint64_t state_hash = 0; //final state (for checking reproducibility)
+};
+
+//play games first .. first+LANES-1 (or up to options.games) as lanes of a BreakoutLanes:
+// (with options.validate, check each lane against a BreakoutGame; returns the number of games that diverged)
+template< uint32_t LANES >
+static uint32_t play_lanes(BatchOptions const &options, BreakoutGame const &start, uint32_t max_frames, uint32_t first, std::vector< GameOutcome > *outcomes_, std::ostream &out, std::mutex &out_mutex) {
+	std::vector< GameOutcome > &outcomes = *outcomes_;
+	uint32_t count = std::min(LANES, options.games - first);
+
+	BreakoutLanes< LANES > lanes(start);
+	for (uint32_t l = 0; l < LANES; ++l) {
+		lanes.seed(l, options.seed + first + l);
+	}
+
+	std::vector< BreakoutGame > reference;
+	if (options.validate) {
+		for (uint32_t l = 0; l < count; ++l) {
+			reference.emplace_back(start);
+			reference.back().seed(options.seed + first + l);
+			reference.back().swept = false; //(lanes play the discrete rules)
+		}
+	}
+
+	//record how the game in lane l ended:
+	auto finish = [&](uint32_t l) {
+		GameOutcome &outcome = outcomes[first + l];
+		outcome.cleared = (lanes.bricks_left[l] == 0);
+		outcome.seconds = outcome.frames * options.step;
+		outcome.score = lanes.score[l];
+		outcome.misses = lanes.misses[l];
+		outcome.state_hash = lanes.state_hash(l);
+	};
+
+	uint32_t diverged = 0;
+	std::vector< bool > done(count, false);
+	uint32_t playing = 0;
+	for (uint32_t l = 0; l < count; ++l) {
+		if (lanes.bricks_left[l] == 0) {
+			finish(l);
+			done[l] = true;
+		} else {
+			playing += 1;
+		}
+	}
+	//(lanes that finish early keep stepping along with the others, but their outcome is recorded when they finish)
+	for (uint32_t frame = 0; playing > 0 && frame < max_frames; ++frame) {
+		lanes.update(options.step);
+		for (uint32_t l = 0; l < count; ++l) {
+			if (done[l]) continue;
+			outcomes[first + l].frames += 1;
+			if (options.validate) {
+				reference[l].update(options.step);
+				if (reference[l].state_hash() != lanes.state_hash(l)) {
+					std::unique_lock< std::mutex > lock(out_mutex);
+					out << "  game " << (first + l) << ": lane " << l << " of " << LANES << " diverged from BreakoutGame at frame " << frame << ".\n";
+					diverged += 1;
+					finish(l);
+					done[l] = true;
+					playing -= 1;
+					continue;
+				}
+			}
+			if (lanes.bricks_left[l] == 0) {
+				finish(l);
+				done[l] = true;
+				playing -= 1;
+			}
+		}
+	}
+	for (uint32_t l = 0; l < count; ++l) {
+		if (!done[l]) finish(l);
+	}
+	return diverged;
+}
+
+bool run_batch(BatchOptions const &options, std::ostream &out) {
+	if (options.lanes != 0 && options.lanes != 8 && options.lanes != 16) {
+		throw std::runtime_error("Batches can use 8 or 16 lanes (not " + std::to_string(options.lanes) + ").");
+	}
+	if (options.validate && options.lanes == 0) {
+		throw std::runtime_error("Validation compares lanes against BreakoutGame, so it needs lanes (8 or 16).");
+	}
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	//every game starts from a copy of this one:
+	BreakoutGame start;
+	start.load_level(*BreakoutGame::open_level(options.level_file));
+	start.autopilot = true;
+	start.swept = false; //(lanes play the discrete rules, so BreakoutGames do too)
+
+	std::vector< GameOutcome > outcomes(options.games);
+	uint32_t max_frames = uint32_t(std::ceil(options.max_seconds / options.step));
+
+	ThreadPool pool(options.threads);
+
+	std::atomic< uint32_t > diverged(0);
+	std::mutex out_mutex;
+
+	auto before = Clock::now();
+	if (options.lanes != 0) {
+		//one job per group of lanes:
+		for (uint32_t first = 0; first < options.games; first += options.lanes) {
+			pool.submit([&options, &start, &outcomes, &out, &out_mutex, &diverged, max_frames, first]() {
+				if (options.lanes == 8) diverged += play_lanes< 8 >(options, start, max_frames, first, &outcomes, out, out_mutex);
+				else diverged += play_lanes< 16 >(options, start, max_frames, first, &outcomes, out, out_mutex);
+			});
+		}
+	} else {
+		//one job per game:
+		for (uint32_t index = 0; index < options.games; ++index) {
+			pool.submit([&options, &start, &outcomes, max_frames, index]() {
+				BreakoutGame game = start;
+				game.seed(options.seed + index);
+
+				GameOutcome &outcome = outcomes[index];
+				while (!game.bricks.empty() && outcome.frames < max_frames) {
+					game.update(options.step);
+					outcome.frames += 1;
+				}
+				outcome.cleared = game.bricks.empty();
+				outcome.seconds = outcome.frames * options.step;
+				outcome.score = game.score;
+				outcome.misses = game.misses;
+				outcome.state_hash = game.state_hash();
+			});
+		}
+	}
+	pool.wait();
+	auto after = Clock::now();
+
+	double wall = std::chrono::duration< double >(after - before).count();
+
+	//----- summary -----
+	uint32_t cleared = 0;
+	uint64_t frames = 0;
+	std::vector< float > clear_seconds, scores, misses;
+	for (auto const &outcome : outcomes) {
+		frames += outcome.frames;
+		if (outcome.cleared) {
+			cleared += 1;
+			clear_seconds.emplace_back(outcome.seconds);
+		}
+		scores.emplace_back(float(outcome.score));
+		misses.emplace_back(float(outcome.misses));
+	}
+	std::sort(clear_seconds.begin(), clear_seconds.end());
+	std::sort(scores.begin(), scores.end());
+	std::sort(misses.begin(), misses.end());
+
+	auto stats = [&out](std::vector< float > const &sorted) {
+		double sum = 0.0;
+		for (float v : sorted) sum += v;
+		out << "mean " << (sorted.empty() ? 0.0 : sum / sorted.size())
+			<< ", p5 " << percentile(sorted, 0.05f)
+			<< ", p50 " << percentile(sorted, 0.5f)
+			<< ", p95 " << percentile(sorted, 0.95f);
+	};
+
+	out << "Played " << options.games << " games (" << start.bricks.size() << " bricks each) on " << pool.size() << " threads";
+	if (options.lanes) out << " (" << options.lanes << " lanes per job)";
+	out << " in " << wall << "s:\n";
+	out << "  " << (options.games / wall) << " games/sec; " << (frames / wall) << " frames/sec.\n";
+	out << "  cleared: " << cleared << " of " << options.games << " (within " << options.max_seconds << "s of play)\n";
+	if (!clear_seconds.empty()) {
+		out << "  time to clear (s): "; stats(clear_seconds); out << "\n";
+	}
+	out << "  bricks broken: "; stats(scores); out << "\n";
+	out << "  misses: "; stats(misses); out << "\n";
+	out.flush();
+
+	if (options.csv_file != "") {
+		std::ofstream csv(options.csv_file);
+		if (!csv) throw std::runtime_error("Failed to open '" + options.csv_file + "' for writing batch results.");
+		csv << "game,seed,cleared,seconds,frames,score,misses,state_hash\n";
+		for (uint32_t index = 0; index < outcomes.size(); ++index) {
+			GameOutcome const &outcome = outcomes[index];
+			csv << index << "," << (options.seed + index) << "," << (outcome.cleared ? 1 : 0) << "," << outcome.seconds << ","
+				<< outcome.frames << "," << outcome.score << "," << outcome.misses << "," << std::hex << outcome.state_hash << std::dec << "\n";
+		}
+		out << "Wrote per-game results to '" << options.csv_file << "'." << std::endl;
+	}
+
+	if (options.validate) {
+		if (diverged == 0) {
+			out << "Validation: all " << options.games << " games matched BreakoutGame bit-for-bit (state hash every frame)." << std::endl;
+		} else {
+			out << "Validation: " << diverged << " of " << options.games << " games diverged from BreakoutGame." << std::endl;
+		}
+	}
+	return diverged == 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <cstdint>
+
+/*
+ * The batch runner plays many automated Breakout games (BreakoutGame with autopilot)
+ * on a ThreadPool -- e.g., for level tuning -- and reports throughput (games/sec)
+ * and per-game outcomes (cleared or not, time to clear, bricks broken, misses).
+ *
+ * Every game gets its own seed (options.seed + game index), so results are the same
+ * no matter how many threads run them -- or whether they run as BreakoutGames or
+ * as lanes of a BreakoutLanes (options.lanes).
+ * Games play the discrete rules (BreakoutGame::swept off), since that is what lanes play;
+ * they are not the swept games BreakoutMode plays, so outcomes differ from the interactive game's.
+ */
+
+struct BatchOptions {
+	uint32_t games = 1000;
+	uint32_t threads = 0; //0 => one per hardware thread
+	uint32_t seed = 0;
+	std::string level_file = ""; //(empty => built-in level)
+	float step = 1.0f / 60.0f; //simulation time step (seconds)
+	float max_seconds = 300.0f; //simulated time after which a game counts as not cleared
+	std::string csv_file = ""; //if set, write one line per game here
+
+	//if 8 or 16, each job steps that many games at once with BreakoutLanes:
+	uint32_t lanes = 0;
+	//(with lanes) also step every game with BreakoutGame, and check that their state hashes match every frame:
+	bool validate = false;
+};
+
+//run the batch and print a summary to 'out':
+// returns false if validation found any mismatch
+bool run_batch(BatchOptions const &options, std::ostream &out);
@@ -0,0 +1,147 @@
+#include "Benchmark.hpp"
+
+#include "PerfCounters.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <cmath>
+#include <cstring>
+
+Benchmark::Benchmark(std::string const &json_file_) : json_file(json_file_) {
+}
+
+void Benchmark::frame(float update, float draw, float frame) {
+	update_ms.values.emplace_back(update * 1000.0f);
+	draw_ms.values.emplace_back(draw * 1000.0f);
+	frame_ms.values.emplace_back(frame * 1000.0f);
+	total_seconds += frame;
+}
+
+void Benchmark::allocations(AllocationTracker::Frame const &frame) {
+	if (allocations_per_frame.values.size() >= warmup_frames) {
+		steady_frames += 1;
+		steady_allocations += frame.total.allocations;
+		for (uint32_t i = 0; i < AllocationTracker::MaxScopes; ++i) {
+			steady_scope_allocations[i] += frame.scopes[i].allocations;
+		}
+	}
+	allocations_per_frame.values.emplace_back(float(frame.total.allocations));
+	bytes_per_frame.values.emplace_back(float(frame.total.bytes));
+}
+
+bool Benchmark::finish(std::ostream &out, std::vector< std::pair< std::string, std::string > > const &settings) {
+	size_t frames = frame_ms.values.size();
+	double fps = (total_seconds > 0.0 ? frames / total_seconds : 0.0);
+
+	bool tracked = !allocations_per_frame.values.empty();
+	double steady_mean = (steady_frames ? double(steady_allocations) / double(steady_frames) : 0.0);
+	bool over_budget = (tracked && allocation_budget >= 0.0f && steady_mean > allocation_budget);
+	std::vector< std::string > scope_names;
+	if (tracked) scope_names = AllocationTracker::scope_names();
+
+	//(sorts the samples, so percentiles below are valid)
+	std::ofstream json(json_file);
+	if (!json) throw std::runtime_error("Failed to open '" + json_file + "' for writing benchmark results.");
+	json << "{\n";
+	json << "\t\"benchmark\": \"frame-times\",\n";
+	for (auto const &setting : settings) {
+		json << "\t\"" << setting.first << "\": " << setting.second << ",\n";
+	}
+	json << "\t\"frames\": " << frames << ",\n";
+	json << "\t\"seconds\": " << total_seconds << ",\n";
+	json << "\t\"fps\": " << fps << ",\n";
+	json << "\t\"update_ms\": "; update_ms.write_json(json); json << ",\n";
+	json << "\t\"draw_ms\": "; draw_ms.write_json(json); json << ",\n";
+	json << "\t\"frame_ms\": "; frame_ms.write_json(json);
+	if (PerfCounters::enabled()) {
+		json << ",\n\t\"perf_counters\": "; PerfCounters::write_json(json);
+	}
+	if (tracked) {
+		json << ",\n\t\"allocations_per_frame\": "; allocations_per_frame.write_json(json);
+		json << ",\n\t\"bytes_per_frame\": "; bytes_per_frame.write_json(json);
+		json << ",\n\t\"steady_allocations_per_frame\": " << steady_mean;
+		json << ",\n\t\"steady_allocations_per_frame_by_scope\": {";
+		for (uint32_t i = 0; i < scope_names.size() && i < AllocationTracker::MaxScopes; ++i) {
+			json << (i ? ", " : "") << "\"" << scope_names[i] << "\": " << (steady_frames ? double(steady_scope_allocations[i]) / double(steady_frames) : 0.0);
+		}
+		json << "}";
+		if (allocation_budget >= 0.0f) {
+			json << ",\n\t\"allocation_budget\": " << allocation_budget;
+			json << ",\n\t\"passed\": " << (over_budget ? "false" : "true");
+		}
+	}
+	json << "\n";
+	json << "}\n";
+
+	auto line = [&out](char const *name, Samples const &samples) {
+		std::vector< float > const &sorted = samples.values;
+		out << "  " << name << ": p50 " << percentile(sorted, 0.5f)
+			<< ", p95 " << percentile(sorted, 0.95f)
+			<< ", p99 " << percentile(sorted, 0.99f)
+			<< ", max " << (sorted.empty() ? 0.0f : sorted.back()) << "\n";
+	};
+	out << "Benchmark: " << frames << " frames in " << total_seconds << "s (" << fps << " frames/sec):\n";
+	line("update ms", update_ms);
+	line("draw ms", draw_ms);
+	line("frame ms", frame_ms);
+	if (PerfCounters::enabled()) PerfCounters::print_summary(out);
+	if (tracked) {
+		line("allocations/frame", allocations_per_frame);
+		out << "  steady state (after " << warmup_frames << " frames): " << steady_mean << " allocations/frame";
+		for (uint32_t i = 0; i < scope_names.size() && i < AllocationTracker::MaxScopes; ++i) {
+			if (steady_scope_allocations[i] == 0) continue;
+			out << ", " << scope_names[i] << " " << double(steady_scope_allocations[i]) / double(steady_frames);
+		}
+		out << "\n";
+		AllocationTracker::print_top_stacks(out, 5);
+		if (allocation_budget >= 0.0f) {
+			out << "  allocation budget " << allocation_budget << "/frame: " << (over_budget ? "FAILED" : "passed") << "\n";
+		}
+	}
+	out << "Wrote benchmark results to '" << json_file << "'." << std::endl;
+
+	return !over_budget;
+}
+
+void scripted_input(uint32_t frame, glm::uvec2 const &window_size, std::vector< SDL_Event > *events) {
+	events->clear();
+
+	float t = frame / 60.0f;
+	SDL_Event motion;
+	std::memset(&motion, 0, sizeof(motion));
+	motion.type = SDL_MOUSEMOTION;
+	motion.motion.timestamp = SDL_GetTicks();
+	motion.motion.x = int32_t((0.5f + 0.45f * std::sin(t * 1.3f)) * window_size.x);
+	motion.motion.y = int32_t((0.5f + 0.45f * std::sin(t * 2.6f)) * window_size.y);
+	events->emplace_back(motion);
+
+	if (frame % 60 == 30) {
+		SDL_Event button;
+		std::memset(&button, 0, sizeof(button));
+		button.type = SDL_MOUSEBUTTONDOWN;
+		button.button.timestamp = motion.motion.timestamp;
+		button.button.button = SDL_BUTTON_LEFT;
+		button.button.state = SDL_PRESSED;
+		button.button.clicks = 1;
+		button.button.x = motion.motion.x;
+		button.button.y = motion.motion.y;
+		events->emplace_back(button);
+		button.type = SDL_MOUSEBUTTONUP;
+		button.button.state = SDL_RELEASED;
+		events->emplace_back(button);
+	}
+
+	if (frame % 90 == 45) {
+		SDL_Event key;
+		std::memset(&key, 0, sizeof(key));
+		key.type = SDL_KEYDOWN;
+		key.key.timestamp = motion.motion.timestamp;
+		key.key.state = SDL_PRESSED;
+		key.key.keysym.scancode = SDL_SCANCODE_SPACE;
+		key.key.keysym.sym = SDLK_SPACE;
+		events->emplace_back(key);
+		key.type = SDL_KEYUP;
+		key.key.state = SDL_RELEASED;
+		events->emplace_back(key);
+	}
+}
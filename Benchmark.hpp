@@ -0,0 +1,57 @@
+#pragma once
+
+#include "percentile.hpp"
+#include "AllocationTracker.hpp"
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+/*
+ * Benchmark collects per-frame CPU times from the main loop (--bench):
+ *   update (Mode::update_stack), draw (Mode::draw_stack), and the whole frame (including the swap, or glFinish when headless),
+ * and, at the end of the run, prints average FPS and p50/p95/p99/max of each
+ * and writes the same summary as JSON.
+ * With PerfCounters enabled (--perf-counters), the summary also lists each counted scope's IPC and miss rates.
+ * With AllocationTracker enabled (--allocs), it also lists heap allocations per frame (in total, per scope,
+ * and the most-sampled stacks), and the run fails if steady-state allocations exceed 'allocation_budget'.
+ *
+ * For repeatable runs the main loop steps modes with a fixed elapsed time while benchmarking,
+ * and takes its input from a replay (--replay) or from scripted_input (--scripted-input).
+ */
+
+struct Benchmark {
+	Benchmark(std::string const &json_file);
+
+	//record one frame (times in seconds):
+	void frame(float update, float draw, float frame);
+
+	//record one frame's allocations (with AllocationTracker enabled):
+	void allocations(AllocationTracker::Frame const &frame);
+
+	//print a summary to 'out' and write the JSON file:
+	// 'settings' are extra "key": value pairs (already JSON-formatted values) describing the run
+	//returns false if the run went over the allocation budget:
+	bool finish(std::ostream &out, std::vector< std::pair< std::string, std::string > > const &settings);
+
+	std::string json_file;
+	Samples update_ms, draw_ms, frame_ms;
+	double total_seconds = 0.0;
+
+	//allocations per frame, and per-scope totals over steady-state frames (those after 'warmup_frames'):
+	Samples allocations_per_frame, bytes_per_frame;
+	uint32_t warmup_frames = 60;
+	uint64_t steady_frames = 0, steady_allocations = 0;
+	uint64_t steady_scope_allocations[AllocationTracker::MaxScopes] = {0};
+	float allocation_budget = -1.0f; //if >= 0, fail if steady-state allocations per frame (mean) exceed this
+};
+
+//deterministic input for frame 'frame' of a benchmark in a window of 'window_size':
+// the mouse traces a slow figure-eight over the window, the left button clicks once a second,
+// and space is pressed every second and a half (at 60 frames/sec):
+void scripted_input(uint32_t frame, glm::uvec2 const &window_size, std::vector< SDL_Event > *events);
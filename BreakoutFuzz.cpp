@@ -0,0 +1,119 @@
+#include "BreakoutFuzz.hpp"
+
+#include "BreakoutGame.hpp"
+#include "Level.hpp"
+
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+//does the path from 'from' by 'delta' pass through a box of radius 'reach' around 'center'?
+// (plain slab test; 'reach' is already shrunk by the margin)
+static bool path_crosses(glm::vec2 const &from, glm::vec2 const &delta, glm::vec2 const &center, glm::vec2 const &reach) {
+	float enter = 0.0f, leave = 1.0f;
+	for (uint32_t k = 0; k < 2; ++k) {
+		float lo = center[k] - reach[k] - from[k];
+		float hi = center[k] + reach[k] - from[k];
+		if (delta[k] == 0.0f) {
+			if (lo >= 0.0f || hi <= 0.0f) return false;
+			continue;
+		}
+		float t0 = lo / delta[k], t1 = hi / delta[k];
+		if (t0 > t1) std::swap(t0, t1);
+		enter = std::max(enter, t0);
+		leave = std::min(leave, t1);
+		if (enter >= leave) return false;
+	}
+	return true;
+}
+
+bool run_breakout_fuzz(BreakoutFuzzOptions const &options, std::ostream &out) {
+	std::mt19937 mt(options.seed);
+	std::uniform_real_distribution< float > unit(0.0f, 1.0f);
+	LevelGenOptions::Pattern const patterns[] = {
+		LevelGenOptions::Solid, LevelGenOptions::Checker, LevelGenOptions::Stripes, LevelGenOptions::Diamond, LevelGenOptions::Clusters
+	};
+
+	uint32_t inside = 0, tunneled = 0, straight = 0, levels = 0;
+	BreakoutGame game;
+	for (uint32_t frame = 0; frame < options.frames; ++frame) {
+		//----- a fresh level now and then -----
+		if (frame % options.frames_per_level == 0) {
+			LevelGenOptions gen;
+			gen.seed = mt();
+			gen.brick_count = 50 + mt() % (std::max(options.max_bricks, 51u) - 49);
+			gen.density = 0.5f + 0.5f * unit(mt);
+			gen.pattern = patterns[mt() % 5];
+			gen.aspect = 13.0f / 6.0f;
+			gen.field_radius = glm::vec2(6.5f, 3.0f);
+			for (uint32_t c = 0; c < BreakoutGame::COLOR_COUNT; ++c) {
+				gen.colors.emplace_back(BreakoutGame::COLORS[c].first);
+			}
+			Level level(generate_level(gen).serialize(), "generated level");
+
+			game = BreakoutGame();
+			game.swept = true;
+			game.autopilot = true;
+			game.seed(mt());
+			game.load_level(level);
+			++levels;
+		}
+
+		//----- random speed and frame time -----
+		if (!game.ball_reset && game.ball_velocity != glm::vec2(0.0f)) {
+			float speed = 6.0f + (options.max_speed - 6.0f) * unit(mt) * unit(mt);
+			game.ball_velocity = speed * glm::normalize(game.ball_velocity);
+		}
+		float elapsed = (unit(mt) < 0.1f ? 0.1f : 1.0f / 60.0f) * (0.5f + unit(mt));
+
+		glm::vec2 start = game.ball;
+		glm::vec2 velocity = game.ball_velocity;
+		uint32_t color = game.ball_color;
+		bool was_reset = game.ball_reset;
+
+		game.update(elapsed);
+
+		glm::vec2 reach = game.brick_radius + game.ball_radius - glm::vec2(options.margin);
+		auto solid = [](BreakoutGame::Brick const &b, uint32_t ball_color) {
+			return BreakoutGame::COLORS[ball_color].second != b.Color;
+		};
+
+		//----- the ball ends outside every brick it can't pass through -----
+		for (BreakoutGame::Brick const &b : game.bricks) {
+			if (!solid(b, game.ball_color)) continue;
+			glm::vec2 offset = glm::abs(game.ball - b.Position);
+			if (offset.x < reach.x && offset.y < reach.y) {
+				if (inside < 10) {
+					out << "  frame " << frame << ": ball ended at (" << game.ball.x << ", " << game.ball.y << ") inside the brick at ("
+						<< b.Position.x << ", " << b.Position.y << ").\n";
+				}
+				++inside;
+				break;
+			}
+		}
+
+		//----- a ball that went straight didn't go through a brick -----
+		glm::vec2 delta = elapsed * velocity;
+		if (was_reset || game.ball_reset || !game.broken.empty() || game.ball_velocity != velocity || game.ball_color != color) continue;
+		if (glm::length(game.ball - (start + delta)) > 1e-4f * (1.0f + glm::length(delta))) continue;
+		++straight;
+		for (BreakoutGame::Brick const &b : game.bricks) {
+			if (!solid(b, color)) continue;
+			if (path_crosses(start, delta, b.Position, reach)) {
+				if (tunneled < 10) {
+					out << "  frame " << frame << ": ball went from (" << start.x << ", " << start.y << ") to (" << game.ball.x << ", " << game.ball.y
+						<< ") straight through the brick at (" << b.Position.x << ", " << b.Position.y << ").\n";
+				}
+				++tunneled;
+				break;
+			}
+		}
+	}
+
+	bool passed = (inside == 0 && tunneled == 0);
+	out << "Breakout fuzz: " << options.frames << " swept steps on " << levels << " levels (" << straight << " without a bounce); "
+		<< inside << " ended inside a brick, " << tunneled << " passed through one.\n";
+	out << "  " << (passed ? "PASS" : "FAIL") << "\n";
+	out.flush();
+	return passed;
+}
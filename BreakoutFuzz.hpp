@@ -0,0 +1,28 @@
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+
+/*
+ * The Breakout fuzz test plays swept-collision games (BreakoutGame::swept, as BreakoutMode plays)
+ * on random generated levels, at random ball speeds and frame times, and checks every step:
+ *  - the ball never ends a step inside a live brick it can't pass through;
+ *  - a ball that went straight through a step (no bounce, no broken brick, no miss) didn't pass
+ *    through a live brick it can't pass through (its path is tested against every brick).
+ * (Grazes closer than 'margin' are too close to call and aren't counted.)
+ * One ball only: with multi-ball, balls push each other (and so, sometimes, into bricks) after the sweep.
+ *
+ * Needs no window (main.cpp runs this with --fuzz-breakout).
+ */
+
+struct BreakoutFuzzOptions {
+	uint32_t frames = 100000;
+	uint32_t frames_per_level = 2000; //a new level (and game) after this many frames
+	uint32_t seed = 0;
+	uint32_t max_bricks = 3000; //levels get between 50 and this many bricks
+	float max_speed = 200.0f; //court units per second (the base speed is 6)
+	float margin = 1e-3f;
+};
+
+//returns false if any step breaks the rules above:
+bool run_breakout_fuzz(BreakoutFuzzOptions const &options, std::ostream &out);
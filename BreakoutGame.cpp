@@ -0,0 +1,837 @@
+#include "BreakoutGame.hpp"
+
+//for state_hash():
+#include "StateHash.hpp"
+
+//for splitting multi-ball contact detection across threads:
+#include "ThreadPool.hpp"
+
+//for swept collisions:
+#include "sweep_box.hpp"
+
+//for TRACE_SCOPE() and PERF_SCOPE():
+#include "Trace.hpp"
+#include "PerfCounters.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <math.h>
+#include <cmath>
+
+const color_t BreakoutGame::RED    = FROM_HEX(0xec3160);
+const color_t BreakoutGame::YELLOW = FROM_HEX(0xf3f439);
+const color_t BreakoutGame::BLUE   = FROM_HEX(0x1c8bc0);
+const color_t BreakoutGame::GREEN  = FROM_HEX(0x12b65f);
+const color_t BreakoutGame::PURPLE = FROM_HEX(0xce5bf6);
+const color_t BreakoutGame::ORANGE = FROM_HEX(0xf48f12);
+
+// complementary colors:
+const color_pair BreakoutGame::COLORS[BreakoutGame::COLOR_COUNT] = {
+	std::make_pair(RED, GREEN),
+	std::make_pair(YELLOW, PURPLE),
+	std::make_pair(BLUE, ORANGE),
+	std::make_pair(GREEN, RED),
+	std::make_pair(PURPLE, YELLOW),
+	std::make_pair(ORANGE, BLUE),
+};
+
+// the built-in level (see level_from_text in Level.hpp for the format):
+// six rows of bricks with a 2x3 hole in the middle
+const char *BreakoutGame::default_level =
+	"R=ec3160\n" "Y=f3f439\n" "B=1c8bc0\n" "G=12b65f\n" "P=ce5bf6\n" "O=f48f12\n"
+	"PPPPPPP\n"
+	"YYYYYYY\n"
+	"RR...RR\n"
+	"GG...GG\n"
+	"OOOOOOO\n"
+	"BBBBBBB\n"
+;
+
+BreakoutGame::BreakoutGame() {
+}
+
+std::unique_ptr< Level > BreakoutGame::open_level(std::string const &level_file) {
+	if (level_file.empty()) {
+		std::istringstream text(default_level);
+		return std::unique_ptr< Level >(new Level(level_from_text(text, LevelGridOptions(), "default level").serialize(), "default level"));
+	} else {
+		return std::unique_ptr< Level >(new Level(level_file));
+	}
+}
+
+void BreakoutGame::load_level(Level const &level) {
+	court_radius = level.court_radius;
+	brick_radius = level.brick_radius;
+	paddle = glm::vec2(0.0f, -court_radius.y + 0.5f);
+
+	extra_balls.clear();
+	brick_order.clear();
+	brick_columns.clear();
+	brick_grid.clear();
+
+	bricks.clear();
+	bricks.reserve(level.brick_count);
+	for (uint32_t i = 0; i < level.brick_count; ++i) {
+		LevelBrick const &b = level.bricks[i];
+		bricks.emplace_back(b.position, level.palette[b.color]);
+	}
+}
+
+void BreakoutGame::launch() {
+	if (ball_reset) {
+		ball_reset = false;
+		ball_velocity = glm::vec2(0.0f, 6.0f);
+	}
+}
+
+void BreakoutGame::cycle_paddle_color() {
+	paddle_color = (paddle_color + 1) % COLOR_COUNT;
+}
+
+void BreakoutGame::update(float elapsed) {
+	TRACE_SCOPE("BreakoutGame::update");
+	PERF_SCOPE("BreakoutGame::update");
+
+	if (autopilot) { //steer toward the ball, with a (randomly-chosen) offset:
+		ai_offset_update -= elapsed;
+		if (ai_offset_update < elapsed) {
+			//update again in [0.5,1.0) seconds:
+			ai_offset_update = (mt() / float(mt.max())) * 0.5f + 0.5f;
+			ai_offset = (mt() / float(mt.max())) * 1.6f - 0.8f;
+			//switch to the color of some remaining brick:
+			if (!bricks.empty()) {
+				color_t want = bricks[mt() % bricks.size()].Color;
+				for (uint32_t c = 0; c < COLOR_COUNT; ++c) {
+					if (COLORS[c].first == want) paddle_color = c;
+				}
+			}
+		}
+		float target = ball.x + ai_offset;
+		if (paddle.x < target) {
+			paddle.x = std::min(target, paddle.x + ai_speed * elapsed);
+		} else {
+			paddle.x = std::max(target, paddle.x - ai_speed * elapsed);
+		}
+	}
+	bool was_reset = ball_reset;
+
+	broken.clear();
+
+	//----- paddle update -----
+
+	paddle.x = std::max(paddle.x, -court_radius.x + paddle_radius.x);
+	paddle.x = std::min(paddle.x,  court_radius.x - paddle_radius.x);
+
+	//----- ball update -----
+
+	//(a swept ball moves as part of collision handling)
+	if (ball_reset) {
+		ball = paddle + glm::vec2(0.0f, ball_radius.y);
+	} else if (!swept) {
+		ball += elapsed * ball_velocity;
+	}
+
+
+	//---- collision handling ----
+
+	if (!extra_balls.empty()) {
+		update_multi_ball(elapsed);
+	} else if (swept && !ball_reset) {
+		if (sweep_ball(&ball, &ball_velocity, &ball_color, elapsed)) {
+			ball_velocity = glm::vec2(0.0f, 0.0f);
+			ball_reset = true;
+			misses++;
+		}
+		if (!broken.empty()) remove_dead_bricks();
+	} else {
+		//one ball (the original, discrete, rules):
+
+		//paddles:
+		paddle_vs_ball(&ball, &ball_velocity, &ball_color);
+
+		{ //bricks:
+			TRACE_SCOPE("ball vs bricks");
+			PERF_SCOPE("ball vs bricks");
+			for (size_t i = 0; i < bricks.size(); i++) {
+				Brick const &b = bricks[i];
+				// ball passes through bricks of complementary color
+				if (!ball_hits_brick(ball, ball_color, b)) continue;
+				bounce_off_brick(&ball, &ball_velocity, b);
+
+				if (COLORS[ball_color].first == b.Color) {
+					// break brick
+					broken.emplace_back(b);
+					bricks.erase(bricks.begin() + i);
+					score++;
+				}
+				// can't hit more than one brick per frame
+				break;
+			}
+		}
+
+		//court walls:
+		if (ball_vs_walls(&ball, &ball_velocity)) {
+			ball_velocity = glm::vec2(0.0f, 0.0f);
+			ball_reset = true;
+			misses++;
+		}
+	}
+
+	//autopilot launches the ball once it is resting on the paddle (as a player clicking between frames would):
+	if (autopilot && was_reset && ball_reset) launch();
+}
+
+//----- collision helpers (shared by the one-ball and multi-ball updates) -----
+
+void BreakoutGame::paddle_vs_ball(glm::vec2 *at_, glm::vec2 *velocity_, uint32_t *color) const {
+	glm::vec2 &at = *at_;
+	glm::vec2 &velocity = *velocity_;
+
+	//compute area of overlap:
+	glm::vec2 min = glm::max(paddle - paddle_radius, at - ball_radius);
+	glm::vec2 max = glm::min(paddle + paddle_radius, at + ball_radius);
+
+	//if no overlap, no collision:
+	if (min.x > max.x || min.y > max.y) return;
+
+	if (max.x - min.x > max.y - min.y) {
+		//wider overlap in x => bounce in y direction:
+		if (at.y > paddle.y) {
+			at.y = paddle.y + paddle_radius.y + ball_radius.y;
+			velocity.y = std::abs(velocity.y);
+		} else {
+			at.y = paddle.y - paddle_radius.y - ball_radius.y;
+			velocity.y = -std::abs(velocity.y);
+		}
+		// warp x velocity based on offset from paddle center
+		float vel = (at.x - paddle.x) / (paddle_radius.x + ball_radius.x);
+		velocity.x = 4.0f * vel;
+	} else {
+		//wider overlap in y => bounce in x direction:
+		if (at.x > paddle.x) {
+			at.x = paddle.x + paddle_radius.x + ball_radius.x;
+			velocity.x = std::abs(velocity.x);
+		} else {
+			at.x = paddle.x - paddle_radius.x - ball_radius.x;
+			velocity.x = -std::abs(velocity.x);
+		}
+	}
+
+	if (*color != paddle_color) *color = paddle_color;
+}
+
+bool BreakoutGame::ball_hits_brick(glm::vec2 const &at, uint32_t color, Brick const &b) const {
+	// compute area of overlap:
+	glm::vec2 min = glm::max(b.Position - brick_radius, at - ball_radius);
+	glm::vec2 max = glm::min(b.Position + brick_radius, at + ball_radius);
+
+	// no overlap => no collision; and balls pass through bricks of complementary color:
+	return !(min.x > max.x || min.y > max.y || COLORS[color].second == b.Color);
+}
+
+void BreakoutGame::bounce_off_brick(glm::vec2 *at_, glm::vec2 *velocity_, Brick const &b) const {
+	glm::vec2 &at = *at_;
+	glm::vec2 &velocity = *velocity_;
+
+	glm::vec2 min = glm::max(b.Position - brick_radius, at - ball_radius);
+	glm::vec2 max = glm::min(b.Position + brick_radius, at + ball_radius);
+	if (max.x - min.x > max.y - min.y) {
+		// wider overlap in x => bounce in y direction:
+		if (at.y > b.Position.y) {
+			at.y = b.Position.y + brick_radius.y + ball_radius.y;
+			velocity.y = std::abs(velocity.y);
+		} else {
+			at.y = b.Position.y - brick_radius.y - ball_radius.y;
+			velocity.y = -std::abs(velocity.y);
+		}
+	} else {
+		// wider overlap in y => bounce in x direction:
+		if (at.x > b.Position.x) {
+			at.x = b.Position.x + brick_radius.x + ball_radius.x;
+			velocity.x = std::abs(velocity.x);
+		} else {
+			at.x = b.Position.x - brick_radius.x - ball_radius.x;
+			velocity.x = -std::abs(velocity.x);
+		}
+	}
+}
+
+bool BreakoutGame::ball_vs_walls(glm::vec2 *at_, glm::vec2 *velocity_) const {
+	glm::vec2 &at = *at_;
+	glm::vec2 &velocity = *velocity_;
+
+	bool floor = false;
+	if (at.y > court_radius.y - ball_radius.y) {
+		at.y = court_radius.y - ball_radius.y;
+		if (velocity.y > 0.0f) {
+			velocity.y = -velocity.y;
+		}
+	}
+	if (at.y < -court_radius.y + ball_radius.y) {
+		at.y = -court_radius.y + ball_radius.y;
+		floor = true;
+	}
+
+	if (at.x > court_radius.x - ball_radius.x) {
+		at.x = court_radius.x - ball_radius.x;
+		if (velocity.x > 0.0f) {
+			velocity.x = -velocity.x;
+		}
+	}
+	if (at.x < -court_radius.x + ball_radius.x) {
+		at.x = -court_radius.x + ball_radius.x;
+		if (velocity.x < 0.0f) {
+			velocity.x = -velocity.x;
+		}
+	}
+	return floor;
+}
+
+//----- swept (continuous) collision -----
+
+bool BreakoutGame::sweep_ball(glm::vec2 *at_, glm::vec2 *velocity_, uint32_t *color_, float elapsed) {
+	TRACE_SCOPE("sweep ball");
+	PERF_SCOPE("sweep ball");
+	glm::vec2 &at = *at_;
+	glm::vec2 &velocity = *velocity_;
+	uint32_t &color = *color_;
+
+	if (brick_grid.count != bricks.size()) { //(bricks changed since the grid was built)
+		brick_centers.clear();
+		for (Brick const &b : bricks) brick_centers.emplace_back(b.Position);
+		brick_grid.build(brick_centers, brick_radius + ball_radius);
+	}
+	//(broken bricks are only marked here -- so indices, in the grid and out, hold still -- and are erased after the step)
+	if (brick_dead.size() != bricks.size()) brick_dead.assign(bricks.size(), 0);
+
+	glm::vec2 brick_reach = brick_radius + ball_radius;
+	glm::vec2 paddle_reach = paddle_radius + ball_radius;
+	glm::vec2 court = court_radius - ball_radius; //(where the ball's center can go)
+
+	//move the ball along its path, stopping at whatever it reaches first, bouncing, and carrying on with the rest of the step:
+	float remaining = elapsed;
+	for (uint32_t contact = 0; contact < max_contacts && remaining > 0.0f; ++contact) {
+		//a ball already inside a brick (the sweep never leaves one there, but the bricks may have changed under it)
+		// would pass straight through it, so push it out the nearest side and bounce (breaking the brick, as a hit would):
+		uint32_t inside = brick_overlapping(at, color);
+		if (inside != -1U) {
+			Brick const &b = bricks[inside];
+			glm::vec2 depth = brick_reach - glm::abs(at - b.Position);
+			uint32_t k = (depth.x < depth.y ? 0 : 1);
+			float side = (at[k] > b.Position[k] ? 1.0f : -1.0f);
+			at[k] = b.Position[k] + side * brick_reach[k];
+			velocity[k] = side * std::abs(velocity[k]);
+			if (COLORS[color].first == b.Color) {
+				// break brick
+				broken.emplace_back(b);
+				brick_dead[inside] = 1;
+				score++;
+			}
+			continue;
+		}
+
+		glm::vec2 delta = remaining * velocity;
+
+		enum { Nothing, BrickHit, PaddleHit, WallHit, FloorHit } what = Nothing;
+		float time = 2.0f; //(as a fraction of delta)
+		uint32_t axis = 0;
+		uint32_t brick = 0;
+
+		//bricks (along the cells the ball passes through, stopping once later cells can't have an earlier hit):
+		brick_grid.walk(at, delta, [&](uint32_t const *begin, uint32_t const *end, float enter) -> bool {
+			if (enter > time) return false;
+			for (uint32_t const *e = begin; e != end; ++e) {
+				if (brick_dead[*e]) continue;
+				Brick const &b = bricks[*e];
+				// ball passes through bricks of complementary color
+				if (COLORS[color].second == b.Color) continue;
+				float t;
+				uint32_t k;
+				if (!sweep_box(at, delta, b.Position, brick_reach, &t, &k)) continue;
+				//(ties go to the lower-index brick, as in the discrete rules)
+				if (t < time || (t == time && *e < brick)) {
+					what = BrickHit;
+					time = t;
+					axis = k;
+					brick = *e;
+				}
+			}
+			return true;
+		});
+
+		//paddle:
+		{
+			float t;
+			uint32_t k;
+			if (sweep_box(at, delta, paddle, paddle_reach, &t, &k) && t < time) {
+				what = PaddleHit;
+				time = t;
+				axis = k;
+			}
+		}
+
+		//court walls:
+		for (uint32_t k = 0; k < 2; ++k) {
+			if (delta[k] == 0.0f) continue;
+			float limit = (delta[k] > 0.0f ? court[k] : -court[k]);
+			if ((delta[k] > 0.0f ? at[k] + delta[k] <= limit : at[k] + delta[k] >= limit)) continue;
+			float t = std::max(0.0f, (limit - at[k]) / delta[k]);
+			if (t < time) {
+				what = (k == 1 && delta[k] < 0.0f ? FloorHit : WallHit);
+				time = t;
+				axis = k;
+			}
+		}
+
+		if (what == Nothing) {
+			at += delta;
+			break;
+		}
+
+		//move to the contact (exactly touching, along the axis of contact) and bounce:
+		at += time * delta;
+		remaining -= time * remaining;
+
+		if (what == BrickHit) {
+			Brick const &b = bricks[brick];
+			float side = (at[axis] > b.Position[axis] ? 1.0f : -1.0f);
+			at[axis] = b.Position[axis] + side * brick_reach[axis];
+			velocity[axis] = side * std::abs(velocity[axis]);
+
+			if (COLORS[color].first == b.Color) {
+				// break brick
+				broken.emplace_back(b);
+				brick_dead[brick] = 1;
+				score++;
+			}
+		} else if (what == PaddleHit) {
+			float side = (at[axis] > paddle[axis] ? 1.0f : -1.0f);
+			at[axis] = paddle[axis] + side * paddle_reach[axis];
+			velocity[axis] = side * std::abs(velocity[axis]);
+			if (axis == 1) {
+				// warp x velocity based on offset from paddle center
+				float vel = (at.x - paddle.x) / (paddle_radius.x + ball_radius.x);
+				velocity.x = 4.0f * vel;
+			}
+			if (color != paddle_color) color = paddle_color;
+		} else if (what == WallHit) {
+			float side = (delta[axis] > 0.0f ? 1.0f : -1.0f);
+			at[axis] = side * court[axis];
+			velocity[axis] = -side * std::abs(velocity[axis]);
+		} else { //FloorHit
+			at.y = -court.y;
+			return true;
+		}
+	}
+
+	//(if the contacts ran out, the ball stays at the last one -- the rest of its motion this step is dropped)
+
+	//the paddle moved before the ball did, so it may have run into the ball:
+	paddle_vs_ball(&at, &velocity, &color);
+	//(which could push the ball out of the court)
+	return ball_vs_walls(&at, &velocity);
+}
+
+uint32_t BreakoutGame::brick_overlapping(glm::vec2 const &at, uint32_t color) const {
+	glm::vec2 reach = brick_radius + ball_radius;
+	glm::vec2 slack = 1e-4f * reach; //(just touching -- where the sweep leaves the ball -- isn't overlapping)
+	uint32_t found = -1U;
+	//(a zero-length walk visits just the cell 'at' is in, which lists every brick whose grown box holds 'at')
+	brick_grid.walk(at, glm::vec2(0.0f), [&](uint32_t const *begin, uint32_t const *end, float) -> bool {
+		for (uint32_t const *e = begin; e != end; ++e) {
+			if (brick_dead[*e]) continue;
+			Brick const &b = bricks[*e];
+			if (COLORS[color].second == b.Color) continue;
+			glm::vec2 depth = reach - glm::abs(at - b.Position);
+			if (depth.x > slack.x && depth.y > slack.y) found = std::min(found, *e);
+		}
+		return false;
+	});
+	return found;
+}
+
+//----- multi-ball -----
+
+void BreakoutGame::add_ball(glm::vec2 const &at, glm::vec2 const &velocity) {
+	extra_balls.position.emplace_back(at);
+	extra_balls.velocity.emplace_back(velocity);
+	extra_balls.color.emplace_back(ball_color);
+	extra_balls.id.emplace_back(next_ball_id);
+	next_ball_id += 1;
+}
+
+void BreakoutGame::split_ball(uint32_t count) {
+	if (ball_reset) return;
+	float speed = std::max(glm::length(ball_velocity), 1.0f);
+	for (uint32_t i = 0; i < count; ++i) {
+		//fan out upward, evenly spaced between 30 and 150 degrees:
+		float angle = 3.14159265f * (1.0f / 6.0f + (2.0f / 3.0f) * (i + 0.5f) / float(count));
+		add_ball(ball, speed * glm::vec2(std::cos(angle), std::sin(angle)));
+	}
+}
+
+void BreakoutGame::update_multi_ball(float elapsed) {
+	TRACE_SCOPE("multi-ball");
+	PERF_SCOPE("multi-ball");
+
+	//----- gather every ball (the main ball first, then the extras in id order) -----
+	uint32_t count = uint32_t(1 + extra_balls.size());
+	Balls &all = all_balls;
+	all.position.assign(1, ball);
+	all.velocity.assign(1, ball_velocity);
+	all.color.assign(1, ball_color);
+	all.id.assign(1, 0);
+	all.position.insert(all.position.end(), extra_balls.position.begin(), extra_balls.position.end());
+	all.velocity.insert(all.velocity.end(), extra_balls.velocity.begin(), extra_balls.velocity.end());
+	all.color.insert(all.color.end(), extra_balls.color.begin(), extra_balls.color.end());
+	all.id.insert(all.id.end(), extra_balls.id.begin(), extra_balls.id.end());
+
+	std::vector< uint8_t > &lost = ball_lost;
+	lost.assign(count, 0);
+
+	if (swept) {
+		//each ball in turn (in id order) follows its path through the step, bouncing off bricks, the paddle, and walls:
+		// (one at a time, so a brick broken by one ball is gone for the next -- the same for any number of threads)
+		for (uint32_t i = 0; i < count; ++i) {
+			if (i == 0 && ball_reset) { //(the main ball is resting on the paddle)
+				paddle_vs_ball(&all.position[i], &all.velocity[i], &all.color[i]);
+				continue;
+			}
+			lost[i] = sweep_ball(&all.position[i], &all.velocity[i], &all.color[i], elapsed);
+		}
+		if (!broken.empty()) remove_dead_bricks();
+	} else {
+		//(the main ball moved in update(); the extras move here)
+		for (uint32_t i = 1; i < count; ++i) {
+			all.position[i] += elapsed * all.velocity[i];
+		}
+
+		//paddle:
+		for (uint32_t i = 0; i < count; ++i) {
+			paddle_vs_ball(&all.position[i], &all.velocity[i], &all.color[i]);
+		}
+	}
+
+	//----- detect -----
+	find_contacts(elapsed);
+
+	//----- resolve, in a fixed order -----
+	//contacts are taken in order of (time of impact, ball id, brick/other ball index) -- an order that
+	// doesn't depend on how detection was split up -- so the result is the same for any number of threads.
+
+	//bricks: each ball bounces off (and maybe breaks) the first brick it reached that is still there:
+	// (swept balls have dealt with bricks already, so find_contacts doesn't look for these)
+	brick_dead.assign(bricks.size(), 0);
+	ball_hit.assign(count, 0);
+	bool any_broken = false;
+	for (Contact const &contact : brick_contacts) {
+		uint32_t i = contact.ball;
+		if (ball_hit[i] || brick_dead[contact.other]) continue;
+		Brick const &b = bricks[contact.other];
+		bounce_off_brick(&all.position[i], &all.velocity[i], b);
+		if (COLORS[all.color[i]].first == b.Color) {
+			broken.emplace_back(b);
+			brick_dead[contact.other] = 1;
+			any_broken = true;
+			score++;
+		}
+		//one brick per ball per frame:
+		ball_hit[i] = 1;
+	}
+	if (any_broken) remove_dead_bricks();
+
+	//balls vs each other (same-size balls trade velocity along the axis they hit on):
+	for (Contact const &contact : ball_contacts) {
+		if (contact.ball == 0 && ball_reset) continue; //(the main ball is resting on the paddle)
+		glm::vec2 &a = all.position[contact.ball], &b = all.position[contact.other];
+		glm::vec2 &va = all.velocity[contact.ball], &vb = all.velocity[contact.other];
+		//(re-check, since earlier contacts may have moved them)
+		glm::vec2 min = glm::max(a - ball_radius, b - ball_radius);
+		glm::vec2 max = glm::min(a + ball_radius, b + ball_radius);
+		if (min.x > max.x || min.y > max.y) continue;
+		if (max.x - min.x > max.y - min.y) {
+			//wider overlap in x => bounce in y direction:
+			float push = 0.5f * (max.y - min.y) * (a.y < b.y ? -1.0f : 1.0f);
+			a.y += push;
+			b.y -= push;
+			if ((vb.y - va.y) * (b.y - a.y) < 0.0f) std::swap(va.y, vb.y); //(only if approaching)
+		} else {
+			//wider overlap in y => bounce in x direction:
+			float push = 0.5f * (max.x - min.x) * (a.x < b.x ? -1.0f : 1.0f);
+			a.x += push;
+			b.x -= push;
+			if ((vb.x - va.x) * (b.x - a.x) < 0.0f) std::swap(va.x, vb.x);
+		}
+	}
+
+	//court walls:
+	for (uint32_t i = 0; i < count; ++i) {
+		if (ball_vs_walls(&all.position[i], &all.velocity[i])) lost[i] = 1;
+	}
+
+	//----- scatter back -----
+	ball = all.position[0];
+	ball_velocity = all.velocity[0];
+	ball_color = all.color[0];
+	if (lost[0]) {
+		ball_velocity = glm::vec2(0.0f, 0.0f);
+		ball_reset = true;
+		misses++;
+	}
+	//(extra balls that reach the floor leave the game)
+	extra_balls.clear();
+	for (uint32_t i = 1; i < count; ++i) {
+		if (lost[i]) continue;
+		extra_balls.position.emplace_back(all.position[i]);
+		extra_balls.velocity.emplace_back(all.velocity[i]);
+		extra_balls.color.emplace_back(all.color[i]);
+		extra_balls.id.emplace_back(all.id[i]);
+	}
+}
+
+//when (as a fraction of the step) two boxes that overlap now started overlapping, if one moved 'moved' relative to the other:
+// ('offset' is from the moving box to the other; 'reach' is the sum of their radii)
+static float entry_time(glm::vec2 const &offset, glm::vec2 const &reach, glm::vec2 const &moved) {
+	float entry = 0.0f;
+	for (uint32_t k = 0; k < 2; ++k) {
+		//only overlap gained while moving toward the other box counts (otherwise, it overlapped all step long):
+		if (moved[k] == 0.0f || (moved[k] > 0.0f) != (offset[k] > 0.0f)) continue;
+		float depth = reach[k] - std::abs(offset[k]);
+		entry = std::max(entry, 1.0f - depth / std::abs(moved[k]));
+	}
+	return std::min(std::max(entry, 0.0f), 1.0f);
+}
+
+void BreakoutGame::find_contacts(float elapsed) {
+	TRACE_SCOPE("find contacts");
+	Balls const &all = all_balls;
+	uint32_t count = uint32_t(all.size());
+	brick_contacts.clear();
+	ball_contacts.clear();
+
+	if (!broadphase) {
+		//every pair:
+		for (uint32_t i = 0; i < count; ++i) {
+			for (uint32_t b = 0; b < bricks.size() && !swept; ++b) {
+				if (!ball_hits_brick(all.position[i], all.color[i], bricks[b])) continue;
+				float time = entry_time(bricks[b].Position - all.position[i], brick_radius + ball_radius, elapsed * all.velocity[i]);
+				brick_contacts.emplace_back(time, i, b);
+			}
+			for (uint32_t j = i + 1; j < count; ++j) {
+				if (!balls_overlap(all.position[i], all.position[j])) continue;
+				float time = entry_time(all.position[j] - all.position[i], 2.0f * ball_radius, elapsed * (all.velocity[i] - all.velocity[j]));
+				ball_contacts.emplace_back(time, i, j);
+			}
+		}
+		std::sort(brick_contacts.begin(), brick_contacts.end());
+		std::sort(ball_contacts.begin(), ball_contacts.end());
+		return;
+	}
+
+	//----- sweep and prune (along x) -----
+	//balls, sorted by x, sweep over the bricks, sorted by x: the window of bricks whose x range can overlap
+	// the current ball's slides right as the balls do, and only bricks in the window are tested.
+	//Bricks sharing an x (a column of a grid-like level) are sorted by y, so each column in the window is
+	// cut down to the bricks in reach with a binary search.
+	//Likewise, each ball is only tested against the balls after it in x order that are within reach.
+	//(With 'swept' on, balls have already dealt with bricks, so only ball-ball contacts are found.)
+	if (!swept) sort_bricks();
+
+	ball_order.resize(count);
+	for (uint32_t i = 0; i < count; ++i) ball_order[i] = i;
+	std::sort(ball_order.begin(), ball_order.end(), [&all](uint32_t a, uint32_t b) -> bool {
+		if (all.position[a].x != all.position[b].x) return all.position[a].x < all.position[b].x;
+		return a < b;
+	});
+
+	//the sweep only reads the game, so runs of balls (in x order) can be swept in parallel,
+	// each into its own contact buffers:
+	uint32_t jobs = 1;
+	if (pool && count >= parallel_balls) jobs = std::min(pool->size(), count);
+	if (contact_buffers.size() < jobs) contact_buffers.resize(jobs);
+	if (jobs == 1) {
+		sweep(0, count, elapsed, &contact_buffers[0]);
+	} else {
+		for (uint32_t job = 0; job < jobs; ++job) {
+			uint32_t begin = uint32_t(uint64_t(count) * job / jobs);
+			uint32_t end = uint32_t(uint64_t(count) * (job + 1) / jobs);
+			ContactBuffers *buffers = &contact_buffers[job];
+			pool->submit([this, begin, end, elapsed, buffers]() {
+				sweep(begin, end, elapsed, buffers);
+			});
+		}
+		pool->wait();
+	}
+
+	//merge the (sorted) buffers:
+	auto merge = [](std::vector< Contact > const &from, std::vector< Contact > *into, std::vector< Contact > *scratch) {
+		scratch->clear();
+		std::merge(into->begin(), into->end(), from.begin(), from.end(), std::back_inserter(*scratch));
+		std::swap(*into, *scratch);
+	};
+	for (uint32_t job = 0; job < jobs; ++job) {
+		merge(contact_buffers[job].bricks, &brick_contacts, &merged_contacts);
+		merge(contact_buffers[job].balls, &ball_contacts, &merged_contacts);
+	}
+}
+
+void BreakoutGame::sweep(uint32_t begin, uint32_t end, float elapsed, ContactBuffers *out) const {
+	TRACE_SCOPE("sweep");
+	Balls const &all = all_balls;
+	uint32_t count = uint32_t(all.size());
+	out->bricks.clear();
+	out->balls.clear();
+	if (begin == end) return;
+
+	//(reaches are a little longer than needed, so rounding can't leave out a pair the exact tests would find)
+	glm::vec2 brick_reach = (brick_radius + ball_radius) * 1.0001f + glm::vec2(1e-4f);
+	float ball_reach = (2.0f * ball_radius.x) * 1.0001f + 1e-4f;
+
+	//window of columns, starting at the first column in reach of the first ball:
+	// (empty if bricks aren't wanted -- see find_contacts)
+	size_t lo = 0;
+	if (!swept) {
+		float first_x = all.position[ball_order[begin]].x;
+		lo = std::partition_point(brick_columns.begin(), brick_columns.end() - 1, [this, first_x, &brick_reach](uint32_t column) -> bool {
+			return brick_order_x[column] < first_x - brick_reach.x;
+		}) - brick_columns.begin();
+	}
+	size_t hi = lo;
+
+	for (uint32_t o = begin; o < end; ++o) {
+		uint32_t i = ball_order[o];
+		glm::vec2 const &at = all.position[i];
+		glm::vec2 moved = elapsed * all.velocity[i];
+		if (!swept) {
+			while (lo + 1 < brick_columns.size() && brick_order_x[brick_columns[lo]] < at.x - brick_reach.x) ++lo;
+			if (hi < lo) hi = lo;
+			while (hi + 1 < brick_columns.size() && brick_order_x[brick_columns[hi]] <= at.x + brick_reach.x) ++hi;
+		}
+		for (size_t c = lo; c < hi; ++c) {
+			auto column_begin = brick_order_y.begin() + brick_columns[c];
+			auto column_end = brick_order_y.begin() + brick_columns[c + 1];
+			for (auto y = std::lower_bound(column_begin, column_end, at.y - brick_reach.y); y != column_end && *y <= at.y + brick_reach.y; ++y) {
+				uint32_t b = brick_order[y - brick_order_y.begin()];
+				if (!ball_hits_brick(at, all.color[i], bricks[b])) continue;
+				out->bricks.emplace_back(entry_time(bricks[b].Position - at, brick_radius + ball_radius, moved), i, b);
+			}
+		}
+		//(pairs are found by whichever ball comes first in x order, even if the other is in the next run)
+		for (uint32_t p = o + 1; p < count; ++p) {
+			uint32_t j = ball_order[p];
+			if (all.position[j].x > at.x + ball_reach) break;
+			if (!balls_overlap(at, all.position[j])) continue;
+			uint32_t a = std::min(i, j), b = std::max(i, j);
+			float time = entry_time(all.position[b] - all.position[a], 2.0f * ball_radius, elapsed * (all.velocity[a] - all.velocity[b]));
+			out->balls.emplace_back(time, a, b);
+		}
+	}
+
+	//(sorting here, rather than after merging, puts more of the work on the job's thread)
+	std::sort(out->bricks.begin(), out->bricks.end());
+	std::sort(out->balls.begin(), out->balls.end());
+}
+
+bool BreakoutGame::balls_overlap(glm::vec2 const &a, glm::vec2 const &b) const {
+	glm::vec2 min = glm::max(a - ball_radius, b - ball_radius);
+	glm::vec2 max = glm::min(a + ball_radius, b + ball_radius);
+	return !(min.x > max.x || min.y > max.y);
+}
+
+void BreakoutGame::sort_bricks() {
+	if (brick_order.size() == bricks.size() && !brick_columns.empty()) return; //(up to date -- see remove_dead_bricks)
+	brick_order.resize(bricks.size());
+	for (uint32_t b = 0; b < bricks.size(); ++b) brick_order[b] = b;
+	std::sort(brick_order.begin(), brick_order.end(), [this](uint32_t a, uint32_t b) -> bool {
+		glm::vec2 const &pa = bricks[a].Position;
+		glm::vec2 const &pb = bricks[b].Position;
+		if (pa.x != pb.x) return pa.x < pb.x;
+		if (pa.y != pb.y) return pa.y < pb.y;
+		return a < b;
+	});
+	brick_order_x.resize(bricks.size());
+	brick_order_y.resize(bricks.size());
+	for (size_t w = 0; w < brick_order.size(); ++w) {
+		brick_order_x[w] = bricks[brick_order[w]].Position.x;
+		brick_order_y[w] = bricks[brick_order[w]].Position.y;
+	}
+	find_brick_columns();
+}
+
+void BreakoutGame::find_brick_columns() {
+	//start of each run of equal x in brick_order, then the end of the last one:
+	brick_columns.clear();
+	for (size_t w = 0; w < brick_order_x.size(); ++w) {
+		if (w == 0 || brick_order_x[w] != brick_order_x[w - 1]) brick_columns.emplace_back(uint32_t(w));
+	}
+	brick_columns.emplace_back(uint32_t(brick_order_x.size()));
+}
+
+void BreakoutGame::remove_dead_bricks() {
+	//new index of each brick (the survivors keep their order):
+	std::vector< uint32_t > &remap = brick_remap;
+	remap.resize(bricks.size());
+	uint32_t kept = 0;
+	for (uint32_t b = 0; b < bricks.size(); ++b) {
+		remap[b] = kept;
+		if (!brick_dead[b]) {
+			bricks[kept] = bricks[b];
+			kept += 1;
+		}
+	}
+
+	//the sorted order of the survivors doesn't change, so brick_order just drops the dead and renumbers:
+	if (brick_order.size() == bricks.size()) {
+		size_t out = 0;
+		for (size_t w = 0; w < brick_order.size(); ++w) {
+			uint32_t b = brick_order[w];
+			if (brick_dead[b]) continue;
+			brick_order[out] = remap[b];
+			brick_order_x[out] = brick_order_x[w];
+			brick_order_y[out] = brick_order_y[w];
+			out += 1;
+		}
+		brick_order.resize(out);
+		brick_order_x.resize(out);
+		brick_order_y.resize(out);
+		find_brick_columns();
+	}
+
+	//likewise the grid (if it is up to date) just drops the dead and renumbers:
+	if (brick_grid.count == bricks.size()) {
+		brick_grid.compact(brick_dead, remap);
+	}
+
+	bricks.erase(bricks.begin() + kept, bricks.end());
+	brick_dead.assign(bricks.size(), 0); //(ready for the next step)
+}
+
+uint64_t BreakoutGame::state_hash() const {
+	StateHash hash;
+	hash.add(paddle);
+	hash.add(paddle_color);
+	hash.add(ball);
+	hash.add(ball_velocity);
+	hash.add(ball_color);
+	hash.add(uint8_t(ball_reset));
+	hash.add(score);
+	hash.add(misses);
+	hash.add(ai_offset);
+	hash.add(ai_offset_update);
+	if (!extra_balls.empty()) { //(so one-ball games hash as they always have)
+		hash.add(uint32_t(extra_balls.size()));
+		for (size_t i = 0; i < extra_balls.size(); ++i) {
+			hash.add(extra_balls.position[i]);
+			hash.add(extra_balls.velocity[i]);
+			hash.add(extra_balls.color[i]);
+			hash.add(extra_balls.id[i]);
+		}
+	}
+	hash.add(uint32_t(bricks.size()));
+	for (auto const &b : bricks) {
+		hash.add(b.Position);
+		hash.add(b.Color);
+	}
+	return hash.value;
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "Level.hpp"
+#include "BrickGrid.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <random>
+#include <utility>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+#define FROM_HEX( HX ) (glm::u8vec4((HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff, 0xff))
+
+struct ThreadPool;
+
+typedef glm::u8vec4 color_t;
+typedef std::pair<color_t, color_t> color_pair;
+
+/*
+ * BreakoutGame holds the state and rules of Brick Breaker Colors (see README),
+ * with no window or OpenGL dependencies -- so it can be simulated headless, and many times over.
+ * BreakoutMode feeds it input and draws it.
+ */
+
+struct BreakoutGame {
+	BreakoutGame();
+
+	//replace the bricks and court size with those of 'level' (and re-center the paddle):
+	void load_level(Level const &level);
+
+	//open 'level_file' (see Level.hpp), or the built-in level if empty:
+	static std::unique_ptr< Level > open_level(std::string const &level_file);
+	static const char *default_level; //text description of the built-in level
+
+	//----- input -----
+	//(the paddle is steered by writing 'paddle.x' directly; update() keeps it in the court)
+
+	//send the ball off the paddle (if it is resting there):
+	void launch();
+	//switch the paddle to the next color:
+	void cycle_paddle_color();
+
+	//when set, update() plays the game itself (steering the paddle, picking colors, launching the ball):
+	bool autopilot = false;
+
+	//----- simulation -----
+
+	void update(float elapsed);
+
+	//when set, the ball moves continuously: update() follows its path through the step, bouncing off
+	// whatever it reaches first (up to max_contacts times per step), so fast balls and long steps can't
+	// pass through bricks, the paddle, or walls. Otherwise, the ball jumps to its new position and
+	// bounces off (at most) one brick it then overlaps -- the original rules.
+	//Off by default, so games (and state hashes) are as they always were -- BreakoutLanes, BatchRunner,
+	// and BreakoutEnv play the discrete rules; BreakoutMode turns this on.
+	//A ball that runs out of contacts stops at the last one (the rest of its motion that step is dropped),
+	// and a ball that starts a step inside a brick is pushed out of it first.
+	//(with extra balls, each ball is swept in turn, in id order, and then the balls bounce off each other as usual)
+	bool swept = false;
+	uint32_t max_contacts = 16;
+
+	//----- multi-ball -----
+	//Extra balls follow the same rules as the main ball (paddle, bricks, walls) and also bounce off each other;
+	// an extra ball that reaches the floor leaves the game. With no extra balls, update() runs the one-ball
+	// rules exactly as they always were (so, with 'swept' off, one-ball games -- and their state hashes -- don't change).
+
+	//add a ball (the color of the main ball) at 'at' moving with 'velocity':
+	void add_ball(glm::vec2 const &at, glm::vec2 const &velocity);
+	//add 'count' balls fanning out upward from the main ball (if it is in play):
+	void split_ball(uint32_t count);
+
+	//when set, contacts are found with a sweep-and-prune along x; otherwise every pair is tested:
+	// (the results are the same; the brute-force search is there to check that)
+	bool broadphase = true;
+
+	//if set, contact detection for many balls (at least 'parallel_balls') is split across this pool's threads:
+	// (the results are the same for any number of threads)
+	ThreadPool *pool = nullptr;
+	uint32_t parallel_balls = 256;
+
+	//bit-exact summary of the state (see StateHash.hpp):
+	uint64_t state_hash() const;
+
+	//----- game state -----
+
+	//each game has its own pseudo-random number generator (used by the autopilot),
+	// so games can run side-by-side (e.g., on different threads) and still be reproducible:
+	std::mt19937 mt;
+	void seed(uint32_t seed_) { mt.seed(seed_); }
+
+	static const color_t RED;
+	static const color_t YELLOW;
+	static const color_t BLUE;
+	static const color_t GREEN;
+	static const color_t PURPLE;
+	static const color_t ORANGE;
+
+	//(color, complementary color) pairs that the paddle and ball cycle through:
+	static const uint32_t COLOR_COUNT = 6;
+	static const color_pair COLORS[COLOR_COUNT];
+
+	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
+	glm::vec2 paddle_radius = glm::vec2(1.0f, 0.2f);
+	glm::vec2 ball_radius = glm::vec2(0.1f, 0.1f);
+	glm::vec2 brick_radius = glm::vec2(0.5f, 0.3f);
+
+	glm::vec2 paddle = glm::vec2(0.0f, -court_radius.y + 0.5f);
+	uint32_t paddle_color = 0; //index into COLORS
+
+	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
+	glm::vec2 ball_velocity = glm::vec2(0.0f, 0.0f);
+	uint32_t ball_color = 0; //index into COLORS
+
+	struct Brick {
+		Brick(glm::vec2 const &Position_, glm::u8vec4 const &Color_) :
+			Position(Position_), Color(Color_) { }
+		glm::vec2 Position;
+		glm::u8vec4 Color;
+	};
+
+	std::vector<Brick> bricks;
+
+	//bricks broken by the latest update() (for effects; not part of the game state):
+	std::vector<Brick> broken;
+
+	//extra balls (structure-of-arrays, in order of id; the main ball counts as id 0):
+	struct Balls {
+		std::vector< glm::vec2 > position;
+		std::vector< glm::vec2 > velocity;
+		std::vector< uint32_t > color; //index into COLORS
+		std::vector< uint32_t > id;
+		size_t size() const { return position.size(); }
+		bool empty() const { return position.empty(); }
+		void clear() { position.clear(); velocity.clear(); color.clear(); id.clear(); }
+	};
+	Balls extra_balls;
+	uint32_t next_ball_id = 1;
+
+	bool ball_reset = true;
+
+	int score = 0;
+	int misses = 0; //times the ball hit the floor
+
+	//autopilot state:
+	float ai_offset = 0.0f; //where the paddle aims, relative to the ball
+	float ai_offset_update = 0.0f; //time until a new offset (and maybe color) is picked
+	float ai_speed = 4.0f; //paddle speed limit
+
+	//----- internals -----
+
+	//collision rules for one ball (shared by the one-ball and multi-ball updates):
+	void paddle_vs_ball(glm::vec2 *at, glm::vec2 *velocity, uint32_t *color) const;
+	bool ball_hits_brick(glm::vec2 const &at, uint32_t color, Brick const &b) const;
+	void bounce_off_brick(glm::vec2 *at, glm::vec2 *velocity, Brick const &b) const;
+	bool balls_overlap(glm::vec2 const &a, glm::vec2 const &b) const;
+	//keeps the ball in the court; returns true if it hit the floor:
+	bool ball_vs_walls(glm::vec2 *at, glm::vec2 *velocity) const;
+
+	//move a ball through the step with swept collisions (see 'swept'), marking the bricks it breaks in brick_dead
+	// (the caller erases them with remove_dead_bricks once every ball has moved); returns true if it reached the floor:
+	bool sweep_ball(glm::vec2 *at, glm::vec2 *velocity, uint32_t *color, float elapsed);
+	BrickGrid brick_grid; //bricks, grown by the ball radius (built by sweep_ball when out of date)
+	//the (live, lowest-index) brick the ball at 'at' is inside, or -1U (needs brick_grid up to date):
+	uint32_t brick_overlapping(glm::vec2 const &at, uint32_t color) const;
+	std::vector< glm::vec2 > brick_centers; //(for building brick_grid)
+
+	void update_multi_ball(float elapsed);
+	//a ball touching a brick or another ball:
+	struct Contact {
+		Contact(float time_, uint32_t ball_, uint32_t other_) : time(time_), ball(ball_), other(other_) { }
+		float time; //when the two started overlapping (as a fraction of the step) -- i.e., time of impact
+		uint32_t ball; //index in all_balls (the same order as ball ids)
+		uint32_t other; //index of the brick, or (for ball-ball contacts) of the other ball (ball < other)
+		//(the order contacts are resolved in)
+		bool operator<(Contact const &o) const {
+			if (time != o.time) return time < o.time;
+			if (ball != o.ball) return ball < o.ball;
+			return other < o.other;
+		}
+	};
+	struct ContactBuffers {
+		std::vector< Contact > bricks;
+		std::vector< Contact > balls;
+	};
+
+	//fill brick_contacts (unless 'swept') and ball_contacts for all_balls, each sorted (on 'pool', if there are enough balls):
+	void find_contacts(float elapsed);
+	//find contacts for balls [begin,end) of ball_order (sweep and prune), and sort them:
+	void sweep(uint32_t begin, uint32_t end, float elapsed, ContactBuffers *out) const;
+	//(re)build brick_order (and the rest of the sorted brick arrays) if it is out of date:
+	void sort_bricks();
+	void find_brick_columns();
+	//erase bricks marked in brick_dead (keeping order), and keep brick_order and brick_grid up to date:
+	void remove_dead_bricks();
+
+	//working space for update_multi_ball (kept between updates to avoid re-allocating):
+	Balls all_balls; //main ball + extra balls
+	std::vector< Contact > brick_contacts;
+	std::vector< Contact > ball_contacts;
+	std::vector< ContactBuffers > contact_buffers; //one per detection job
+	std::vector< Contact > merged_contacts;
+	std::vector< uint32_t > ball_order; //balls in order of x
+	std::vector< uint32_t > brick_order; //bricks in order of (x, y) (kept up to date between updates)
+	std::vector< float > brick_order_x; //x of each brick in brick_order
+	std::vector< float > brick_order_y; //y of each brick in brick_order
+	std::vector< uint32_t > brick_columns; //where each run of equal x starts in brick_order (+ the end)
+	std::vector< uint8_t > brick_dead; //bricks broken this step, not yet erased (all clear between updates)
+	std::vector< uint8_t > ball_hit; //ball has bounced off a brick this frame
+	std::vector< uint32_t > brick_remap;
+	std::vector< uint8_t > ball_lost;
+};
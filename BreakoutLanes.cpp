@@ -0,0 +1,354 @@
+#include "BreakoutLanes.hpp"
+
+//for state_hash():
+#include "StateHash.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BREAKOUT_LANES_SSE
+#include <emmintrin.h>
+#endif
+
+//colors as 32-bit values (so lanes can compare four at once):
+static uint32_t pack(color_t const &color) {
+	uint32_t packed;
+	static_assert(sizeof(color) == sizeof(packed), "color_t is four bytes");
+	std::memcpy(&packed, &color, sizeof(packed));
+	return packed;
+}
+
+template< uint32_t LANES >
+BreakoutLanes< LANES >::BreakoutLanes(BreakoutGame const &start) {
+	autopilot = start.autopilot;
+	ai_speed = start.ai_speed;
+	court_radius = start.court_radius;
+	paddle_radius = start.paddle_radius;
+	ball_radius = start.ball_radius;
+	brick_radius = start.brick_radius;
+	paddle_y = start.paddle.y;
+
+	uint32_t all_lanes = (LANES == 32 ? 0xffffffffu : (1u << LANES) - 1u);
+	brick_x.reserve(start.bricks.size());
+	brick_y.reserve(start.bricks.size());
+	brick_color.reserve(start.bricks.size());
+	for (auto const &b : start.bricks) {
+		brick_x.emplace_back(b.Position.x);
+		brick_y.emplace_back(b.Position.y);
+		brick_color.emplace_back(b.Color);
+	}
+	brick_alive.assign(start.bricks.size(), all_lanes);
+
+	for (uint32_t l = 0; l < LANES; ++l) {
+		reset(l, start);
+	}
+}
+
+template< uint32_t LANES >
+void BreakoutLanes< LANES >::reset(uint32_t l, BreakoutGame const &start) {
+	paddle_x[l] = start.paddle.x;
+	ball_x[l] = start.ball.x;
+	ball_y[l] = start.ball.y;
+	ball_velocity_x[l] = start.ball_velocity.x;
+	ball_velocity_y[l] = start.ball_velocity.y;
+	paddle_color[l] = start.paddle_color;
+	ball_color[l] = start.ball_color;
+	ball_reset[l] = start.ball_reset;
+	score[l] = start.score;
+	misses[l] = start.misses;
+	bricks_left[l] = uint32_t(start.bricks.size());
+	ai_offset[l] = start.ai_offset;
+	ai_offset_update[l] = start.ai_offset_update;
+	for (auto &alive : brick_alive) {
+		alive |= (1u << l);
+	}
+}
+
+template< uint32_t LANES >
+void BreakoutLanes< LANES >::launch(uint32_t l) {
+	if (ball_reset[l]) {
+		ball_reset[l] = false;
+		ball_velocity_x[l] = 0.0f;
+		ball_velocity_y[l] = 6.0f;
+	}
+}
+
+template< uint32_t LANES >
+void BreakoutLanes< LANES >::find_hits(int32_t hit[LANES]) const {
+	//each lane's ball bounds and the color it passes through:
+	float ball_min_x[LANES], ball_min_y[LANES], ball_max_x[LANES], ball_max_y[LANES];
+	uint32_t pass_color[LANES];
+	for (uint32_t l = 0; l < LANES; ++l) {
+		hit[l] = -1;
+		ball_min_x[l] = ball_x[l] - ball_radius.x;
+		ball_min_y[l] = ball_y[l] - ball_radius.y;
+		ball_max_x[l] = ball_x[l] + ball_radius.x;
+		ball_max_y[l] = ball_y[l] + ball_radius.y;
+		pass_color[l] = pack(BreakoutGame::COLORS[ball_color[l]].second);
+	}
+
+	uint32_t searching = (LANES == 32 ? 0xffffffffu : (1u << LANES) - 1u); //lanes still looking for their brick
+	for (size_t i = 0; i < brick_x.size() && searching; ++i) {
+		uint32_t candidates = brick_alive[i] & searching;
+		if (!candidates) continue;
+
+		float brick_min_x = brick_x[i] - brick_radius.x;
+		float brick_min_y = brick_y[i] - brick_radius.y;
+		float brick_max_x = brick_x[i] + brick_radius.x;
+		float brick_max_y = brick_y[i] + brick_radius.y;
+		uint32_t color = pack(brick_color[i]);
+
+		//lanes whose ball overlaps the brick (and doesn't pass through it):
+		uint32_t hits = 0;
+#ifdef BREAKOUT_LANES_SSE
+		for (uint32_t g = 0; g < LANES; g += 4) {
+			__m128 min_x = _mm_max_ps(_mm_set1_ps(brick_min_x), _mm_loadu_ps(ball_min_x + g));
+			__m128 min_y = _mm_max_ps(_mm_set1_ps(brick_min_y), _mm_loadu_ps(ball_min_y + g));
+			__m128 max_x = _mm_min_ps(_mm_set1_ps(brick_max_x), _mm_loadu_ps(ball_max_x + g));
+			__m128 max_y = _mm_min_ps(_mm_set1_ps(brick_max_y), _mm_loadu_ps(ball_max_y + g));
+			__m128 miss = _mm_or_ps(_mm_cmpgt_ps(min_x, max_x), _mm_cmpgt_ps(min_y, max_y));
+			__m128i pass = _mm_cmpeq_epi32(_mm_set1_epi32(int32_t(color)), _mm_loadu_si128(reinterpret_cast< __m128i const * >(pass_color + g)));
+			int reject = _mm_movemask_ps(_mm_or_ps(miss, _mm_castsi128_ps(pass)));
+			hits |= uint32_t(~reject & 0xf) << g;
+		}
+#else
+		for (uint32_t l = 0; l < LANES; ++l) {
+			float min_x = std::max(brick_min_x, ball_min_x[l]);
+			float min_y = std::max(brick_min_y, ball_min_y[l]);
+			float max_x = std::min(brick_max_x, ball_max_x[l]);
+			float max_y = std::min(brick_max_y, ball_max_y[l]);
+			if (min_x > max_x || min_y > max_y || pass_color[l] == color) continue;
+			hits |= (1u << l);
+		}
+#endif
+		hits &= candidates;
+		if (!hits) continue;
+		for (uint32_t l = 0; l < LANES; ++l) {
+			if (hits & (1u << l)) hit[l] = int32_t(i);
+		}
+		searching &= ~hits;
+	}
+}
+
+template< uint32_t LANES >
+void BreakoutLanes< LANES >::update(float elapsed) {
+	//NOTE: the per-lane code below mirrors BreakoutGame::update step-for-step (so results match bit-for-bit);
+	// keep them in sync.
+
+	bool was_reset[LANES];
+
+	for (uint32_t l = 0; l < LANES; ++l) {
+		glm::vec2 paddle = glm::vec2(paddle_x[l], paddle_y);
+		glm::vec2 ball = glm::vec2(ball_x[l], ball_y[l]);
+		glm::vec2 ball_velocity = glm::vec2(ball_velocity_x[l], ball_velocity_y[l]);
+
+		if (autopilot) {
+			std::mt19937 &mt = this->mt[l];
+			ai_offset_update[l] -= elapsed;
+			if (ai_offset_update[l] < elapsed) {
+				ai_offset_update[l] = (mt() / float(mt.max())) * 0.5f + 0.5f;
+				ai_offset[l] = (mt() / float(mt.max())) * 1.6f - 0.8f;
+				if (bricks_left[l] != 0) {
+					//(the n'th brick still alive in this lane:)
+					uint32_t n = mt() % bricks_left[l];
+					size_t i = 0;
+					for (; i < brick_alive.size(); ++i) {
+						if (brick_alive[i] & (1u << l)) {
+							if (n == 0) break;
+							--n;
+						}
+					}
+					color_t want = brick_color[i];
+					for (uint32_t c = 0; c < BreakoutGame::COLOR_COUNT; ++c) {
+						if (BreakoutGame::COLORS[c].first == want) paddle_color[l] = c;
+					}
+				}
+			}
+			float target = ball.x + ai_offset[l];
+			if (paddle.x < target) {
+				paddle.x = std::min(target, paddle.x + ai_speed * elapsed);
+			} else {
+				paddle.x = std::max(target, paddle.x - ai_speed * elapsed);
+			}
+		}
+		was_reset[l] = ball_reset[l];
+
+		//paddle update:
+		paddle.x = std::max(paddle.x, -court_radius.x + paddle_radius.x);
+		paddle.x = std::min(paddle.x,  court_radius.x - paddle_radius.x);
+
+		//ball update:
+		if (ball_reset[l]) {
+			ball = paddle + glm::vec2(0.0f, ball_radius.y);
+		} else {
+			ball += elapsed * ball_velocity;
+		}
+
+		//paddle vs ball:
+		glm::vec2 min = glm::max(paddle - paddle_radius, ball - ball_radius);
+		glm::vec2 max = glm::min(paddle + paddle_radius, ball + ball_radius);
+		if (!(min.x > max.x || min.y > max.y)) {
+			if (max.x - min.x > max.y - min.y) {
+				if (ball.y > paddle.y) {
+					ball.y = paddle.y + paddle_radius.y + ball_radius.y;
+					ball_velocity.y = std::abs(ball_velocity.y);
+				} else {
+					ball.y = paddle.y - paddle_radius.y - ball_radius.y;
+					ball_velocity.y = -std::abs(ball_velocity.y);
+				}
+				float vel = (ball.x - paddle.x) / (paddle_radius.x + ball_radius.x);
+				ball_velocity.x = 4.0f * vel;
+			} else {
+				if (ball.x > paddle.x) {
+					ball.x = paddle.x + paddle_radius.x + ball_radius.x;
+					ball_velocity.x = std::abs(ball_velocity.x);
+				} else {
+					ball.x = paddle.x - paddle_radius.x - ball_radius.x;
+					ball_velocity.x = -std::abs(ball_velocity.x);
+				}
+			}
+			if (ball_color[l] != paddle_color[l]) ball_color[l] = paddle_color[l];
+		}
+
+		paddle_x[l] = paddle.x;
+		ball_x[l] = ball.x;
+		ball_y[l] = ball.y;
+		ball_velocity_x[l] = ball_velocity.x;
+		ball_velocity_y[l] = ball_velocity.y;
+	}
+
+	//ball vs bricks (all lanes at once):
+	int32_t hit[LANES];
+	find_hits(hit);
+
+	for (uint32_t l = 0; l < LANES; ++l) {
+		glm::vec2 ball = glm::vec2(ball_x[l], ball_y[l]);
+		glm::vec2 ball_velocity = glm::vec2(ball_velocity_x[l], ball_velocity_y[l]);
+
+		if (hit[l] >= 0) {
+			uint32_t i = uint32_t(hit[l]);
+			glm::vec2 position = glm::vec2(brick_x[i], brick_y[i]);
+			glm::vec2 min = glm::max(position - brick_radius, ball - ball_radius);
+			glm::vec2 max = glm::min(position + brick_radius, ball + ball_radius);
+			if (max.x - min.x > max.y - min.y) {
+				if (ball.y > position.y) {
+					ball.y = position.y + brick_radius.y + ball_radius.y;
+					ball_velocity.y = std::abs(ball_velocity.y);
+				} else {
+					ball.y = position.y - brick_radius.y - ball_radius.y;
+					ball_velocity.y = -std::abs(ball_velocity.y);
+				}
+			} else {
+				if (ball.x > position.x) {
+					ball.x = position.x + brick_radius.x + ball_radius.x;
+					ball_velocity.x = std::abs(ball_velocity.x);
+				} else {
+					ball.x = position.x - brick_radius.x - ball_radius.x;
+					ball_velocity.x = -std::abs(ball_velocity.x);
+				}
+			}
+			if (BreakoutGame::COLORS[ball_color[l]].first == brick_color[i]) {
+				brick_alive[i] &= ~(1u << l);
+				bricks_left[l] -= 1;
+				score[l] += 1;
+			}
+		}
+
+		//court walls:
+		if (ball.y > court_radius.y - ball_radius.y) {
+			ball.y = court_radius.y - ball_radius.y;
+			if (ball_velocity.y > 0.0f) {
+				ball_velocity.y = -ball_velocity.y;
+			}
+		}
+		if (ball.y < -court_radius.y + ball_radius.y) {
+			ball.y = -court_radius.y + ball_radius.y;
+			ball_velocity = glm::vec2(0.0f, 0.0f);
+			ball_reset[l] = true;
+			misses[l] += 1;
+		}
+		if (ball.x > court_radius.x - ball_radius.x) {
+			ball.x = court_radius.x - ball_radius.x;
+			if (ball_velocity.x > 0.0f) {
+				ball_velocity.x = -ball_velocity.x;
+			}
+		}
+		if (ball.x < -court_radius.x + ball_radius.x) {
+			ball.x = -court_radius.x + ball_radius.x;
+			if (ball_velocity.x < 0.0f) {
+				ball_velocity.x = -ball_velocity.x;
+			}
+		}
+
+		//autopilot launch (see BreakoutGame::launch):
+		if (autopilot && was_reset[l] && ball_reset[l]) {
+			ball_reset[l] = false;
+			ball_velocity = glm::vec2(0.0f, 6.0f);
+		}
+
+		ball_x[l] = ball.x;
+		ball_y[l] = ball.y;
+		ball_velocity_x[l] = ball_velocity.x;
+		ball_velocity_y[l] = ball_velocity.y;
+	}
+}
+
+template< uint32_t LANES >
+uint64_t BreakoutLanes< LANES >::state_hash(uint32_t l) const {
+	//(same fields, in the same order, as BreakoutGame::state_hash)
+	StateHash hash;
+	hash.add(glm::vec2(paddle_x[l], paddle_y));
+	hash.add(paddle_color[l]);
+	hash.add(glm::vec2(ball_x[l], ball_y[l]));
+	hash.add(glm::vec2(ball_velocity_x[l], ball_velocity_y[l]));
+	hash.add(ball_color[l]);
+	hash.add(uint8_t(ball_reset[l]));
+	hash.add(score[l]);
+	hash.add(misses[l]);
+	hash.add(ai_offset[l]);
+	hash.add(ai_offset_update[l]);
+	hash.add(bricks_left[l]);
+	for (size_t i = 0; i < brick_alive.size(); ++i) {
+		if (!(brick_alive[i] & (1u << l))) continue;
+		hash.add(glm::vec2(brick_x[i], brick_y[i]));
+		hash.add(brick_color[i]);
+	}
+	return hash.value;
+}
+
+template< uint32_t LANES >
+void BreakoutLanes< LANES >::get_game(uint32_t l, BreakoutGame *game) const {
+	game->autopilot = autopilot;
+	game->ai_speed = ai_speed;
+	game->court_radius = court_radius;
+	game->paddle_radius = paddle_radius;
+	game->ball_radius = ball_radius;
+	game->brick_radius = brick_radius;
+	game->paddle = glm::vec2(paddle_x[l], paddle_y);
+	game->paddle_color = paddle_color[l];
+	game->ball = glm::vec2(ball_x[l], ball_y[l]);
+	game->ball_velocity = glm::vec2(ball_velocity_x[l], ball_velocity_y[l]);
+	game->ball_color = ball_color[l];
+	game->ball_reset = ball_reset[l];
+	game->score = score[l];
+	game->misses = misses[l];
+	game->ai_offset = ai_offset[l];
+	game->ai_offset_update = ai_offset_update[l];
+	game->mt = mt[l];
+	game->swept = false; //(lanes play one-ball games, with the discrete rules)
+	game->extra_balls.clear();
+	game->brick_order.clear();
+	game->brick_columns.clear();
+	game->brick_grid.clear();
+	game->bricks.clear();
+	game->bricks.reserve(bricks_left[l]);
+	for (size_t i = 0; i < brick_alive.size(); ++i) {
+		if (!(brick_alive[i] & (1u << l))) continue;
+		game->bricks.emplace_back(glm::vec2(brick_x[i], brick_y[i]), brick_color[i]);
+	}
+}
+
+template struct BreakoutLanes< 8 >;
+template struct BreakoutLanes< 16 >;
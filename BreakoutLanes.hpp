@@ -0,0 +1,86 @@
+#pragma once
+
+#include "BreakoutGame.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <random>
+#include <cstdint>
+
+/*
+ * BreakoutLanes steps LANES independent Breakout games at once, with the same rules as
+ * BreakoutGame::update with discrete collisions (BreakoutGame::swept off: paddle warp, complementary
+ * pass-through, one brick per frame, ball reset on the floor, autopilot).
+ *
+ * State is stored structure-of-arrays: each "lane" is one game's paddle, ball, velocity, colors, and RNG;
+ * all lanes play the same level, and each brick has a bitmask of the lanes in which it is still alive.
+ *
+ * The expensive part of a frame -- finding the first brick each ball overlaps -- tests every lane
+ * against a brick at once (with SSE, four lanes per instruction, where available), and stops as soon
+ * as every lane has found its brick. The rest of the frame is per-lane and mirrors BreakoutGame exactly,
+ * so lane l plays bit-for-bit the same game as a BreakoutGame with the same seed
+ * (--fuzz-lanes checks this with random input on random levels, and BatchRunner's --validate-lanes
+ * for the games it plays -- so a rule change made to only one of them fails).
+ */
+
+template< uint32_t LANES >
+struct BreakoutLanes {
+	static_assert(LANES % 4 == 0 && LANES <= 32, "LANES should be a multiple of four (and fit in the alive bitmask)");
+
+	//every lane starts as a copy of 'start' (level, sizes, autopilot; not RNG state):
+	BreakoutLanes(BreakoutGame const &start);
+
+	void seed(uint32_t lane, uint32_t seed_) { mt[lane].seed(seed_); }
+
+	//restart the game in 'lane' from 'start' (which must have the same level as the constructor's 'start'):
+	void reset(uint32_t lane, BreakoutGame const &start);
+
+	//input for one lane (as BreakoutGame::launch and BreakoutGame::cycle_paddle_color):
+	// (the paddle is steered by writing paddle_x[lane] directly)
+	void launch(uint32_t lane);
+	void cycle_paddle_color(uint32_t lane) { paddle_color[lane] = (paddle_color[lane] + 1) % BreakoutGame::COLOR_COUNT; }
+
+	void update(float elapsed);
+
+	//same value as BreakoutGame::state_hash() for the game in 'lane':
+	uint64_t state_hash(uint32_t lane) const;
+
+	//copy the game in 'lane' into a BreakoutGame (e.g., to draw or keep playing it):
+	void get_game(uint32_t lane, BreakoutGame *game) const;
+
+	//----- shared state -----
+	bool autopilot = false;
+	float ai_speed = 0.0f;
+	glm::vec2 court_radius = glm::vec2(0.0f);
+	glm::vec2 paddle_radius = glm::vec2(0.0f);
+	glm::vec2 ball_radius = glm::vec2(0.0f);
+	glm::vec2 brick_radius = glm::vec2(0.0f);
+	float paddle_y = 0.0f;
+
+	//bricks (in the same order as BreakoutGame::bricks):
+	std::vector< float > brick_x;
+	std::vector< float > brick_y;
+	std::vector< color_t > brick_color;
+	std::vector< uint32_t > brick_alive; //bit l set => brick is still there in lane l
+
+	//----- per-lane state -----
+	float paddle_x[LANES];
+	float ball_x[LANES];
+	float ball_y[LANES];
+	float ball_velocity_x[LANES];
+	float ball_velocity_y[LANES];
+	uint32_t paddle_color[LANES];
+	uint32_t ball_color[LANES];
+	bool ball_reset[LANES];
+	int score[LANES];
+	int misses[LANES];
+	uint32_t bricks_left[LANES];
+	float ai_offset[LANES];
+	float ai_offset_update[LANES];
+	std::mt19937 mt[LANES];
+
+	//----- internals -----
+	//index of the first (alive, overlapping, non-complementary) brick hit by each lane's ball (or -1):
+	void find_hits(int32_t hit[LANES]) const;
+};
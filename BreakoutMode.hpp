@@ -1,98 +1,96 @@
-#include "ColorTextureProgram.hpp"
+#include "GLResources.hpp"
+#include "TrailProgram.hpp"
+#include "ParticleProgram.hpp"
+#include "BreakoutGame.hpp"
+#include "BallTrail.hpp"
+#include "Particles.hpp"
 
 #include "Mode.hpp"
 #include "GL.hpp"
 
 #include <vector>
-#include <deque>
-#include <utility>
-
-#define FROM_HEX( HX ) (glm::u8vec4((HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff, 0xff))
-
-typedef glm::u8vec4 color_t;
-typedef std::pair<color_t, color_t> color_pair;
-typedef std::vector<color_pair>::const_iterator color_iter;
+#include <string>
 
 /*
  * BreakoutMode is a game mode that implements Brick Breaker Colors:
  * Brick Breaker, except the color of the ball must match the color of the brick
  * to break it. More details in README
+ * (the game itself lives in BreakoutGame; this mode handles input and drawing)
  */
 
 struct BreakoutMode : Mode {
-	BreakoutMode();
+	//plays the level stored in 'level_file' (see Level.hpp), or the built-in level if empty:
+	BreakoutMode(std::string const &level_file = "");
 	virtual ~BreakoutMode();
 
+	//replace the bricks and court size with those of 'level':
+	void load_level(Level const &level);
+
 	//functions called by main loop:
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
 	virtual void draw(glm::uvec2 const &drawable_size) override;
+	virtual void resize(glm::uvec2 const &window_size, glm::uvec2 const &drawable_size) override;
+	virtual uint64_t state_hash() const override;
 
 	//----- game state -----
 
-    const color_t RED    = FROM_HEX(0xec3160);
-    const color_t YELLOW = FROM_HEX(0xf3f439);
-    const color_t BLUE   = FROM_HEX(0x1c8bc0);
-    const color_t GREEN  = FROM_HEX(0x12b65f);
-    const color_t PURPLE = FROM_HEX(0xce5bf6);
-    const color_t ORANGE = FROM_HEX(0xf48f12);
+	BreakoutGame game;
+	uint32_t split_count = 2; //balls added by each press of 'M' (multi-ball)
+	float pause_draw_budget = 0.002f; //while paused ('P'), a draw slower than this (seconds) is cached instead (see Mode::Layer)
 
-    std::vector<color_pair> COLORS;
+	//----- pretty rainbow trails -----
 
-	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
-	glm::vec2 paddle_radius = glm::vec2(1.0f, 0.2f);
-	glm::vec2 ball_radius = glm::vec2(0.1f, 0.1f);
-    glm::vec2 brick_radius = glm::vec2(0.5f, 0.3f);
-    glm::vec2 score_radius = glm::vec2(0.1f, 0.1f);
+	BallTrail ball_trail; //(ball_trail.length is the trail length, in seconds)
 
-    glm::vec2 paddle = glm::vec2(0.0f, -court_radius.y + 0.5);
-    color_iter paddle_color;
+	//----- brick debris -----
 
-	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
-	glm::vec2 ball_velocity = glm::vec2(0.0f, 0.0f);
-    color_iter ball_color;
+	Particles particles;
+	uint32_t particles_per_brick = 48;
 
-    struct Brick {
-        Brick(glm::vec2 const &Position_, glm::u8vec4 const &Color_) :
-            Position(Position_), Color(Color_) { }
-        glm::vec2 Position;
-        glm::u8vec4 Color;
-    };
+	//----- opengl assets / helpers ------
 
-    std::vector<Brick> bricks;
+	//draw functions will work on vectors of vertices, defined as follows:
+	typedef PosColTexVertex Vertex;
 
-    bool ball_reset = true;
+	//Shader program that draws transformed, vertices tinted with vertex colors:
+	std::shared_ptr< ColorTextureProgram > color_texture_program = get_shared< ColorTextureProgram >();
 
-    int score = 0;
+	//Vertex buffer + vertex array object that maps it to color_texture_program attribute locations:
+	std::shared_ptr< ColorTextureBuffers > buffers = get_shared< ColorTextureBuffers >();
 
+	//Solid white texture:
+	std::shared_ptr< WhiteTexture > white_tex = get_shared< WhiteTexture >();
 
-	//----- opengl assets / helpers ------
+	//Program that draws the ball trail from its samples, and the trail's colors:
+	std::shared_ptr< TrailProgram > trail_program = get_shared< TrailProgram >();
+	std::shared_ptr< RainbowPaletteTexture > rainbow_palette = get_shared< RainbowPaletteTexture >();
 
-	//draw functions will work on vectors of vertices, defined as follows:
-	struct Vertex {
-		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
-			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
-		glm::vec3 Position;
-		glm::u8vec4 Color;
-		glm::vec2 TexCoord;
-	};
-	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "BreakoutMode::Vertex should be packed");
+	//Program that draws the particles (instanced):
+	std::shared_ptr< ParticleProgram > particle_program = get_shared< ParticleProgram >();
 
-	//Shader program that draws transformed, vertices tinted with vertex colors:
-	ColorTextureProgram color_texture_program;
+	//append the triangles that draw the current game state (in court space) to 'vertices':
+	// if 'effects_start' is given, the particles and ball trail are left out (draw() has the GPU draw them) and
+	// *effects_start is where in 'vertices' they belong; otherwise they are built on the CPU
+	// (draw() uploads and draws these; benchmarks and other renderers can use them directly)
+	void build_vertices(std::vector< Vertex > *vertices, size_t *effects_start = nullptr) const;
 
-	//Buffer used to hold vertex data during drawing:
-	GLuint vertex_buffer = 0;
+	//draw()'s vertex list (a member, so drawing doesn't allocate once it has grown):
+	std::vector< Vertex > vertices;
 
-	//Vertex Array Object that maps buffer locations to color_texture_program attribute locations:
-	GLuint vertex_buffer_for_color_texture_program = 0;
+	//other useful drawing constants:
+	float wall_radius = 0.05f;
+	float shadow_offset = 0.07f;
+	float padding = 0.14f; //padding between outside of walls and edge of window
+	glm::vec2 score_radius = glm::vec2(0.1f, 0.1f);
+	glm::u8vec4 bg_color = glm::u8vec4(0xf3, 0xff, 0xc6, 0xff); //(some nice colors from the course web page)
 
-	//Solid white texture:
-	GLuint white_tex = 0;
+	//matrix that maps from court-space coordinates to clip coordinates (used as OBJECT_TO_CLIP):
+	glm::mat4 court_to_clip = glm::mat4(1.0f);
 
 	//matrix that maps from clip coordinates to court-space coordinates:
 	glm::mat3x2 clip_to_court = glm::mat3x2(1.0f);
-	// computed in draw() as the inverse of OBJECT_TO_CLIP
-	// (stored here so that the mouse handling code can use it to position the paddle)
+	// both computed in resize(), since they only depend on the window's aspect ratio
+	// (stored here so that the mouse handling code can use clip_to_court to position the paddle)
 
 };
@@ -0,0 +1,83 @@
+#include "BrickGrid.hpp"
+
+void BrickGrid::clear() {
+	count = 0;
+	cells = glm::uvec2(0);
+	first.clear();
+	entries.clear();
+}
+
+void BrickGrid::build(std::vector< glm::vec2 > const &centers, glm::vec2 const &radius) {
+	clear();
+	count = uint32_t(centers.size());
+	if (centers.empty()) return;
+
+	glm::vec2 lo = centers[0], hi = centers[0];
+	for (glm::vec2 const &c : centers) {
+		lo = glm::min(lo, c);
+		hi = glm::max(hi, c);
+	}
+	lo -= radius;
+	hi += radius;
+
+	//cells the size of a box (so each box is in at most four), but coarser if the boxes are spread thin:
+	cell_size = glm::max(2.0f * radius, glm::vec2(1e-3f));
+	while (true) {
+		cells = glm::uvec2(glm::max(glm::ceil((hi - lo) / cell_size), glm::vec2(1.0f)));
+		if (uint64_t(cells.x) * cells.y <= 4 * uint64_t(count) + 16) break;
+		cell_size *= 2.0f;
+	}
+	origin = lo;
+
+	//boxes go in every cell they overlap -- and, so rounding in walk() can't miss one, in cells they nearly overlap:
+	glm::vec2 margin = 1e-3f * cell_size;
+	auto cell_range = [&](glm::vec2 const &c, glm::uvec2 *min, glm::uvec2 *max) {
+		glm::vec2 a = glm::floor((c - radius - margin - origin) / cell_size);
+		glm::vec2 b = glm::floor((c + radius + margin - origin) / cell_size);
+		*min = glm::uvec2(glm::clamp(a, glm::vec2(0.0f), glm::vec2(cells) - 1.0f));
+		*max = glm::uvec2(glm::clamp(b, glm::vec2(0.0f), glm::vec2(cells) - 1.0f));
+	};
+
+	//count, then fill (so each cell's entries are contiguous, in order of box index):
+	first.assign(cells.x * cells.y + 1, 0);
+	for (glm::vec2 const &c : centers) {
+		glm::uvec2 min, max;
+		cell_range(c, &min, &max);
+		for (uint32_t y = min.y; y <= max.y; ++y) {
+			for (uint32_t x = min.x; x <= max.x; ++x) {
+				first[y * cells.x + x + 1] += 1;
+			}
+		}
+	}
+	for (size_t i = 1; i < first.size(); ++i) {
+		first[i] += first[i - 1];
+	}
+	entries.resize(first.back());
+	std::vector< uint32_t > fill(first.begin(), first.end() - 1);
+	for (uint32_t i = 0; i < count; ++i) {
+		glm::uvec2 min, max;
+		cell_range(centers[i], &min, &max);
+		for (uint32_t y = min.y; y <= max.y; ++y) {
+			for (uint32_t x = min.x; x <= max.x; ++x) {
+				entries[fill[y * cells.x + x]++] = i;
+			}
+		}
+	}
+}
+
+void BrickGrid::compact(std::vector< uint8_t > const &dead, std::vector< uint32_t > const &remap) {
+	//slide each cell's surviving entries down (cells stay in order, so 'first' can be rewritten as we go):
+	uint32_t out = 0;
+	for (size_t c = 0; c + 1 < first.size(); ++c) {
+		uint32_t begin = first[c];
+		uint32_t end = first[c + 1];
+		first[c] = out;
+		for (uint32_t i = begin; i < end; ++i) {
+			if (dead[entries[i]]) continue;
+			entries[out++] = remap[entries[i]];
+		}
+	}
+	if (!first.empty()) first.back() = out;
+	entries.resize(out);
+	count -= uint32_t(std::count(dead.begin(), dead.begin() + count, uint8_t(1)));
+}
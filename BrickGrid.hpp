@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+
+/*
+ * BrickGrid is a uniform grid over same-size boxes (Breakout's bricks, grown by the ball's radius),
+ * for finding the boxes a moving point (the ball's center) might run into:
+ * walk() visits the cells along a segment in order, so a search can stop once it has a hit
+ * earlier than the next cell.
+ *
+ * Each cell lists the boxes that overlap it (a range of 'entries', starting at 'first[cell]').
+ * Boxes keep their indices while the caller marks them dead; compact() then drops them all (and renumbers
+ * the rest to match the caller's compacted array) in one pass, without a rebuild.
+ */
+
+struct BrickGrid {
+	//(re)build for boxes of 'radius' centered at 'centers':
+	void build(std::vector< glm::vec2 > const &centers, glm::vec2 const &radius);
+	void clear();
+
+	//the boxes marked in 'dead' were erased from the caller's array, and box i (if not dead) is now box remap[i]:
+	void compact(std::vector< uint8_t > const &dead, std::vector< uint32_t > const &remap);
+
+	//call visit(begin, end, enter) for each cell the segment from 'from' to 'from + delta' passes through, in order,
+	// where [begin,end) are the indices of the boxes in the cell and 'enter' is when (as a fraction of delta)
+	// the segment enters the cell; stops if visit returns false:
+	template< typename Visit >
+	void walk(glm::vec2 const &from, glm::vec2 const &delta, Visit const &visit) const;
+
+	uint32_t count = 0; //boxes in the grid
+
+	//----- internals -----
+	glm::vec2 origin = glm::vec2(0.0f); //lower-left corner of cell (0,0)
+	glm::vec2 cell_size = glm::vec2(1.0f);
+	glm::uvec2 cells = glm::uvec2(0);
+	std::vector< uint32_t > first; //cells.x * cells.y + 1 offsets into entries
+	std::vector< uint32_t > entries; //box indices
+};
+
+template< typename Visit >
+void BrickGrid::walk(glm::vec2 const &from, glm::vec2 const &delta, Visit const &visit) const {
+	if (cells.x == 0 || cells.y == 0) return;
+
+	//clip the segment to the grid:
+	glm::vec2 lo = origin;
+	glm::vec2 hi = origin + cell_size * glm::vec2(cells);
+	float t0 = 0.0f, t1 = 1.0f;
+	for (uint32_t k = 0; k < 2; ++k) {
+		if (delta[k] == 0.0f) {
+			if (from[k] < lo[k] || from[k] > hi[k]) return;
+			continue;
+		}
+		float a = (lo[k] - from[k]) / delta[k];
+		float b = (hi[k] - from[k]) / delta[k];
+		t0 = std::max(t0, std::min(a, b));
+		t1 = std::min(t1, std::max(a, b));
+	}
+	if (t0 > t1) return;
+
+	//step from cell to cell (Amanatides and Woo's traversal), crossing whichever cell edge comes first:
+	float const Never = std::numeric_limits< float >::infinity();
+	int32_t cell[2], step[2];
+	float next[2], span[2]; //when the segment crosses the next edge on each axis; time between edges
+	for (uint32_t k = 0; k < 2; ++k) {
+		float start = (from[k] + t0 * delta[k] - origin[k]) / cell_size[k];
+		cell[k] = std::min(std::max(int32_t(std::floor(start)), 0), int32_t(cells[k]) - 1);
+		if (delta[k] > 0.0f) {
+			step[k] = 1;
+			next[k] = (origin[k] + (cell[k] + 1) * cell_size[k] - from[k]) / delta[k];
+			span[k] = cell_size[k] / delta[k];
+		} else if (delta[k] < 0.0f) {
+			step[k] = -1;
+			next[k] = (origin[k] + cell[k] * cell_size[k] - from[k]) / delta[k];
+			span[k] = -cell_size[k] / delta[k];
+		} else {
+			step[k] = 0;
+			next[k] = Never;
+			span[k] = Never;
+		}
+	}
+
+	float enter = t0;
+	while (true) {
+		uint32_t c = uint32_t(cell[1]) * cells.x + uint32_t(cell[0]);
+		if (!visit(entries.data() + first[c], entries.data() + first[c + 1], enter)) return;
+		uint32_t k = (next[0] < next[1] ? 0 : 1);
+		enter = next[k];
+		if (enter > t1) return;
+		cell[k] += step[k];
+		if (cell[k] < 0 || cell[k] >= int32_t(cells[k])) return;
+		next[k] += span[k];
+	}
+}
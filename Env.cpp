@@ -0,0 +1,408 @@
+#include "Env.hpp"
+
+#include "ThreadPool.hpp"
+#include "load_save_png.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <random>
+#include <cstring>
+
+//seed for episode 'episode' of game 'index' (a mix of all three, so nearby seeds don't give related games):
+static uint32_t episode_seed(uint32_t seed, uint32_t index, uint32_t episode) {
+	uint64_t x = (uint64_t(seed) << 32) ^ (uint64_t(index) * 0x9e3779b97f4a7c15ull) ^ (uint64_t(episode) * 0xc2b2ae3d27d4eb4full);
+	//(splitmix64 finalizer)
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	x = x ^ (x >> 31);
+	return uint32_t(x);
+}
+
+//----- low-resolution frames -----
+//(frames are drawn with axis-aligned rectangles, like the game modes draw; the court fills the frame, keeping its aspect)
+
+namespace {
+struct FrameTarget {
+	FrameTarget(glm::u8vec4 *pixels_, glm::uvec2 const &size_, glm::vec2 const &court_radius) : pixels(pixels_), size(size_) {
+		scale = std::min(size.x / (2.0f * court_radius.x), size.y / (2.0f * court_radius.y));
+		center = 0.5f * glm::vec2(size);
+	}
+	glm::u8vec4 *pixels;
+	glm::uvec2 size;
+	float scale;
+	glm::vec2 center;
+
+	void clear(glm::u8vec4 const &color) {
+		std::fill(pixels, pixels + size.x * size.y, color);
+	}
+
+	//fill the pixels whose centers are inside the rectangle (court coordinates, y up):
+	void fill(glm::vec2 const &at, glm::vec2 const &radius, glm::u8vec4 const &color) {
+		float x0 = center.x + (at.x - radius.x) * scale;
+		float x1 = center.x + (at.x + radius.x) * scale;
+		float y0 = center.y - (at.y + radius.y) * scale; //(rows go down)
+		float y1 = center.y - (at.y - radius.y) * scale;
+		int32_t min_x = std::max(0, int32_t(std::ceil(x0 - 0.5f)));
+		int32_t max_x = std::min(int32_t(size.x), int32_t(std::ceil(x1 - 0.5f)));
+		int32_t min_y = std::max(0, int32_t(std::ceil(y0 - 0.5f)));
+		int32_t max_y = std::min(int32_t(size.y), int32_t(std::ceil(y1 - 0.5f)));
+		for (int32_t y = min_y; y < max_y; ++y) {
+			glm::u8vec4 *row = pixels + y * size.x;
+			std::fill(row + min_x, row + std::max(min_x, max_x), color);
+		}
+	}
+};
+
+//same colors as the game modes:
+const glm::u8vec4 bg_color = glm::u8vec4(0xf3, 0xff, 0xc6, 0xff);
+const glm::u8vec4 fg_color = glm::u8vec4(0x00, 0x00, 0x00, 0xff);
+}
+
+//----- Breakout -----
+
+BreakoutEnv::BreakoutEnv(Level const &level, EnvOptions const &options_) : options(options_) {
+	if (options.frame_skip == 0) throw std::runtime_error("Environments need a frame_skip of at least one.");
+	start.load_level(level);
+	start.autopilot = false;
+	start.swept = false; //(lanes play the discrete rules)
+
+	for (uint32_t first = 0; first < options.count; first += Lanes) {
+		groups.emplace_back(new BreakoutLanes< Lanes >(start));
+	}
+	episodes.assign(options.count, 0);
+	steps.assign(options.count, 0);
+}
+
+BreakoutEnv::~BreakoutEnv() {
+}
+
+void BreakoutEnv::reset_game(uint32_t index) {
+	BreakoutLanes< Lanes > &lanes = *groups[index / Lanes];
+	uint32_t l = index % Lanes;
+
+	lanes.reset(l, start);
+	lanes.seed(l, episode_seed(base_seed, index, episodes[index]));
+
+	//the episode seed picks where the paddle starts and its color:
+	std::mt19937 &mt = lanes.mt[l];
+	float range = start.court_radius.x - start.paddle_radius.x;
+	lanes.paddle_x[l] = (mt() / float(mt.max())) * 2.0f * range - range;
+	lanes.paddle_color[l] = mt() % BreakoutGame::COLOR_COUNT;
+	if (lanes.ball_reset[l]) {
+		lanes.ball_x[l] = lanes.paddle_x[l];
+		lanes.ball_y[l] = lanes.paddle_y + lanes.ball_radius.y;
+	}
+
+	steps[index] = 0;
+}
+
+void BreakoutEnv::observe(uint32_t index, EnvBuffers const &out) const {
+	BreakoutLanes< Lanes > const &lanes = *groups[index / Lanes];
+	uint32_t l = index % Lanes;
+
+	if (out.state) {
+		float *state = out.state + size_t(index) * StateSize;
+		state[0] = lanes.ball_x[l];
+		state[1] = lanes.ball_y[l];
+		state[2] = lanes.ball_velocity_x[l];
+		state[3] = lanes.ball_velocity_y[l];
+		state[4] = lanes.paddle_x[l];
+		state[5] = float(lanes.paddle_color[l]);
+		state[6] = float(lanes.ball_color[l]);
+		state[7] = (lanes.ball_reset[l] ? 1.0f : 0.0f);
+	}
+
+	if (out.bricks) {
+		uint8_t *bits = out.bricks + size_t(index) * brick_bytes();
+		std::memset(bits, 0, brick_bytes());
+		uint32_t mask = 1u << l;
+		for (size_t i = 0; i < lanes.brick_alive.size(); ++i) {
+			if (lanes.brick_alive[i] & mask) bits[i / 8] |= uint8_t(1u << (i % 8));
+		}
+	}
+
+	if (out.frames) {
+		FrameTarget frame(out.frames + size_t(index) * options.frame_size.x * options.frame_size.y, options.frame_size, start.court_radius);
+		frame.clear(bg_color);
+		uint32_t mask = 1u << l;
+		for (size_t i = 0; i < lanes.brick_alive.size(); ++i) {
+			if (lanes.brick_alive[i] & mask) frame.fill(glm::vec2(lanes.brick_x[i], lanes.brick_y[i]), lanes.brick_radius, lanes.brick_color[i]);
+		}
+		frame.fill(glm::vec2(lanes.paddle_x[l], lanes.paddle_y), lanes.paddle_radius, BreakoutGame::COLORS[lanes.paddle_color[l]].first);
+		frame.fill(glm::vec2(lanes.ball_x[l], lanes.ball_y[l]), lanes.ball_radius, BreakoutGame::COLORS[lanes.ball_color[l]].first);
+	}
+}
+
+void BreakoutEnv::reset(uint32_t seed, EnvBuffers const &out) {
+	if (out.frames && (options.frame_size.x == 0 || options.frame_size.y == 0)) {
+		throw std::runtime_error("Frames were requested, but EnvOptions::frame_size is zero.");
+	}
+	base_seed = seed;
+	for (uint32_t index = 0; index < options.count; ++index) {
+		episodes[index] = 0;
+		reset_game(index);
+		observe(index, out);
+	}
+}
+
+void BreakoutEnv::step_group(uint32_t group) {
+	uint8_t const *actions = pending_actions;
+	EnvBuffers const &out = *pending_out;
+
+	BreakoutLanes< Lanes > &lanes = *groups[group];
+	uint32_t first = group * Lanes;
+	uint32_t count = std::min(Lanes, options.count - first);
+
+	float reward[Lanes];
+	bool done[Lanes];
+	for (uint32_t l = 0; l < count; ++l) {
+		reward[l] = 0.0f;
+		done[l] = false;
+		//one-shot actions apply once per step:
+		uint8_t action = actions[first + l];
+		if (action == Launch) lanes.launch(l);
+		else if (action == NextColor) lanes.cycle_paddle_color(l);
+	}
+
+	for (uint32_t skip = 0; skip < options.frame_skip; ++skip) {
+		int score[Lanes], misses[Lanes];
+		for (uint32_t l = 0; l < count; ++l) {
+			uint8_t action = actions[first + l];
+			if (action == Left) lanes.paddle_x[l] -= options.paddle_speed * options.step;
+			else if (action == Right) lanes.paddle_x[l] += options.paddle_speed * options.step;
+			score[l] = lanes.score[l];
+			misses[l] = lanes.misses[l];
+		}
+
+		lanes.update(options.step);
+
+		for (uint32_t l = 0; l < count; ++l) {
+			if (done[l]) continue; //(finished games keep stepping with the others until the step ends)
+			reward[l] += float(lanes.score[l] - score[l]) - float(lanes.misses[l] - misses[l]);
+			if (lanes.bricks_left[l] == 0) done[l] = true;
+		}
+	}
+
+	for (uint32_t l = 0; l < count; ++l) {
+		uint32_t index = first + l;
+		steps[index] += 1;
+		if (options.max_steps != 0 && steps[index] >= options.max_steps) done[l] = true;
+		if (done[l]) {
+			episodes[index] += 1;
+			reset_game(index);
+		}
+		if (out.rewards) out.rewards[index] = reward[l];
+		if (out.dones) out.dones[index] = (done[l] ? 1 : 0);
+		observe(index, out);
+	}
+}
+
+void BreakoutEnv::step(uint8_t const *actions, EnvBuffers const &out, ThreadPool *pool) {
+	pending_actions = actions;
+	pending_out = &out;
+	if (pool) {
+		for (uint32_t group = 0; group < groups.size(); ++group) {
+			pool->submit([this, group]() { step_group(group); });
+		}
+		pool->wait();
+	} else {
+		for (uint32_t group = 0; group < groups.size(); ++group) {
+			step_group(group);
+		}
+	}
+	pending_actions = nullptr;
+	pending_out = nullptr;
+}
+
+//----- Pong -----
+
+PongEnv::PongEnv(EnvOptions const &options_, uint32_t points_to_win_) : options(options_), points_to_win(points_to_win_) {
+	if (options.frame_skip == 0) throw std::runtime_error("Environments need a frame_skip of at least one.");
+	if (points_to_win == 0) throw std::runtime_error("Pong episodes need at least one point to win.");
+	games.resize(options.count);
+	episodes.assign(options.count, 0);
+	steps.assign(options.count, 0);
+}
+
+void PongEnv::reset_game(uint32_t index) {
+	games[index] = PongGame();
+	games[index].seed(episode_seed(base_seed, index, episodes[index]));
+	steps[index] = 0;
+}
+
+void PongEnv::observe(uint32_t index, EnvBuffers const &out) const {
+	PongGame const &game = games[index];
+
+	if (out.state) {
+		float *state = out.state + size_t(index) * StateSize;
+		state[0] = game.ball.x;
+		state[1] = game.ball.y;
+		state[2] = game.ball_velocity.x;
+		state[3] = game.ball_velocity.y;
+		state[4] = game.left_paddle.y;
+		state[5] = game.right_paddle.y;
+	}
+
+	if (out.frames) {
+		FrameTarget frame(out.frames + size_t(index) * options.frame_size.x * options.frame_size.y, options.frame_size, game.court_radius);
+		frame.clear(bg_color);
+		frame.fill(game.left_paddle, game.paddle_radius, fg_color);
+		frame.fill(game.right_paddle, game.paddle_radius, fg_color);
+		frame.fill(game.ball, game.ball_radius, fg_color);
+	}
+}
+
+void PongEnv::reset(uint32_t seed, EnvBuffers const &out) {
+	if (out.frames && (options.frame_size.x == 0 || options.frame_size.y == 0)) {
+		throw std::runtime_error("Frames were requested, but EnvOptions::frame_size is zero.");
+	}
+	base_seed = seed;
+	for (uint32_t index = 0; index < options.count; ++index) {
+		episodes[index] = 0;
+		reset_game(index);
+		observe(index, out);
+	}
+}
+
+void PongEnv::step_group(uint32_t group) {
+	uint8_t const *actions = pending_actions;
+	EnvBuffers const &out = *pending_out;
+
+	uint32_t first = group * GroupSize;
+	uint32_t last = std::min(first + GroupSize, options.count);
+	for (uint32_t index = first; index < last; ++index) {
+		PongGame &game = games[index];
+		uint8_t action = actions[index];
+
+		float reward = 0.0f;
+		bool done = false;
+		for (uint32_t skip = 0; skip < options.frame_skip && !done; ++skip) {
+			if (action == Up) game.left_paddle.y += options.paddle_speed * options.step;
+			else if (action == Down) game.left_paddle.y -= options.paddle_speed * options.step;
+
+			uint32_t left_score = game.left_score;
+			uint32_t right_score = game.right_score;
+			game.update(options.step);
+			reward += float(game.left_score - left_score) - float(game.right_score - right_score);
+
+			if (game.left_score >= points_to_win || game.right_score >= points_to_win) done = true;
+		}
+
+		steps[index] += 1;
+		if (options.max_steps != 0 && steps[index] >= options.max_steps) done = true;
+		if (done) {
+			episodes[index] += 1;
+			reset_game(index);
+		}
+		if (out.rewards) out.rewards[index] = reward;
+		if (out.dones) out.dones[index] = (done ? 1 : 0);
+		observe(index, out);
+	}
+}
+
+void PongEnv::step(uint8_t const *actions, EnvBuffers const &out, ThreadPool *pool) {
+	pending_actions = actions;
+	pending_out = &out;
+	uint32_t group_count = (options.count + GroupSize - 1) / GroupSize;
+	if (pool) {
+		for (uint32_t group = 0; group < group_count; ++group) {
+			pool->submit([this, group]() { step_group(group); });
+		}
+		pool->wait();
+	} else {
+		for (uint32_t group = 0; group < group_count; ++group) {
+			step_group(group);
+		}
+	}
+	pending_actions = nullptr;
+	pending_out = nullptr;
+}
+
+//----- benchmark -----
+
+void run_env_bench(EnvBenchOptions const &options, std::ostream &out) {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	if (options.game != "breakout" && options.game != "pong") {
+		throw std::runtime_error("Unknown environment '" + options.game + "' (expecting 'breakout' or 'pong').");
+	}
+
+	EnvOptions env_options;
+	env_options.count = options.count;
+	env_options.max_steps = 10000;
+	if (options.frame_png != "") env_options.frame_size = glm::uvec2(84, 84);
+
+	std::unique_ptr< BreakoutEnv > breakout;
+	std::unique_ptr< PongEnv > pong;
+	uint32_t state_size, brick_bytes = 0, action_count;
+	if (options.game == "breakout") {
+		breakout.reset(new BreakoutEnv(*BreakoutGame::open_level(options.level_file), env_options));
+		state_size = breakout->state_size();
+		brick_bytes = breakout->brick_bytes();
+		action_count = BreakoutEnv::ActionCount;
+	} else {
+		pong.reset(new PongEnv(env_options));
+		state_size = pong->state_size();
+		action_count = PongEnv::ActionCount;
+	}
+
+	//caller-owned buffers (allocated once, up front):
+	std::vector< float > state(size_t(options.count) * state_size);
+	std::vector< uint8_t > bricks(size_t(options.count) * brick_bytes);
+	std::vector< glm::u8vec4 > frames(size_t(options.count) * env_options.frame_size.x * env_options.frame_size.y);
+	std::vector< float > rewards(options.count);
+	std::vector< uint8_t > dones(options.count);
+
+	EnvBuffers buffers;
+	buffers.state = state.data();
+	buffers.bricks = (bricks.empty() ? nullptr : bricks.data());
+	buffers.frames = (frames.empty() ? nullptr : frames.data());
+	buffers.rewards = rewards.data();
+	buffers.dones = dones.data();
+
+	//random actions (made ahead of time, so the timing is of the environment, not the RNG):
+	std::vector< std::vector< uint8_t > > actions(64, std::vector< uint8_t >(options.count));
+	std::mt19937 mt(options.seed);
+	for (auto &batch : actions) {
+		for (auto &action : batch) action = uint8_t(mt() % action_count);
+	}
+
+	std::unique_ptr< ThreadPool > pool;
+	if (options.threads != 1) pool.reset(new ThreadPool(options.threads));
+
+	if (breakout) breakout->reset(options.seed, buffers);
+	else pong->reset(options.seed, buffers);
+
+	uint64_t steps = 0;
+	uint64_t episodes = 0;
+	double total_reward = 0.0;
+	auto before = Clock::now();
+	double wall = 0.0;
+	while (wall < options.seconds) {
+		//(check the clock every few batches)
+		for (uint32_t i = 0; i < 16; ++i) {
+			uint8_t const *batch = actions[steps % actions.size()].data();
+			if (breakout) breakout->step(batch, buffers, pool.get());
+			else pong->step(batch, buffers, pool.get());
+			steps += 1;
+			for (uint32_t index = 0; index < options.count; ++index) {
+				episodes += dones[index];
+				total_reward += rewards[index];
+			}
+		}
+		wall = std::chrono::duration< double >(Clock::now() - before).count();
+	}
+
+	out << "Stepped " << options.count << " " << options.game << " environments " << steps << " times on "
+		<< (pool ? pool->size() : 1) << " threads in " << wall << "s"
+		<< (buffers.frames ? " (with 84x84 frames)" : "") << ":\n";
+	out << "  " << (steps * options.count / wall) << " env steps/sec; " << (steps / wall) << " batched steps/sec.\n";
+	out << "  " << episodes << " episodes finished; mean reward per env step " << (total_reward / double(steps * options.count)) << ".\n";
+
+	if (options.frame_png != "") {
+		save_png(options.frame_png, env_options.frame_size, frames.data(), UpperLeftOrigin);
+		out << "Wrote game 0's last frame to '" << options.frame_png << "'.\n";
+	}
+	out.flush();
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "BreakoutGame.hpp"
+#include "BreakoutLanes.hpp"
+#include "PongGame.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <iostream>
+#include <cstdint>
+
+struct ThreadPool;
+
+/*
+ * Environments step many Breakout (or Pong) games at once, for training agents:
+ *   reset(seed, out) starts every game and writes the first observations;
+ *   step(actions, out) applies one action per game, steps them all, and writes observations, rewards, and dones.
+ *
+ * Observations go straight into caller-owned buffers (EnvBuffers) laid out contiguously,
+ * game after game -- so nothing is allocated or copied per step, and the buffers can be
+ * handed to (e.g.) a tensor library as-is.
+ *
+ * A game that finishes during a step is restarted immediately (with the next seed of its
+ * sequence); its 'dones' entry is set, and its observation is the first of the new episode.
+ * Episode seeds are a pure function of the reset() seed, the game's index, and the episode number,
+ * so a run is reproducible no matter how many threads step it.
+ *
+ * Breakout environments step BreakoutLanes, so they play the discrete rules (BreakoutGame::swept off),
+ * not the swept ones BreakoutMode plays.
+ */
+
+//caller-owned output buffers for 'count' games (any pointer may be null to skip that output):
+struct EnvBuffers {
+	float *state = nullptr; //count x state_size floats
+	uint8_t *bricks = nullptr; //count x brick_bytes bytes; bit (i%8) of byte (i/8) is set if brick i is still there (Breakout only)
+	glm::u8vec4 *frames = nullptr; //count x frame_size.x x frame_size.y pixels, RGBA, row-major with the upper left pixel first
+	float *rewards = nullptr; //count floats (written by step())
+	uint8_t *dones = nullptr; //count bytes: 1 if the game finished during the step (written by step())
+};
+
+struct EnvOptions {
+	uint32_t count = 16; //number of games
+	float step = 1.0f / 60.0f; //simulation time step (seconds)
+	uint32_t frame_skip = 1; //simulation steps per step() (rewards are summed over them)
+	uint32_t max_steps = 0; //episode ends after this many step()s (0 => no limit)
+	glm::uvec2 frame_size = glm::uvec2(0); //size of rendered frames (0 => EnvBuffers::frames must be null)
+	float paddle_speed = 8.0f; //court units / second for move actions
+};
+
+//Breakout: the state vector is
+//  ball.x, ball.y, ball_velocity.x, ball_velocity.y, paddle.x, paddle_color, ball_color, ball_reset
+//reward is +1 per brick broken and -1 per miss; episodes end when the level is cleared (or at max_steps).
+struct BreakoutEnv {
+	enum Action : uint8_t {
+		Noop = 0,
+		Left,
+		Right,
+		Launch,
+		NextColor,
+		ActionCount
+	};
+	static const uint32_t StateSize = 8;
+
+	//every game plays 'level':
+	BreakoutEnv(Level const &level, EnvOptions const &options);
+	~BreakoutEnv();
+
+	//(re)start every game; episode seeds are derived from 'seed':
+	void reset(uint32_t seed, EnvBuffers const &out);
+	//'actions' holds one Action per game; if 'pool' is given, groups of games are stepped on it in parallel:
+	void step(uint8_t const *actions, EnvBuffers const &out, ThreadPool *pool = nullptr);
+
+	uint32_t state_size() const { return StateSize; }
+	uint32_t brick_bytes() const { return (uint32_t(start.bricks.size()) + 7) / 8; }
+
+	EnvOptions options;
+
+	//----- internals -----
+	static const uint32_t Lanes = 16;
+	BreakoutGame start; //every episode starts as a copy of this (with the paddle placed by the episode seed)
+	std::vector< std::unique_ptr< BreakoutLanes< Lanes > > > groups; //game i is lane (i % Lanes) of group (i / Lanes)
+
+	uint32_t base_seed = 0;
+	std::vector< uint32_t > episodes; //per game
+	std::vector< uint32_t > steps; //per game, in the current episode
+
+	//(what step() is working on, so jobs only need to know their group)
+	uint8_t const *pending_actions = nullptr;
+	EnvBuffers const *pending_out = nullptr;
+
+	void reset_game(uint32_t index);
+	void step_group(uint32_t group);
+	void observe(uint32_t index, EnvBuffers const &out) const;
+};
+
+//Pong: the state vector is
+//  ball.x, ball.y, ball_velocity.x, ball_velocity.y, left_paddle.y, right_paddle.y
+//the agent plays the left paddle against the AI; reward is +1 per point won and -1 per point lost;
+//episodes end when either side reaches points_to_win (or at max_steps).
+struct PongEnv {
+	enum Action : uint8_t {
+		Noop = 0,
+		Up,
+		Down,
+		ActionCount
+	};
+	static const uint32_t StateSize = 6;
+
+	PongEnv(EnvOptions const &options, uint32_t points_to_win = 5);
+
+	void reset(uint32_t seed, EnvBuffers const &out);
+	void step(uint8_t const *actions, EnvBuffers const &out, ThreadPool *pool = nullptr);
+
+	uint32_t state_size() const { return StateSize; }
+
+	EnvOptions options;
+	uint32_t points_to_win;
+
+	//----- internals -----
+	static const uint32_t GroupSize = 64; //games per job when stepping on a pool
+	std::vector< PongGame > games;
+
+	uint32_t base_seed = 0;
+	std::vector< uint32_t > episodes;
+	std::vector< uint32_t > steps;
+
+	uint8_t const *pending_actions = nullptr;
+	EnvBuffers const *pending_out = nullptr;
+
+	void reset_game(uint32_t index);
+	void step_group(uint32_t group);
+	void observe(uint32_t index, EnvBuffers const &out) const;
+};
+
+//----- benchmark (--env-bench) -----
+
+struct EnvBenchOptions {
+	std::string game = "breakout"; //"breakout" or "pong"
+	uint32_t count = 1024; //games stepped at once
+	uint32_t threads = 0; //0 => one per hardware thread; 1 => step on the calling thread
+	uint32_t seed = 0;
+	std::string level_file = ""; //(Breakout; empty => built-in level)
+	float seconds = 2.0f; //how long to step for
+	std::string frame_png = ""; //if set, also render frames (84x84) and save game 0's last frame here
+};
+
+//step random actions for options.seconds and report steps/sec (and episode stats) to 'out':
+void run_env_bench(EnvBenchOptions const &options, std::ostream &out);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ColorTextureProgram.hpp"
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <mutex>
+
+/*
+ * OpenGL resources that every mode needs (shader programs, textures, buffers)
+ * are shared through a small reference-counted registry, so constructing a new
+ * mode (e.g., in Mode::set_current) doesn't recompile shaders or re-upload textures.
+ */
+
+//get_shared< T >() returns the live T if anyone still holds a reference to one,
+// otherwise it constructs a fresh T. The T is freed when the last reference is dropped.
+//(e.g., switching from PongMode to BreakoutMode: the new mode is constructed while the
+// old one is still current, so the program/texture/buffers are simply handed over.)
+//Safe to call from the ModeLoader worker thread.
+template< typename T >
+std::shared_ptr< T > get_shared() {
+	static std::mutex mutex;
+	static std::weak_ptr< T > cache;
+	std::unique_lock< std::mutex > lock(mutex);
+	std::shared_ptr< T > ret = cache.lock();
+	if (!ret) {
+		ret = std::make_shared< T >();
+		cache = ret;
+	}
+	return ret;
+}
+
+//Vertex format used by the modes' draw functions (and understood by ColorTextureBuffers):
+struct PosColTexVertex {
+	PosColTexVertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
+		Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
+	glm::vec3 Position;
+	glm::u8vec4 Color;
+	glm::vec2 TexCoord;
+};
+static_assert(sizeof(PosColTexVertex) == 4*3 + 1*4 + 4*2, "PosColTexVertex should be packed");
+
+//Solid white 1x1 texture:
+struct WhiteTexture {
+	WhiteTexture();
+	~WhiteTexture();
+
+	GLuint tex = 0;
+};
+
+//Streaming vertex buffer plus the vertex array object that maps it to color_texture_program's attributes:
+struct ColorTextureBuffers {
+	ColorTextureBuffers();
+	~ColorTextureBuffers();
+
+	//the VAO refers to this program's attribute locations, so keep it alive:
+	std::shared_ptr< ColorTextureProgram > color_texture_program = get_shared< ColorTextureProgram >();
+
+	//Buffer used to hold vertex data during drawing (re-filled with glBufferData every draw):
+	GLuint vertex_buffer = 0;
+
+	//Vertex Array Object that maps vertex_buffer locations (as PosColTexVertex) to color_texture_program attribute locations:
+	GLuint vertex_buffer_for_color_texture_program = 0;
+	// created by the first call to get_vertex_array(), since VAOs are not shared between contexts
+	// (this object might have been constructed on the ModeLoader's context, but draws happen on the main one)
+	GLuint get_vertex_array();
+};
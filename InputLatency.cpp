@@ -0,0 +1,153 @@
+#include "InputLatency.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+static const char *stage_names[InputLatency::StageCount] = {
+	"handled", "update", "draw", "swap", "gpu"
+};
+
+InputLatency::InputLatency(bool track_gpu_) : track_gpu(track_gpu_) {
+}
+
+InputLatency::~InputLatency() {
+	for (auto &f : fences) {
+		glDeleteSync(f.fence);
+	}
+	fences.clear();
+}
+
+double InputLatency::now() const {
+	return std::chrono::duration< double >(Clock::now() - origin).count();
+}
+
+void InputLatency::tag(SDL_Event const &evt) {
+	if (!(evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP
+	   || evt.type == SDL_MOUSEMOTION || evt.type == SDL_MOUSEBUTTONDOWN || evt.type == SDL_MOUSEBUTTONUP
+	   || evt.type == SDL_MOUSEWHEEL)) return;
+
+	//SDL timestamps are milliseconds on the SDL_GetTicks() clock, so convert by age:
+	double t = now();
+	uint32_t age_ms = SDL_GetTicks() - evt.common.timestamp;
+	if (age_ms > 10000) age_ms = 0; //(timestamp from the future or wrapped: treat as 'just now')
+
+	if (samples.size() < WindowSize) {
+		samples.emplace_back();
+	} else {
+		retire(samples[tagged % WindowSize]);
+		samples[tagged % WindowSize] = Sample();
+	}
+	Sample &s = samples[tagged % WindowSize];
+	tagged += 1;
+	s.frame = frame;
+	s.type = evt.type;
+	s.event = t - age_ms / 1000.0;
+}
+
+void InputLatency::mark(Stage stage) {
+	double t = now();
+	for (uint64_t i = std::max(frame_begin, window_begin()); i < tagged; ++i) {
+		Sample &s = samples[i % WindowSize];
+		if (s.stage[stage] < 0.0) s.stage[stage] = t;
+	}
+	if (track_gpu) poll_fences();
+}
+
+void InputLatency::mark_handled() { mark(Handled); }
+void InputLatency::mark_update() { mark(Update); }
+void InputLatency::mark_draw() { mark(Draw); }
+
+void InputLatency::mark_swap() {
+	mark(Swap);
+	if (track_gpu && frame_begin < tagged) {
+		PendingFence f;
+		f.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		f.begin = frame_begin;
+		f.end = tagged;
+		fences.emplace_back(f);
+	}
+	frame_begin = tagged;
+	frame += 1;
+}
+
+void InputLatency::poll_fences() {
+	double t = now();
+	//fences complete in order, so only the oldest ones need checking:
+	while (!fences.empty()) {
+		GLenum status = glClientWaitSync(fences.front().fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+		//(samples that have already left the window were counted without this stage)
+		for (uint64_t i = std::max(fences.front().begin, window_begin()); i < fences.front().end; ++i) {
+			samples[i % WindowSize].stage[Gpu] = t;
+		}
+		glDeleteSync(fences.front().fence);
+		fences.pop_front();
+	}
+}
+
+void InputLatency::write_csv(std::string const &filename) const {
+	std::ofstream csv(filename);
+	if (!csv) throw std::runtime_error("Failed to open '" + filename + "' for writing latency data.");
+	csv << "frame,event_type";
+	for (uint32_t s = 0; s < StageCount; ++s) {
+		csv << "," << stage_names[s] << "_ms";
+	}
+	csv << "\n";
+	for (uint64_t i = window_begin(); i < tagged; ++i) {
+		Sample const &sample = samples[i % WindowSize];
+		csv << sample.frame << "," << sample.type;
+		for (uint32_t s = 0; s < StageCount; ++s) {
+			csv << ",";
+			if (sample.stage[s] >= 0.0) csv << (sample.stage[s] - sample.event) * 1000.0;
+		}
+		csv << "\n";
+	}
+}
+
+void InputLatency::Histogram::add(float ms) {
+	size_t bin = size_t(std::max(0.0f, ms) / BinMs);
+	counts[std::min(bin, counts.size() - 1)] += 1;
+	total += 1;
+	max = std::max(max, ms);
+}
+
+float InputLatency::Histogram::percentile(float p) const {
+	if (total == 0) return 0.0f;
+	uint64_t rank = uint64_t(std::floor(p * float(total - 1))); //(the sample at or below percentile()'s interpolated rank)
+	uint64_t seen = 0;
+	for (size_t bin = 0; bin + 1 < counts.size(); ++bin) {
+		seen += counts[bin];
+		if (seen > rank) return std::min(max, (bin + 0.5f) * BinMs);
+	}
+	return max;
+}
+
+void InputLatency::retire(Sample const &sample) {
+	for (uint32_t s = 0; s < StageCount; ++s) {
+		if (sample.stage[s] >= 0.0) histograms[s].add(float((sample.stage[s] - sample.event) * 1000.0));
+	}
+}
+
+void InputLatency::print_summary(std::ostream &out) const {
+	//everything still in the window, on top of what has left it:
+	Histogram all[StageCount];
+	for (uint32_t s = 0; s < StageCount; ++s) {
+		all[s] = histograms[s];
+		for (uint64_t i = window_begin(); i < tagged; ++i) {
+			Sample const &sample = samples[i % WindowSize];
+			if (sample.stage[s] >= 0.0) all[s].add(float((sample.stage[s] - sample.event) * 1000.0));
+		}
+	}
+
+	out << "Input latency over " << tagged << " events (ms after event, to " << Histogram::BinMs << " ms):\n";
+	for (uint32_t s = 0; s < StageCount; ++s) {
+		if (all[s].total == 0) continue;
+		out << "  " << stage_names[s] << ": p50 " << all[s].percentile(0.5f)
+		    << ", p95 " << all[s].percentile(0.95f)
+		    << ", p99 " << all[s].percentile(0.99f)
+		    << ", max " << all[s].max << "\n";
+	}
+	out.flush();
+}
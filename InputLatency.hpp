@@ -0,0 +1,100 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <SDL.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <deque>
+#include <iostream>
+
+/*
+ * InputLatency follows input events through the frame that consumes them:
+ *   event (SDL timestamp) -> handle_event -> update -> draw -> SDL_GL_SwapWindow [-> GPU done]
+ * and records how long after the event each stage finished.
+ *
+ * Usage from the main loop:
+ *   tag(evt) for every input event as it is polled,
+ *   then mark_handled(), mark_update(), mark_draw(), mark_swap() as the frame progresses.
+ *
+ * GPU completion (optional) is found with a fence placed after the swap, which is
+ *  checked -- without blocking -- at every later mark; so it is an upper bound
+ *  accurate to roughly the spacing between marks.
+ *
+ * Memory stays bounded however long the run: only the most recent WindowSize events are kept
+ *  (for the CSV); each event is added to per-stage histograms as it leaves that window,
+ *  so the summary still covers every event (to within a histogram bin).
+ */
+
+struct InputLatency {
+	InputLatency(bool track_gpu);
+	~InputLatency();
+
+	void tag(SDL_Event const &evt);
+	void mark_handled();
+	void mark_update();
+	void mark_draw();
+	void mark_swap();
+
+	//write one row per tagged event still in the window (latencies in milliseconds):
+	void write_csv(std::string const &filename) const;
+	//print p50/p95/p99 per stage, over every tagged event:
+	void print_summary(std::ostream &out) const;
+
+	static const size_t WindowSize = 65536; //events kept for write_csv
+
+	//----- internals -----
+	typedef std::chrono::high_resolution_clock Clock;
+	bool track_gpu;
+	uint32_t frame = 0;
+
+	//all times are seconds since 'origin':
+	Clock::time_point origin = Clock::now();
+	double now() const;
+
+	enum Stage : uint32_t {
+		Handled = 0,
+		Update,
+		Draw,
+		Swap,
+		Gpu,
+		StageCount
+	};
+	struct Sample {
+		uint32_t frame = 0;
+		uint32_t type = 0; //SDL event type
+		double event = 0.0; //time the event happened (from SDL's timestamp)
+		double stage[StageCount] = {-1.0, -1.0, -1.0, -1.0, -1.0}; //-1.0 => not reached
+	};
+	//samples are numbered in the order they were tagged; sample i is kept in samples[i % WindowSize]
+	// until sample i + WindowSize replaces it:
+	std::vector< Sample > samples;
+	uint64_t tagged = 0; //samples tagged so far
+	uint64_t frame_begin = 0; //first sample tagged during the current frame
+	uint64_t window_begin() const { return tagged - samples.size(); } //oldest sample still kept
+
+	//latencies (ms) of every sample that has left the window, per stage:
+	struct Histogram {
+		static constexpr float BinMs = 0.05f;
+		std::vector< uint32_t > counts = std::vector< uint32_t >(20000, 0); //(bin i covers [i, i+1) * BinMs; the last one also everything above)
+		uint64_t total = 0;
+		float max = 0.0f;
+		void add(float ms);
+		//latency at fraction 'p' of the way through the sorted samples (the middle of its bin; max in the last bin):
+		float percentile(float p) const;
+	};
+	Histogram histograms[StageCount];
+	void retire(Sample const &sample); //add to histograms
+
+	//fences for frames whose GPU completion is still outstanding:
+	struct PendingFence {
+		GLsync fence = 0;
+		uint64_t begin = 0, end = 0; //samples covered by this fence
+	};
+	std::deque< PendingFence > fences;
+	void poll_fences();
+
+	void mark(Stage stage);
+};
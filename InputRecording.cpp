@@ -0,0 +1,159 @@
+#include "InputRecording.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+
+static const char Magic[4] = {'b','b','i','n'};
+static const uint32_t Version = 2; //(2: BreakoutMode and PongMode play swept collisions, so version 1 games no longer replay)
+
+//record kinds:
+enum : uint8_t {
+	RecordMotion = 1, //int32_t x, y, xrel, yrel; uint32_t state
+	RecordButtonDown = 2, //uint8_t button, clicks; int32_t x, y
+	RecordButtonUp = 3, //(as above)
+	RecordKeyDown = 4, //int32_t sym, scancode; uint16_t mod; uint8_t repeat
+	RecordKeyUp = 5, //(as above)
+	RecordResize = 6, //uint32_t window w, h, drawable w, h
+	RecordFrame = 7, //float elapsed; uint64_t state hash
+};
+
+template< typename T >
+static void write(std::ofstream &out, T const &t) {
+	out.write(reinterpret_cast< char const * >(&t), sizeof(T));
+}
+
+template< typename T >
+static T read(std::ifstream &in, std::string const &filename) {
+	T t;
+	if (!in.read(reinterpret_cast< char * >(&t), sizeof(T))) {
+		throw std::runtime_error("Input recording '" + filename + "' is truncated.");
+	}
+	return t;
+}
+
+//----------------------------------------------
+
+InputRecorder::InputRecorder(std::string const &filename_) : filename(filename_), out(filename_, std::ios::binary) {
+	if (!out) throw std::runtime_error("Failed to open '" + filename + "' for recording input.");
+	out.write(Magic, 4);
+	write(out, Version);
+}
+
+InputRecorder::~InputRecorder() {
+	out.close();
+	std::cout << "Recorded " << frames << " frames of input to '" << filename << "'." << std::endl;
+}
+
+void InputRecorder::event(SDL_Event const &evt) {
+	if (evt.type == SDL_MOUSEMOTION) {
+		write(out, uint8_t(RecordMotion));
+		write(out, int32_t(evt.motion.x));
+		write(out, int32_t(evt.motion.y));
+		write(out, int32_t(evt.motion.xrel));
+		write(out, int32_t(evt.motion.yrel));
+		write(out, uint32_t(evt.motion.state));
+	} else if (evt.type == SDL_MOUSEBUTTONDOWN || evt.type == SDL_MOUSEBUTTONUP) {
+		write(out, uint8_t(evt.type == SDL_MOUSEBUTTONDOWN ? RecordButtonDown : RecordButtonUp));
+		write(out, uint8_t(evt.button.button));
+		write(out, uint8_t(evt.button.clicks));
+		write(out, int32_t(evt.button.x));
+		write(out, int32_t(evt.button.y));
+	} else if (evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP) {
+		write(out, uint8_t(evt.type == SDL_KEYDOWN ? RecordKeyDown : RecordKeyUp));
+		write(out, int32_t(evt.key.keysym.sym));
+		write(out, int32_t(evt.key.keysym.scancode));
+		write(out, uint16_t(evt.key.keysym.mod));
+		write(out, uint8_t(evt.key.repeat));
+	}
+}
+
+void InputRecorder::resize(glm::uvec2 const &window_size, glm::uvec2 const &drawable_size) {
+	write(out, uint8_t(RecordResize));
+	write(out, uint32_t(window_size.x));
+	write(out, uint32_t(window_size.y));
+	write(out, uint32_t(drawable_size.x));
+	write(out, uint32_t(drawable_size.y));
+}
+
+void InputRecorder::frame(float elapsed, uint64_t state_hash) {
+	write(out, uint8_t(RecordFrame));
+	write(out, elapsed);
+	write(out, state_hash);
+	frames += 1;
+}
+
+//----------------------------------------------
+
+InputReplayer::InputReplayer(std::string const &filename_) : filename(filename_), in(filename_, std::ios::binary) {
+	if (!in) throw std::runtime_error("Failed to open input recording '" + filename + "'.");
+	char magic[4];
+	if (!in.read(magic, 4) || std::memcmp(magic, Magic, 4) != 0) {
+		throw std::runtime_error("File '" + filename + "' is not an input recording.");
+	}
+	uint32_t version = read< uint32_t >(in, filename);
+	if (version != Version) {
+		throw std::runtime_error("Input recording '" + filename + "' has version " + std::to_string(version) + "; expecting " + std::to_string(Version) + ".");
+	}
+}
+
+bool InputReplayer::next_frame(std::vector< Input > *inputs, float *elapsed, uint64_t *state_hash) {
+	inputs->clear();
+	while (true) {
+		uint8_t kind;
+		if (!in.read(reinterpret_cast< char * >(&kind), 1)) {
+			//end of recording (any trailing inputs never reached an update):
+			return false;
+		}
+
+		if (kind == RecordFrame) {
+			*elapsed = read< float >(in, filename);
+			*state_hash = read< uint64_t >(in, filename);
+			frames += 1;
+			return true;
+		}
+
+		inputs->emplace_back();
+		Input &input = inputs->back();
+		std::memset(&input.evt, 0, sizeof(input.evt));
+		if (kind == RecordMotion) {
+			input.evt.type = SDL_MOUSEMOTION;
+			input.evt.motion.x = read< int32_t >(in, filename);
+			input.evt.motion.y = read< int32_t >(in, filename);
+			input.evt.motion.xrel = read< int32_t >(in, filename);
+			input.evt.motion.yrel = read< int32_t >(in, filename);
+			input.evt.motion.state = read< uint32_t >(in, filename);
+		} else if (kind == RecordButtonDown || kind == RecordButtonUp) {
+			input.evt.type = (kind == RecordButtonDown ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP);
+			input.evt.button.button = read< uint8_t >(in, filename);
+			input.evt.button.clicks = read< uint8_t >(in, filename);
+			input.evt.button.state = (kind == RecordButtonDown ? 1 : 0);
+			input.evt.button.x = read< int32_t >(in, filename);
+			input.evt.button.y = read< int32_t >(in, filename);
+		} else if (kind == RecordKeyDown || kind == RecordKeyUp) {
+			input.evt.type = (kind == RecordKeyDown ? SDL_KEYDOWN : SDL_KEYUP);
+			input.evt.key.keysym.sym = read< int32_t >(in, filename);
+			input.evt.key.keysym.scancode = SDL_Scancode(read< int32_t >(in, filename));
+			input.evt.key.keysym.mod = read< uint16_t >(in, filename);
+			input.evt.key.repeat = read< uint8_t >(in, filename);
+			input.evt.key.state = (kind == RecordKeyDown ? 1 : 0);
+		} else if (kind == RecordResize) {
+			input.is_resize = true;
+			input.window_size.x = read< uint32_t >(in, filename);
+			input.window_size.y = read< uint32_t >(in, filename);
+			input.drawable_size.x = read< uint32_t >(in, filename);
+			input.drawable_size.y = read< uint32_t >(in, filename);
+		} else {
+			throw std::runtime_error("Input recording '" + filename + "' contains unknown record kind " + std::to_string(int(kind)) + ".");
+		}
+	}
+}
+
+void InputReplayer::check(uint64_t recorded_hash, uint64_t replayed_hash) {
+	if (recorded_hash == replayed_hash) return;
+	if (diverged_frames == 0) {
+		first_divergence = frames;
+		std::cerr << "WARNING: replay of '" << filename << "' diverged from the recording at frame " << frames << "." << std::endl;
+	}
+	diverged_frames += 1;
+}
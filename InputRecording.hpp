@@ -0,0 +1,66 @@
+#pragma once
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+/*
+ * Input recordings capture everything the main loop feeds to modes:
+ *  the input events passed to handle_event, window sizes passed to Mode::set_size,
+ *  and the 'elapsed' value passed to update -- plus a hash of the mode stack's state
+ *  after each update.
+ *
+ * Replaying a recording feeds the same values back in the same order, so the game
+ *  evolves bit-exactly as it did when recorded; any mismatch in the per-frame hash
+ *  points at the first frame where the simulation diverged.
+ *
+ * File format (native byte order; recordings are meant to be replayed on the machine that made them):
+ *   header: "bbin" magic, uint32_t version
+ *   (the version changes when the games' rules do -- e.g., version 2 came with swept collisions in
+ *    BreakoutMode and PongMode -- since older recordings would no longer replay; they are refused, not mis-checked)
+ *   records: uint8_t kind, followed by a kind-specific payload (see InputRecording.cpp)
+ */
+
+struct InputRecorder {
+	InputRecorder(std::string const &filename);
+	~InputRecorder();
+
+	//record an event passed to Mode::handle_event (non-input events are skipped):
+	void event(SDL_Event const &evt);
+	//record a window size passed to Mode::set_size:
+	void resize(glm::uvec2 const &window_size, glm::uvec2 const &drawable_size);
+	//record the end of a frame's update:
+	void frame(float elapsed, uint64_t state_hash);
+
+	std::string filename;
+	std::ofstream out;
+	uint32_t frames = 0;
+};
+
+struct InputReplayer {
+	InputReplayer(std::string const &filename); //throws on missing/malformed file
+
+	//one thing to feed back to the main loop:
+	struct Input {
+		bool is_resize = false;
+		SDL_Event evt; //if !is_resize
+		glm::uvec2 window_size = glm::uvec2(0); //if is_resize
+		glm::uvec2 drawable_size = glm::uvec2(0); //if is_resize
+	};
+
+	//read everything that happened before the next update;
+	// returns false when the recording is over:
+	bool next_frame(std::vector< Input > *inputs, float *elapsed, uint64_t *state_hash);
+
+	//compare the replayed state hash to the recorded one (prints the first divergence):
+	void check(uint64_t recorded_hash, uint64_t replayed_hash);
+
+	std::string filename;
+	std::ifstream in;
+	uint32_t frames = 0;
+	uint32_t diverged_frames = 0;
+	uint32_t first_divergence = 0;
+};
@@ -0,0 +1,117 @@
+#include "LanesFuzz.hpp"
+
+#include "BreakoutLanes.hpp"
+#include "BreakoutGame.hpp"
+#include "Level.hpp"
+
+#include <random>
+#include <vector>
+#include <algorithm>
+
+//play 'frames' frames of 'start' in LANES lanes and as many BreakoutGames; returns the number of steps where a lane differed:
+template< uint32_t LANES >
+static uint32_t play_level(BreakoutGame const &start, uint32_t frames, uint32_t first_frame, std::mt19937 &mt, std::ostream &out, uint32_t *reported) {
+	std::uniform_real_distribution< float > unit(0.0f, 1.0f);
+
+	BreakoutLanes< LANES > lanes(start);
+	std::vector< BreakoutGame > games(LANES, start);
+	auto restart = [&](uint32_t l) {
+		uint32_t seed = mt();
+		lanes.reset(l, start);
+		lanes.seed(l, seed);
+		games[l] = start;
+		games[l].seed(seed);
+	};
+	for (uint32_t l = 0; l < LANES; ++l) {
+		restart(l);
+	}
+
+	uint32_t mismatches = 0;
+	for (uint32_t frame = 0; frame < frames; ++frame) {
+		//----- the same random input for each lane and its game -----
+		for (uint32_t l = 0; l < LANES; ++l) {
+			BreakoutGame &game = games[l];
+			if (unit(mt) < 0.001f) restart(l);
+			if (unit(mt) < 0.2f) {
+				//(sometimes outside the court -- update() should keep it in)
+				game.paddle.x = lanes.paddle_x[l] = (2.0f * unit(mt) - 1.0f) * 1.2f * start.court_radius.x;
+			}
+			if (unit(mt) < 0.02f) {
+				game.launch();
+				lanes.launch(l);
+			}
+			if (unit(mt) < 0.03f) {
+				game.cycle_paddle_color();
+				lanes.cycle_paddle_color(l);
+			}
+			if (unit(mt) < 0.02f && !game.ball_reset) {
+				game.ball_velocity *= 0.5f + 3.5f * unit(mt);
+				lanes.ball_velocity_x[l] = game.ball_velocity.x;
+				lanes.ball_velocity_y[l] = game.ball_velocity.y;
+			}
+		}
+		float elapsed = (unit(mt) < 0.05f ? 0.1f : 1.0f / 60.0f) * (0.5f + unit(mt));
+
+		lanes.update(elapsed);
+		for (uint32_t l = 0; l < LANES; ++l) {
+			games[l].update(elapsed);
+		}
+
+		//----- every lane still matches its game -----
+		for (uint32_t l = 0; l < LANES; ++l) {
+			if (lanes.state_hash(l) == games[l].state_hash()) continue;
+			if (*reported < 10) {
+				BreakoutGame lane;
+				lanes.get_game(l, &lane);
+				out << "  frame " << (first_frame + frame) << ": lane " << l << " of " << LANES << " diverged from BreakoutGame"
+					<< " (lane ball (" << lane.ball.x << ", " << lane.ball.y << ") moving (" << lane.ball_velocity.x << ", " << lane.ball_velocity.y << ")"
+					<< "; game ball (" << games[l].ball.x << ", " << games[l].ball.y << ") moving (" << games[l].ball_velocity.x << ", " << games[l].ball_velocity.y << ")).\n";
+				++*reported;
+			}
+			++mismatches;
+			restart(l); //(carry on from a matching state)
+		}
+	}
+	return mismatches;
+}
+
+bool run_lanes_fuzz(LanesFuzzOptions const &options, std::ostream &out) {
+	std::mt19937 mt(options.seed);
+	std::uniform_real_distribution< float > unit(0.0f, 1.0f);
+	LevelGenOptions::Pattern const patterns[] = {
+		LevelGenOptions::Solid, LevelGenOptions::Checker, LevelGenOptions::Stripes, LevelGenOptions::Diamond, LevelGenOptions::Clusters
+	};
+
+	uint32_t mismatches = 0, reported = 0, levels = 0;
+	for (uint32_t frame = 0; frame < options.frames; frame += options.frames_per_level) {
+		//----- a fresh level -----
+		LevelGenOptions gen;
+		gen.seed = mt();
+		gen.brick_count = 50 + mt() % (std::max(options.max_bricks, 51u) - 49);
+		gen.density = 0.5f + 0.5f * unit(mt);
+		gen.pattern = patterns[mt() % 5];
+		gen.aspect = 13.0f / 6.0f;
+		gen.field_radius = glm::vec2(6.5f, 3.0f);
+		for (uint32_t c = 0; c < BreakoutGame::COLOR_COUNT; ++c) {
+			gen.colors.emplace_back(BreakoutGame::COLORS[c].first);
+		}
+		Level level(generate_level(gen).serialize(), "generated level");
+
+		BreakoutGame start;
+		start.swept = false; //(lanes play the discrete rules)
+		start.autopilot = (unit(mt) < 0.5f);
+		start.load_level(level);
+
+		uint32_t frames = std::min(options.frames_per_level, options.frames - frame);
+		if (levels % 2 == 0) mismatches += play_level< 8 >(start, frames, frame, mt, out, &reported);
+		else mismatches += play_level< 16 >(start, frames, frame, mt, out, &reported);
+		++levels;
+	}
+
+	bool passed = (mismatches == 0);
+	out << "Lanes fuzz: " << options.frames << " steps of 8 and 16 lanes on " << levels << " levels; "
+		<< mismatches << " lane steps differed from BreakoutGame.\n";
+	out << "  " << (passed ? "PASS" : "FAIL") << "\n";
+	out.flush();
+	return passed;
+}
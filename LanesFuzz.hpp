@@ -0,0 +1,27 @@
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+
+/*
+ * The lanes fuzz test keeps BreakoutLanes honest: BreakoutLanes repeats BreakoutGame's discrete rules
+ * (for speed) instead of calling them, so a change to one that isn't made to the other should fail a check.
+ *
+ * It plays groups of 8 and 16 lanes on random generated levels, next to one BreakoutGame per lane
+ * (BreakoutGame::swept off) with the same seed, and feeds both the same random input -- paddle moves,
+ * launches, color changes, ball speeds, frame times, restarts; with and without autopilot --
+ * comparing every lane's state_hash() with its BreakoutGame's after every step.
+ * (BatchRunner's --validate-lanes does the same for autopilot games on one level.)
+ *
+ * Needs no window (main.cpp runs this with --fuzz-lanes).
+ */
+
+struct LanesFuzzOptions {
+	uint32_t frames = 20000;
+	uint32_t frames_per_level = 1000; //a new level (and group of lanes) after this many frames
+	uint32_t seed = 0;
+	uint32_t max_bricks = 1000; //levels get between 50 and this many bricks
+};
+
+//returns false if any lane's state ever differs from its BreakoutGame's:
+bool run_lanes_fuzz(LanesFuzzOptions const &options, std::ostream &out);
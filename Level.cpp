@@ -0,0 +1,358 @@
+#include "Level.hpp"
+
+#include "load_save_png.hpp"
+
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+
+#ifdef _WIN32
+//(no mmap on windows; level files are read into memory instead)
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char Magic[4] = {'b','b','l','v'};
+static const uint32_t Version = 1;
+
+Level::Level(std::string const &filename) : name(filename) {
+#ifdef _WIN32
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) throw std::runtime_error("Failed to open level file '" + filename + "'.");
+	bytes.assign(std::istreambuf_iterator< char >(file), std::istreambuf_iterator< char >());
+	validate(bytes.data(), bytes.size());
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) throw std::runtime_error("Failed to open level file '" + filename + "'.");
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		throw std::runtime_error("Failed to stat level file '" + filename + "'.");
+	}
+	mapped_size = size_t(st.st_size);
+	if (mapped_size != 0) {
+		mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		mapped = nullptr;
+		throw std::runtime_error("Failed to map level file '" + filename + "'.");
+	}
+	try {
+		validate(reinterpret_cast< uint8_t const * >(mapped), mapped_size);
+	} catch (...) {
+		if (mapped) munmap(mapped, mapped_size);
+		mapped = nullptr;
+		throw;
+	}
+#endif
+}
+
+Level::Level(std::vector< uint8_t > &&bytes_, std::string const &name_) : name(name_), bytes(std::move(bytes_)) {
+	validate(bytes.data(), bytes.size());
+}
+
+Level::~Level() {
+#ifndef _WIN32
+	if (mapped) munmap(mapped, mapped_size);
+#endif
+	mapped = nullptr;
+}
+
+void Level::validate(uint8_t const *data, size_t size) {
+	auto fail = [this](std::string const &why) {
+		throw std::runtime_error("Level '" + name + "' is malformed: " + why);
+	};
+	if (size < sizeof(LevelHeader)) fail("too small to hold a header.");
+
+	LevelHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, Magic, 4) != 0) fail("not a level file.");
+	if (header.version != Version) {
+		fail("version " + std::to_string(header.version) + " (expecting " + std::to_string(Version) + ").");
+	}
+	if (header.palette_count > 256) fail("palette has more than 256 colors.");
+
+	size_t expected = sizeof(LevelHeader) + size_t(header.palette_count) * sizeof(glm::u8vec4) + size_t(header.brick_count) * sizeof(LevelBrick);
+	if (size != expected) {
+		fail("size is " + std::to_string(size) + " bytes, but header says " + std::to_string(expected) + ".");
+	}
+
+	auto positive = [](glm::vec2 const &v) {
+		return std::isfinite(v.x) && std::isfinite(v.y) && v.x > 0.0f && v.y > 0.0f;
+	};
+	if (!positive(header.court_radius)) fail("bad court radius.");
+	if (!positive(header.brick_radius)) fail("bad brick radius.");
+
+	glm::u8vec4 const *palette_ = reinterpret_cast< glm::u8vec4 const * >(data + sizeof(LevelHeader));
+	LevelBrick const *bricks_ = reinterpret_cast< LevelBrick const * >(data + sizeof(LevelHeader) + header.palette_count * sizeof(glm::u8vec4));
+
+	for (uint32_t i = 0; i < header.brick_count; ++i) {
+		LevelBrick const &b = bricks_[i];
+		if (b.color >= header.palette_count) fail("brick " + std::to_string(i) + " has color index out of range.");
+		if (!std::isfinite(b.position.x) || !std::isfinite(b.position.y)) fail("brick " + std::to_string(i) + " has a bad position.");
+	}
+
+	court_radius = header.court_radius;
+	brick_radius = header.brick_radius;
+	palette_count = header.palette_count;
+	palette = palette_;
+	brick_count = header.brick_count;
+	bricks = bricks_;
+}
+
+//----------------------------------------------
+
+void LevelData::add_brick(glm::vec2 const &position, glm::u8vec4 const &color) {
+	uint32_t index = 0;
+	while (index < palette.size() && palette[index] != color) ++index;
+	if (index == palette.size()) {
+		if (palette.size() == 256) throw std::runtime_error("Level uses more than 256 colors.");
+		palette.emplace_back(color);
+	}
+	LevelBrick brick;
+	brick.position = position;
+	brick.color = uint8_t(index);
+	brick.padding[0] = brick.padding[1] = brick.padding[2] = 0;
+	bricks.emplace_back(brick);
+}
+
+std::vector< uint8_t > LevelData::serialize() const {
+	LevelHeader header;
+	std::memcpy(header.magic, Magic, 4);
+	header.version = Version;
+	header.palette_count = uint32_t(palette.size());
+	header.brick_count = uint32_t(bricks.size());
+	header.court_radius = court_radius;
+	header.brick_radius = brick_radius;
+
+	std::vector< uint8_t > out(sizeof(LevelHeader) + palette.size() * sizeof(glm::u8vec4) + bricks.size() * sizeof(LevelBrick));
+	uint8_t *at = out.data();
+	std::memcpy(at, &header, sizeof(header));
+	at += sizeof(header);
+	if (!palette.empty()) std::memcpy(at, palette.data(), palette.size() * sizeof(glm::u8vec4));
+	at += palette.size() * sizeof(glm::u8vec4);
+	if (!bricks.empty()) std::memcpy(at, bricks.data(), bricks.size() * sizeof(LevelBrick));
+	return out;
+}
+
+void LevelData::save(std::string const &filename) const {
+	std::vector< uint8_t > data = serialize();
+	std::ofstream out(filename, std::ios::binary);
+	if (!out.write(reinterpret_cast< char const * >(data.data()), data.size())) {
+		throw std::runtime_error("Failed to write level to '" + filename + "'.");
+	}
+}
+
+//----------------------------------------------
+
+//lay out a grid of cells (row 0 at the top) as bricks:
+// 'cell(x,y, &color)' returns true if there is a brick at (x,y)
+template< typename CellFn >
+static LevelData level_from_grid(glm::uvec2 const &size, CellFn const &cell, LevelGridOptions const &options) {
+	LevelData level;
+	level.brick_radius = options.brick_radius;
+
+	glm::vec2 pitch = 2.0f * options.brick_radius + glm::vec2(options.gap);
+	glm::vec2 origin = options.center - 0.5f * glm::vec2(float(size.x) - 1.0f, 1.0f - float(size.y)) * pitch;
+
+	glm::vec2 min = glm::vec2( std::numeric_limits< float >::infinity());
+	glm::vec2 max = glm::vec2(-std::numeric_limits< float >::infinity());
+	for (uint32_t y = 0; y < size.y; ++y) {
+		for (uint32_t x = 0; x < size.x; ++x) {
+			glm::u8vec4 color;
+			if (!cell(x, y, &color)) continue;
+			glm::vec2 position = origin + glm::vec2(x * pitch.x, -float(y) * pitch.y);
+			level.add_brick(position, color);
+			min = glm::min(min, position - options.brick_radius);
+			max = glm::max(max, position + options.brick_radius);
+		}
+	}
+
+	//grow the court to fit the bricks (leaving room at the bottom for the paddle):
+	level.court_radius = options.court_radius;
+	if (!level.bricks.empty()) {
+		const float paddle_room = 2.0f;
+		level.court_radius.x = std::max(level.court_radius.x, std::max(-min.x, max.x) + options.gap);
+		level.court_radius.y = std::max(level.court_radius.y, std::max(-min.y + paddle_room, max.y + options.gap));
+	}
+	return level;
+}
+
+LevelData level_from_png(std::string const &filename, LevelGridOptions const &options) {
+	glm::uvec2 size;
+	std::vector< glm::u8vec4 > data;
+	load_png(filename, &size, &data, UpperLeftOrigin);
+
+	return level_from_grid(size, [&](uint32_t x, uint32_t y, glm::u8vec4 *color) -> bool {
+		glm::u8vec4 px = data[y * size.x + x];
+		if (px.a < 128) return false;
+		*color = glm::u8vec4(px.r, px.g, px.b, 0xff);
+		return true;
+	}, options);
+}
+
+LevelData level_from_text(std::istream &from, LevelGridOptions const &options, std::string const &name) {
+	std::map< char, glm::u8vec4 > colors;
+	std::vector< std::string > rows;
+	std::string line;
+	uint32_t line_number = 0;
+	while (std::getline(from, line)) {
+		line_number += 1;
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line.empty() || line[0] == '#') continue;
+		if (line.size() >= 2 && line[1] == '=') {
+			//color definition:
+			char *end = nullptr;
+			unsigned long hex = std::strtoul(line.c_str() + 2, &end, 16);
+			if (line.size() != 8 || end != line.c_str() + 8) {
+				throw std::runtime_error(name + ":" + std::to_string(line_number) + ": expecting a color definition like 'R=ec3160'.");
+			}
+			colors[line[0]] = glm::u8vec4((hex >> 16) & 0xff, (hex >> 8) & 0xff, hex & 0xff, 0xff);
+			continue;
+		}
+		rows.emplace_back(line);
+	}
+
+	glm::uvec2 size = glm::uvec2(0, rows.size());
+	for (auto const &row : rows) {
+		size.x = std::max(size.x, uint32_t(row.size()));
+	}
+
+	return level_from_grid(size, [&](uint32_t x, uint32_t y, glm::u8vec4 *color) -> bool {
+		if (x >= rows[y].size()) return false;
+		char c = rows[y][x];
+		if (c == '.' || c == ' ') return false;
+		auto f = colors.find(c);
+		if (f == colors.end()) {
+			throw std::runtime_error(name + ": brick character '" + std::string(1, c) + "' has no color definition.");
+		}
+		*color = f->second;
+		return true;
+	}, options);
+}
+
+//----------------------------------------------
+
+//small integer hash (for the 'Clusters' pattern's noise lattice):
+static uint32_t hash3(uint32_t a, uint32_t b, uint32_t c) {
+	uint32_t h = a * 0x9e3779b1u ^ b * 0x85ebca77u ^ c * 0xc2b2ae3du;
+	h ^= h >> 15; h *= 0x2c1b3c6du;
+	h ^= h >> 12; h *= 0x297a2d39u;
+	h ^= h >> 15;
+	return h;
+}
+
+LevelData generate_level(LevelGenOptions const &options) {
+	if (options.colors.empty()) throw std::runtime_error("generate_level: no colors given.");
+	if (options.colors.size() > 256) throw std::runtime_error("generate_level: more than 256 colors given.");
+	if (!options.color_weights.empty() && options.color_weights.size() != options.colors.size()) {
+		throw std::runtime_error("generate_level: color_weights must have one weight per color.");
+	}
+	if (!(options.density > 0.0f && options.density <= 1.0f)) throw std::runtime_error("generate_level: density must be in (0,1].");
+	if (!(options.aspect > 0.0f)) throw std::runtime_error("generate_level: aspect must be positive.");
+	if (!(options.grid.brick_radius.x > 0.0f && options.grid.brick_radius.y > 0.0f)) throw std::runtime_error("generate_level: brick radius must be positive.");
+
+	std::mt19937 mt(options.seed);
+
+	//which cells can hold bricks:
+	const uint32_t ClusterSize = 8; //cells between noise lattice points
+	auto in_pattern = [&options](uint32_t x, uint32_t y, glm::uvec2 const &size) -> bool {
+		switch (options.pattern) {
+			case LevelGenOptions::Solid: return true;
+			case LevelGenOptions::Checker: return (x + y) % 2 == 0;
+			case LevelGenOptions::Stripes: return y % 2 == 0;
+			case LevelGenOptions::Diamond: {
+				float dx = std::abs((x + 0.5f) / size.x - 0.5f);
+				float dy = std::abs((y + 0.5f) / size.y - 0.5f);
+				return dx + dy <= 0.5f;
+			}
+			case LevelGenOptions::Clusters: {
+				//bilinearly-interpolated value noise, thresholded at 1/2:
+				uint32_t ix = x / ClusterSize, iy = y / ClusterSize;
+				float tx = float(x % ClusterSize) / ClusterSize, ty = float(y % ClusterSize) / ClusterSize;
+				auto value = [&options](uint32_t ix, uint32_t iy) {
+					return float(hash3(ix, iy, options.seed) >> 8) / float(1 << 24);
+				};
+				float v = (1.0f - ty) * ((1.0f - tx) * value(ix, iy) + tx * value(ix+1, iy))
+				        + ty * ((1.0f - tx) * value(ix, iy+1) + tx * value(ix+1, iy+1));
+				return v > 0.5f;
+			}
+		}
+		return true;
+	};
+	float pattern_fraction = (options.pattern == LevelGenOptions::Solid ? 1.0f : 0.5f);
+
+	//pick a grid with (about) the requested aspect ratio and enough pattern cells:
+	glm::vec2 pitch = 2.0f * options.grid.brick_radius + glm::vec2(options.grid.gap);
+	float cells = std::max(1.0f, float(options.brick_count) / (options.density * pattern_fraction));
+	glm::uvec2 size;
+	size.x = std::max(1u, uint32_t(std::ceil(std::sqrt(cells * options.aspect * pitch.y / pitch.x))));
+	size.y = std::max(1u, uint32_t(std::ceil(cells / size.x)));
+
+	std::vector< uint32_t > candidates;
+	while (true) {
+		candidates.clear();
+		for (uint32_t y = 0; y < size.y; ++y) {
+			for (uint32_t x = 0; x < size.x; ++x) {
+				if (in_pattern(x, y, size)) candidates.emplace_back(y * size.x + x);
+			}
+		}
+		if (candidates.size() >= std::ceil(options.brick_count / options.density)) break;
+		if (uint64_t(size.x) * size.y > (uint64_t(1) << 31)) throw std::runtime_error("generate_level: pattern too sparse for brick count.");
+		size.y += std::max(1u, size.y / 8);
+	}
+
+	//choose exactly brick_count of the candidate cells (partial Fisher-Yates shuffle):
+	for (uint32_t i = 0; i < options.brick_count; ++i) {
+		std::uniform_int_distribution< size_t > pick(i, candidates.size() - 1);
+		std::swap(candidates[i], candidates[pick(mt)]);
+	}
+	candidates.resize(options.brick_count);
+	std::sort(candidates.begin(), candidates.end()); //(keep bricks in row order)
+
+	//assign colors:
+	std::vector< int16_t > cell_color(size.x * size.y, -1);
+	std::discrete_distribution< int > random_color;
+	if (options.color_weights.empty()) {
+		random_color = std::discrete_distribution< int >(options.colors.size(), 0.0, 1.0, [](double) { return 1.0; });
+	} else {
+		random_color = std::discrete_distribution< int >(options.color_weights.begin(), options.color_weights.end());
+	}
+	for (uint32_t cell : candidates) {
+		uint32_t x = cell % size.x, y = cell / size.x;
+		int16_t color = 0;
+		if (options.color_mix == LevelGenOptions::RandomColors) color = int16_t(random_color(mt));
+		else if (options.color_mix == LevelGenOptions::RowColors) color = int16_t(y % options.colors.size());
+		else if (options.color_mix == LevelGenOptions::ColumnColors) color = int16_t(x % options.colors.size());
+		cell_color[cell] = color;
+	}
+
+	//scale bricks to fit the field, if asked:
+	LevelGridOptions grid = options.grid;
+	if (options.field_radius.x > 0.0f && options.field_radius.y > 0.0f) {
+		float scale = std::min(
+			2.0f * options.field_radius.x / (size.x * pitch.x),
+			2.0f * options.field_radius.y / (size.y * pitch.y)
+		);
+		grid.brick_radius *= scale;
+		grid.gap *= scale;
+	}
+
+	return level_from_grid(size, [&](uint32_t x, uint32_t y, glm::u8vec4 *color) -> bool {
+		int16_t c = cell_color[y * size.x + x];
+		if (c < 0) return false;
+		*color = options.colors[c];
+		return true;
+	}, grid);
+}
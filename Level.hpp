@@ -0,0 +1,136 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+/*
+ * Breakout levels are stored in a small, versioned binary format:
+ *   LevelHeader
+ *   palette: glm::u8vec4 (RGBA) * header.palette_count
+ *   bricks: LevelBrick * header.brick_count
+ *
+ * Level files are memory-mapped and validated once at load, after which the
+ *  palette and brick records are read in place (no per-brick allocation).
+ *
+ * LevelData is the in-memory form used to build levels -- e.g., from a PNG or text
+ *  description (level_from_png / level_from_text; see convert_level.cpp), or procedurally
+ *  for stress tests (generate_level) -- and to write them.
+ */
+
+struct LevelHeader {
+	char magic[4]; //"bblv"
+	uint32_t version;
+	uint32_t palette_count; //at most 256, since bricks store an 8-bit index
+	uint32_t brick_count;
+	glm::vec2 court_radius;
+	glm::vec2 brick_radius;
+};
+static_assert(sizeof(LevelHeader) == 4 + 4 + 4 + 4 + 4*2 + 4*2, "LevelHeader should be packed");
+
+struct LevelBrick {
+	glm::vec2 position;
+	uint8_t color; //index into palette
+	uint8_t padding[3];
+};
+static_assert(sizeof(LevelBrick) == 4*2 + 1 + 3, "LevelBrick should be packed");
+
+//A validated, read-only view of a level:
+struct Level {
+	//memory-map a level file; throws if it is missing or malformed:
+	Level(std::string const &filename);
+	//validate and use an in-memory copy of a level file (e.g., from LevelData::serialize()):
+	Level(std::vector< uint8_t > &&bytes, std::string const &name);
+	~Level();
+
+	Level(Level const &) = delete;
+	Level &operator=(Level const &) = delete;
+
+	glm::vec2 court_radius = glm::vec2(0.0f);
+	glm::vec2 brick_radius = glm::vec2(0.0f);
+	uint32_t palette_count = 0;
+	glm::u8vec4 const *palette = nullptr;
+	uint32_t brick_count = 0;
+	LevelBrick const *bricks = nullptr;
+
+	//----- internals -----
+	std::string name; //for error messages
+	std::vector< uint8_t > bytes; //storage, if not memory-mapped
+	void *mapped = nullptr; //memory-mapped file, if any
+	size_t mapped_size = 0;
+	void validate(uint8_t const *data, size_t size); //throws on malformed data; sets the members above
+};
+
+struct LevelData {
+	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
+	glm::vec2 brick_radius = glm::vec2(0.5f, 0.3f);
+	std::vector< glm::u8vec4 > palette;
+	std::vector< LevelBrick > bricks;
+
+	//add a brick, adding its color to the palette if needed (throws if the palette is full):
+	void add_brick(glm::vec2 const &position, glm::u8vec4 const &color);
+
+	//the level in file format:
+	std::vector< uint8_t > serialize() const;
+	void save(std::string const &filename) const;
+};
+
+//Options for converting a grid description (one cell => one brick) into a level:
+struct LevelGridOptions {
+	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f); //(grown if needed to fit the bricks)
+	glm::vec2 brick_radius = glm::vec2(0.5f, 0.3f);
+	float gap = 0.1f; //space between neighboring bricks
+	glm::vec2 center = glm::vec2(0.0f, 1.4f); //court-space position of the center of the grid
+};
+
+//PNG description: each pixel is a brick of that color; pixels with alpha < 128 are empty:
+LevelData level_from_png(std::string const &filename, LevelGridOptions const &options);
+
+//Text description:
+// lines of the form 'X=rrggbb' give the color of brick character 'X';
+// lines starting with '#' are comments; every other non-empty line is a row of bricks (top row first),
+// with '.' or ' ' marking empty cells.
+LevelData level_from_text(std::istream &from, LevelGridOptions const &options, std::string const &name);
+
+//Options for generating stress-test levels (see generate_level):
+struct LevelGenOptions {
+	uint32_t seed = 0;
+
+	//number of bricks to place (exactly):
+	uint32_t brick_count = 1000;
+
+	//fraction of the pattern's cells that get a brick (the rest are left as random holes):
+	float density = 0.8f;
+
+	//which cells of the grid can hold bricks:
+	enum Pattern {
+		Solid, //every cell
+		Checker, //alternating cells
+		Stripes, //alternating rows
+		Diamond, //cells inside a diamond centered on the grid
+		Clusters, //blobs of cells (thresholded value noise)
+	} pattern = Solid;
+
+	//how brick colors are chosen from 'colors':
+	enum ColorMix {
+		RandomColors, //independently per brick (weighted by 'color_weights', if given)
+		RowColors, //one color per row, cycling through 'colors'
+		ColumnColors, //one color per column, cycling through 'colors'
+	} color_mix = RandomColors;
+	std::vector< glm::u8vec4 > colors; //(required)
+	std::vector< float > color_weights; //relative frequency of each color (empty => uniform)
+
+	//layout of the grid: brick size, gap, etc:
+	LevelGridOptions grid;
+	float aspect = 2.0f; //(approximate) width / height of the brick field
+
+	//if nonzero, brick size is picked so that the field covers (about) this half-size,
+	// overriding grid.brick_radius and grid.gap (keeping their proportions):
+	glm::vec2 field_radius = glm::vec2(0.0f);
+};
+
+//Generate a level (deterministically from options.seed); throws if the options make no sense:
+LevelData generate_level(LevelGenOptions const &options);
@@ -0,0 +1,269 @@
+#include "Log.hpp"
+
+#include "Trace.hpp"
+
+#include <thread>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+
+std::atomic< bool > Log::is_started(false);
+
+//writes between checking is_started and publishing their record (so stop() can wait for them to land):
+static std::atomic< uint32_t > in_flight(0);
+
+static uint64_t now_ns() {
+	return uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static char const *prefix(Log::Level level) {
+	if (level == Log::Warning) return "WARNING: ";
+	if (level == Log::Error) return "ERROR: ";
+	return "";
+}
+
+//----- the ring -----
+//Bounded queue after Dmitry Vyukov's: each cell's sequence number says whose turn it is --
+// producers claim a position with a compare-exchange, fill the cell, then publish it by bumping its sequence;
+// the (single) consumer reads published cells in order and hands them back a lap later.
+
+struct LogRecord {
+	Log::Level level;
+	uint64_t time_ns;
+	char text[Log::TextSize];
+};
+
+struct LogRing {
+	static_assert((Log::Capacity & (Log::Capacity - 1)) == 0, "Log::Capacity should be a power of two");
+	struct Cell {
+		std::atomic< uint64_t > sequence;
+		LogRecord record;
+	};
+	Cell cells[Log::Capacity];
+	std::atomic< uint64_t > enqueue_position;
+	uint64_t dequeue_position = 0; //(only the consumer touches this)
+	std::atomic< uint64_t > dropped;
+
+	LogRing() : enqueue_position(0), dropped(0) {
+		for (uint32_t i = 0; i < Log::Capacity; ++i) {
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	//claim a cell to fill (nullptr if the ring is full):
+	Cell *claim(uint64_t *position) {
+		uint64_t pos = enqueue_position.load(std::memory_order_relaxed);
+		while (true) {
+			Cell &cell = cells[pos & (Log::Capacity - 1)];
+			uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+			int64_t difference = int64_t(sequence) - int64_t(pos);
+			if (difference == 0) {
+				if (enqueue_position.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					*position = pos;
+					return &cell;
+				}
+				//(pos was updated by the failed compare-exchange)
+			} else if (difference < 0) {
+				return nullptr;
+			} else {
+				pos = enqueue_position.load(std::memory_order_relaxed);
+			}
+		}
+	}
+	void publish(Cell *cell, uint64_t position) {
+		cell->sequence.store(position + 1, std::memory_order_release);
+	}
+
+	//next published record, if any (consumer only):
+	bool pop(LogRecord *record) {
+		Cell &cell = cells[dequeue_position & (Log::Capacity - 1)];
+		if (cell.sequence.load(std::memory_order_acquire) != dequeue_position + 1) return false;
+		*record = cell.record;
+		cell.sequence.store(dequeue_position + Log::Capacity, std::memory_order_release);
+		dequeue_position += 1;
+		return true;
+	}
+};
+
+static LogRing &ring() {
+	static LogRing ring;
+	return ring;
+}
+
+//----- producers -----
+
+void Log::write(Level level, char const *format, ...) {
+	va_list args;
+	va_start(args, format);
+	write_v(level, format, args);
+	va_end(args);
+}
+
+void Log::write_v(Level level, char const *format, va_list args) {
+	//(counted in flight *before* checking is_started -- both sequentially consistent -- so either
+	// this write sees stop()'s is_started = false, or stop() sees it in flight and waits for it)
+	in_flight.fetch_add(1);
+	if (!is_started.load()) {
+		in_flight.fetch_sub(1);
+		//prefix, message, and newline go out in one write, so lines from different threads don't interleave:
+		char line[16 + TextSize];
+		size_t length = std::strlen(prefix(level));
+		std::memcpy(line, prefix(level), length);
+		std::vsnprintf(line + length, TextSize, format, args);
+		length += std::strlen(line + length);
+		line[length++] = '\n';
+		std::cerr.write(line, length);
+		std::cerr.flush();
+		return;
+	}
+
+	LogRing &r = ring();
+	uint64_t position;
+	LogRing::Cell *cell = r.claim(&position);
+	if (!cell) {
+		r.dropped.fetch_add(1, std::memory_order_relaxed);
+		in_flight.fetch_sub(1, std::memory_order_release);
+		return;
+	}
+	cell->record.level = level;
+	cell->record.time_ns = now_ns();
+	std::vsnprintf(cell->record.text, sizeof(cell->record.text), format, args);
+	r.publish(cell, position);
+	in_flight.fetch_sub(1, std::memory_order_release);
+}
+
+//----- the writer -----
+
+struct LogWriter {
+	std::thread thread;
+	std::atomic< bool > quit;
+
+	LogWriter() : quit(false) { }
+	~LogWriter() {
+		//(if Log::stop() wasn't called -- e.g., an early return from main -- still don't leave the thread running)
+		if (thread.joinable()) {
+			quit.store(true, std::memory_order_release);
+			thread.join();
+		}
+	}
+
+	//per-message repeat counting:
+	struct Repeats {
+		Log::Level level = Log::Info;
+		uint64_t window_start = 0; //start of the current one-second window
+		uint32_t written = 0; //copies written in this window
+		uint64_t counted = 0; //copies not written in this window
+		uint64_t last_seen = 0;
+	};
+	std::unordered_map< std::string, Repeats > repeats; //keyed by message text
+	static const uint64_t Window = 1000000000ULL; //(one second, in nanoseconds)
+
+	//(lines are collected here and written to std::cerr a batch at a time, so they never interleave with direct writes)
+	std::ostringstream out;
+	void flush() {
+		std::string text = out.str();
+		if (text.empty()) return;
+		std::cerr.write(text.data(), text.size());
+		std::cerr.flush();
+		out.str("");
+	}
+
+	void write_counted(std::string const &text, Repeats &r, uint64_t now) {
+		if (r.counted == 0) return;
+		out << prefix(r.level) << text << " (repeated " << r.counted << " more times in "
+			<< double(now - r.window_start) * 1e-9 << "s)\n";
+		r.counted = 0;
+	}
+
+	void handle(LogRecord const &record) {
+		Repeats &r = repeats[record.text];
+		r.level = record.level;
+		r.last_seen = record.time_ns;
+		if (record.time_ns - r.window_start >= Window) {
+			write_counted(record.text, r, record.time_ns);
+			r.window_start = record.time_ns;
+			r.written = 0;
+		}
+		if (r.written < Log::Burst) {
+			out << prefix(record.level) << record.text << '\n';
+			r.written += 1;
+		} else {
+			r.counted += 1;
+		}
+	}
+
+	//write counts for windows that have ended (all of them, if 'everything'); forget idle messages:
+	void finish_windows(uint64_t now, bool everything) {
+		for (auto r = repeats.begin(); r != repeats.end(); ) {
+			if (everything || now - r->second.window_start >= Window) {
+				write_counted(r->first, r->second, now);
+			}
+			if (now - r->second.last_seen >= 10 * Window) {
+				r = repeats.erase(r);
+			} else {
+				++r;
+			}
+		}
+	}
+
+	//write everything queued; returns true if anything was:
+	bool drain() {
+		LogRing &r = ring();
+		bool any = false;
+		LogRecord record;
+		while (r.pop(&record)) {
+			handle(record);
+			any = true;
+		}
+		uint64_t dropped = r.dropped.exchange(0, std::memory_order_relaxed);
+		if (dropped) {
+			out << "WARNING: log queue full; dropped " << dropped << " messages.\n";
+			any = true;
+		}
+		return any;
+	}
+
+	void run() {
+		Trace::set_thread_name("log writer");
+		while (true) {
+			bool quitting = quit.load(std::memory_order_acquire);
+			bool any = drain();
+			finish_windows(now_ns(), false);
+			flush();
+			if (quitting && !any) break;
+			if (!any) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		}
+	}
+};
+
+static std::unique_ptr< LogWriter > writer;
+
+void Log::start() {
+	if (writer) return;
+	ring(); //(construct the ring before any producer can see is_started)
+	writer.reset(new LogWriter());
+	writer->thread = std::thread(&LogWriter::run, writer.get());
+	is_started.store(true, std::memory_order_release);
+}
+
+void Log::stop() {
+	if (!writer) return;
+	is_started.store(false);
+	//wait for writes that already saw the log as started -- after this, every claimed record is published
+	// (and later writes go straight to std::cerr):
+	while (in_flight.load() != 0) {
+		std::this_thread::yield();
+	}
+	writer->quit.store(true, std::memory_order_release);
+	writer->thread.join();
+	//(anything the writer thread hadn't gotten to)
+	writer->drain();
+	writer->finish_windows(now_ns(), true);
+	writer->flush();
+	writer.reset();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdarg>
+
+/*
+ * Log is for diagnostics that may fire on hot paths (e.g., a GL error every frame):
+ *
+ *   Log::write(Log::Warning, "gl error '%s' at %s", name, where);
+ *
+ * write() formats (printf-style, truncated to fit) straight into a fixed-size record in a
+ * lock-free ring (many producers, one consumer) and returns -- no allocation, no locks, no flushing.
+ * A background thread (Log::start(), from main.cpp) takes records off the ring and writes them to std::cerr,
+ * collapsing repeats: after 'Burst' copies of the same message in a second, copies are counted
+ * instead of written, and the count is written when the second is up.
+ * If the ring is full, messages are dropped (and the number dropped is reported).
+ *
+ * Before start() (or after stop()), write() just writes to std::cerr directly, so tools
+ * without a log thread (e.g., convert-level) still see their messages.
+ * stop() waits for writes already under way, so a message is never lost to shutdown:
+ * it is either queued (and written by stop()) or written directly.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_PRINTF_FORMAT(FMT, ARGS) __attribute__((format(printf, FMT, ARGS)))
+#else
+#define LOG_PRINTF_FORMAT(FMT, ARGS)
+#endif
+
+struct Log {
+	enum Level : uint8_t {
+		Info,
+		Warning, //(written with a "WARNING: " prefix)
+		Error, //(written with an "ERROR: " prefix)
+	};
+
+	static void write(Level level, char const *format, ...) LOG_PRINTF_FORMAT(2, 3);
+	static void write_v(Level level, char const *format, va_list args);
+
+	//start/stop the background writer thread (stop() writes everything queued, including writes racing with it):
+	static void start();
+	static void stop();
+
+	static const uint32_t Capacity = 1024; //records in the ring (a power of two)
+	static const uint32_t TextSize = 240; //characters per message, including the terminating '\0'
+	static const uint32_t Burst = 3; //copies of a message written per second before the rest are counted
+
+	static std::atomic< bool > is_started;
+};
@@ -1,8 +1,199 @@
 #include "Mode.hpp"
 
+#include "ModeLoader.hpp"
+#include "StateHash.hpp"
+#include "GL.hpp"
+#include "gl_errors.hpp"
+#include "Log.hpp"
+
+#include <chrono>
+
 std::shared_ptr< Mode > Mode::current;
+std::vector< Mode::Layer > Mode::stack;
+glm::uvec2 Mode::current_window_size = glm::uvec2(0);
+glm::uvec2 Mode::current_drawable_size = glm::uvec2(0);
+
+//Framebuffer (plus color texture) that holds a cached layer's last frame:
+struct LayerFramebuffer {
+	LayerFramebuffer() { }
+	~LayerFramebuffer() {
+		glDeleteFramebuffers(1, &fb);
+		glDeleteTextures(1, &color_tex);
+	}
+	GLuint fb = 0;
+	GLuint color_tex = 0;
+	glm::uvec2 size = glm::uvec2(0);
+	bool valid = false; //does it hold an up-to-date frame?
+
+	//(re-)allocate the framebuffer if needed:
+	void resize(glm::uvec2 const &new_size) {
+		if (fb && size == new_size) return;
+		valid = false;
+		size = new_size;
+		if (!fb) {
+			glGenFramebuffers(1, &fb);
+			glGenTextures(1, &color_tex);
+		}
+		glBindTexture(GL_TEXTURE_2D, color_tex);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		GLint old_fb = 0;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &old_fb);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_tex, 0);
+		if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			Log::write(Log::Warning, "layer cache framebuffer is incomplete.");
+		}
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, old_fb);
+
+		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+	}
+};
+
+//drop all cached frames (the layers they captured have changed):
+static void invalidate_caches() {
+	for (auto &layer : Mode::stack) {
+		if (layer.framebuffer) layer.framebuffer->valid = false;
+	}
+}
+
+//tell a mode entering the stack what size the window is:
+static void send_size(std::shared_ptr< Mode > const &mode) {
+	if (mode && Mode::current_drawable_size.x != 0 && Mode::current_drawable_size.y != 0) {
+		mode->resize(Mode::current_window_size, Mode::current_drawable_size);
+	}
+}
 
 void Mode::set_current(std::shared_ptr< Mode > const &new_current) {
+	stack.clear();
+	if (new_current) stack.emplace_back(new_current);
 	current = new_current;
-	//NOTE: may wish to, e.g., trigger resize events on new current mode.
+	send_size(new_current);
+}
+
+void Mode::set_size(glm::uvec2 const &window_size, glm::uvec2 const &drawable_size) {
+	current_window_size = window_size;
+	current_drawable_size = drawable_size;
+	for (size_t i = 0; i < stack.size(); ++i) {
+		std::shared_ptr< Mode > mode = stack[i].mode;
+		send_size(mode);
+	}
+}
+
+void Mode::push(std::shared_ptr< Mode > const &mode, bool pause_below, bool cache_below, float below_draw_budget) {
+	if (!mode) return;
+	if (!stack.empty()) {
+		stack.back().paused = pause_below;
+		stack.back().cached = cache_below;
+		stack.back().draw_budget = below_draw_budget;
+	}
+	stack.emplace_back(mode);
+	current = mode;
+	send_size(mode);
+}
+
+void Mode::pop() {
+	if (!stack.empty()) stack.pop_back();
+	if (stack.empty()) {
+		current = nullptr;
+		return;
+	}
+	//the new top layer is live again:
+	stack.back().paused = false;
+	stack.back().cached = false;
+	stack.back().draw_budget = 0.0f;
+	invalidate_caches();
+	current = stack.back().mode;
+}
+
+void Mode::set_current_async(std::function< std::shared_ptr< Mode >() > const &make_mode) {
+	if (ModeLoader::instance) {
+		ModeLoader::instance->load(make_mode);
+	} else {
+		set_current(make_mode());
+	}
+}
+
+void Mode::update_stack(float elapsed) {
+	//NOTE: modes may push/pop/set_current during update, so hold a reference and re-check bounds:
+	for (size_t i = 0; i < stack.size(); ++i) {
+		if (stack[i].paused && i + 1 < stack.size()) continue;
+		std::shared_ptr< Mode > mode = stack[i].mode;
+		auto before = std::chrono::high_resolution_clock::now();
+		mode->update(elapsed);
+		auto after = std::chrono::high_resolution_clock::now();
+		if (i < stack.size() && stack[i].mode == mode) {
+			stack[i].update_time = std::chrono::duration< float >(after - before).count();
+		}
+	}
+}
+
+uint64_t Mode::stack_state_hash() {
+	StateHash hash;
+	for (auto const &layer : stack) {
+		hash.add(layer.mode->state_hash());
+		hash.add(uint8_t(layer.paused));
+	}
+	return hash.value;
+}
+
+void Mode::draw_stack(glm::uvec2 const &drawable_size) {
+	if (stack.empty()) return;
+
+	GLint target_fb = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target_fb);
+
+	auto draw_layer = [&drawable_size](Layer &layer) {
+		auto before = std::chrono::high_resolution_clock::now();
+		layer.mode->draw(drawable_size);
+		auto after = std::chrono::high_resolution_clock::now();
+		layer.draw_time = std::chrono::duration< float >(after - before).count();
+	};
+
+	//layers at or below 'begin' come from the highest cached layer's framebuffer:
+	size_t begin = 0;
+	for (size_t c = stack.size() - 1; c > 0; --c) {
+		Layer &cached = stack[c-1];
+		if (!cached.cached) continue;
+
+		if (!cached.framebuffer) cached.framebuffer = std::make_shared< LayerFramebuffer >();
+		LayerFramebuffer &fb = *cached.framebuffer;
+		fb.resize(drawable_size);
+		if (!fb.valid) {
+			//draw everything up to and including the cached layer into its framebuffer:
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb.fb);
+			for (size_t i = 0; i < c; ++i) {
+				draw_layer(stack[i]);
+			}
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target_fb);
+			fb.valid = true;
+		}
+
+		//copy the cached frame to the target:
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fb.fb);
+		glBlitFramebuffer(0, 0, fb.size.x, fb.size.y, 0, 0, fb.size.x, fb.size.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+		begin = c;
+		break;
+	}
+
+	for (size_t i = begin; i < stack.size(); ++i) {
+		draw_layer(stack[i]);
+	}
+
+	//check frame budgets: a paused layer that is too slow to draw gets cached instead
+	// (since it isn't updating, its frame only changes when the window does):
+	for (size_t i = 0; i + 1 < stack.size(); ++i) {
+		Layer &layer = stack[i];
+		if (layer.paused && !layer.cached && layer.draw_budget > 0.0f && layer.draw_time > layer.draw_budget) {
+			Log::write(Log::Info, "NOTE: layer %u took %.3fms to draw (budget: %.3fms); caching it.", uint32_t(i), layer.draw_time * 1000.0f, layer.draw_budget * 1000.0f);
+			layer.cached = true;
+		}
+	}
+
+	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
 }
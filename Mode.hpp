@@ -4,6 +4,10 @@
 #include <glm/glm.hpp>
 
 #include <memory>
+#include <functional>
+#include <vector>
+
+struct LayerFramebuffer; //defined in Mode.cpp
 
 struct Mode : std::enable_shared_from_this< Mode > {
 	virtual ~Mode() { }
@@ -20,9 +24,66 @@ struct Mode : std::enable_shared_from_this< Mode > {
 	//draw is called after update:
 	virtual void draw(glm::uvec2 const &drawable_size) = 0;
 
+	//state_hash should summarize the mode's simulation state (e.g., with StateHash);
+	// input replays use it to detect when a run diverges from its recording:
+	virtual uint64_t state_hash() const { return 0; }
+
+	//resize is called when the window changes size (and when the mode becomes part of the stack):
+	// (a good place to compute transforms that only depend on the window)
+	virtual void resize(glm::uvec2 const &window_size, glm::uvec2 const &drawable_size) { }
+
+	//Mode::set_size records the current window size and passes it along to every mode on the stack:
+	// (called by the main loop when the window is resized)
+	static glm::uvec2 current_window_size;
+	static glm::uvec2 current_drawable_size;
+	static void set_size(glm::uvec2 const &window_size, glm::uvec2 const &drawable_size);
+
 	//Mode::current is the Mode to which events are dispatched.
 	// use 'set_current' to change the current Mode (e.g., to switch to a menu)
+	// (this replaces the whole Mode::stack -- see below)
 	static std::shared_ptr< Mode > current;
 	static void set_current(std::shared_ptr< Mode > const &);
+
+	//Modes can also be layered (e.g., a pause menu or debug view over the game):
+	// Mode::stack is drawn bottom-to-top each frame; Mode::current is always the top layer.
+	struct Layer {
+		Layer(std::shared_ptr< Mode > const &mode_) : mode(mode_) { }
+		std::shared_ptr< Mode > mode;
+
+		//paused layers don't get update() calls:
+		bool paused = false;
+
+		//cached layers reuse their last frame (along with everything below them) from a framebuffer
+		// instead of drawing again -- only the layers above a cached layer are actually drawn:
+		bool cached = false;
+
+		//if a paused layer's draw takes longer than this many seconds, it gets cached automatically:
+		// (0.0f means "no budget")
+		float draw_budget = 0.0f;
+
+		//CPU time (in seconds) spent in this layer's most recent update() and draw():
+		float update_time = 0.0f;
+		float draw_time = 0.0f;
+
+		//framebuffer holding the cached frame (created on demand):
+		std::shared_ptr< LayerFramebuffer > framebuffer;
+	};
+	static std::vector< Layer > stack;
+
+	//push 'mode' on top of the stack; the layer it covers is marked paused and/or cached,
+	// and gets 'below_draw_budget' as its draw_budget:
+	static void push(std::shared_ptr< Mode > const &mode, bool pause_below = true, bool cache_below = true, float below_draw_budget = 0.0f);
+	//remove the top layer; the layer below becomes current (and live again):
+	static void pop();
+
+	//called by the main loop once per frame:
+	static void update_stack(float elapsed); //update every un-paused layer (and the top one)
+	static void draw_stack(glm::uvec2 const &drawable_size); //draw the stack into the currently bound framebuffer
+	static uint64_t stack_state_hash(); //combined state_hash of every layer
+
+	//set_current_async constructs the new Mode on the ModeLoader's worker thread
+	// and makes it current once its OpenGL resources have finished uploading.
+	// (constructs synchronously if no ModeLoader exists)
+	static void set_current_async(std::function< std::shared_ptr< Mode >() > const &make_mode);
 };
 
@@ -0,0 +1,128 @@
+#include "ModeLoader.hpp"
+
+#include "Trace.hpp"
+
+#include "gl_errors.hpp"
+
+#include <stdexcept>
+#include <iostream>
+
+ModeLoader *ModeLoader::instance = nullptr;
+
+ModeLoader::ModeLoader(SDL_Window *window_) : window(window_) {
+	SDL_GLContext main_context = SDL_GL_GetCurrentContext();
+	if (!main_context) {
+		throw std::runtime_error("ModeLoader must be created while the main OpenGL context is current.");
+	}
+
+	//create a second context that shares objects with the main one:
+	// (SDL_GL_CreateContext also makes the new context current, so switch back afterward)
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+	context = SDL_GL_CreateContext(window);
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+	SDL_GL_MakeCurrent(window, main_context);
+
+	if (!context) {
+		throw std::runtime_error(std::string("Error creating loader OpenGL context: ") + SDL_GetError());
+	}
+
+	worker = std::thread(&ModeLoader::run, this);
+
+	if (!instance) instance = this;
+}
+
+ModeLoader::~ModeLoader() {
+	if (instance == this) instance = nullptr;
+
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	cv.notify_all();
+	worker.join();
+
+	//modes that finished loading but were never swapped in:
+	for (auto &l : loaded) {
+		if (l.fence) glDeleteSync(l.fence);
+	}
+	loaded.clear();
+
+	SDL_GL_DeleteContext(context);
+	context = nullptr;
+}
+
+void ModeLoader::load(std::function< std::shared_ptr< Mode >() > const &make_mode) {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		todo.emplace_back(make_mode);
+	}
+	cv.notify_one();
+}
+
+bool ModeLoader::busy() {
+	std::unique_lock< std::mutex > lock(mutex);
+	return !todo.empty() || in_progress != 0 || !loaded.empty();
+}
+
+void ModeLoader::poll() {
+	//find the newest mode whose fence has signaled:
+	// (older finished modes are superseded by newer ones)
+	std::shared_ptr< Mode > ready;
+	while (true) {
+		Loaded l;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			if (loaded.empty()) break;
+			if (loaded.front().fence) {
+				//check fence without blocking:
+				GLenum status = glClientWaitSync(loaded.front().fence, 0, 0);
+				if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+			}
+			l = loaded.front();
+			loaded.pop_front();
+		}
+		if (l.fence) glDeleteSync(l.fence);
+		if (l.error) std::rethrow_exception(l.error);
+		ready = l.mode;
+	}
+
+	if (ready) Mode::set_current(ready);
+}
+
+void ModeLoader::run() {
+	SDL_GL_MakeCurrent(window, context);
+	Trace::set_thread_name("mode loader");
+
+	while (true) {
+		std::function< std::shared_ptr< Mode >() > make_mode;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			while (!quit && todo.empty()) cv.wait(lock);
+			if (quit) break;
+			make_mode = todo.front();
+			todo.pop_front();
+			in_progress += 1;
+		}
+
+		Loaded l;
+		try {
+			l.mode = make_mode();
+		} catch (...) {
+			l.error = std::current_exception();
+		}
+
+		//fence after all of the mode's uploads, then flush so the fence actually reaches the GPU:
+		l.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+
+		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			loaded.emplace_back(l);
+			in_progress -= 1;
+		}
+	}
+
+	SDL_GL_MakeCurrent(window, nullptr);
+}
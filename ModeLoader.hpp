@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Mode.hpp"
+#include "GL.hpp"
+
+#include <SDL.h>
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+
+/*
+ * ModeLoader constructs Modes on a worker thread that owns its own OpenGL context
+ * (sharing objects with the main context), so the main loop keeps drawing while
+ * the next mode compiles shaders and uploads its data.
+ *
+ * A loaded mode is swapped into Mode::current by poll() only once a fence placed
+ * after its construction has signaled -- i.e., once all of its uploads are done.
+ *
+ * Note: vertex array objects and framebuffers are *not* shared between contexts,
+ *  so modes must create those lazily on the main thread (see ColorTextureBuffers).
+ */
+
+struct ModeLoader {
+	//create the worker context + thread;
+	// call on the main thread, with the main context current:
+	ModeLoader(SDL_Window *window);
+	~ModeLoader();
+
+	//queue construction of a mode on the worker thread:
+	// (when it is ready, poll() will make it current)
+	void load(std::function< std::shared_ptr< Mode >() > const &make_mode);
+
+	//call once per frame from the main thread:
+	// makes the most recently loaded mode current if its resources are ready.
+	// re-throws (on the main thread) any exception thrown while constructing a mode.
+	void poll();
+
+	//is anything queued or waiting on its fence?
+	bool busy();
+
+	//the loader used by Mode::set_current_async (nullptr if none was created):
+	static ModeLoader *instance;
+
+	//----- internals -----
+	SDL_Window *window = nullptr;
+	SDL_GLContext context = nullptr;
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool quit = false;
+
+	std::deque< std::function< std::shared_ptr< Mode >() > > todo; //guarded by mutex
+
+	struct Loaded {
+		std::shared_ptr< Mode > mode;
+		GLsync fence = 0;
+		std::exception_ptr error;
+	};
+	std::deque< Loaded > loaded; //guarded by mutex; in order of completion
+	uint32_t in_progress = 0; //guarded by mutex
+
+	void run(); //worker thread body
+};
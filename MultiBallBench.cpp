@@ -0,0 +1,126 @@
+#include "MultiBallBench.hpp"
+
+#include "BreakoutGame.hpp"
+#include "Level.hpp"
+#include "percentile.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <cmath>
+
+bool run_multiball_bench(MultiBallBenchOptions const &options, std::ostream &out) {
+	typedef std::chrono::high_resolution_clock Clock;
+	bool matched = true;
+
+	for (uint32_t brick_count : options.brick_counts) {
+		//----- generate level (as ScalingBench does) -----
+		LevelGenOptions gen;
+		gen.seed = options.seed;
+		gen.brick_count = brick_count;
+		gen.density = 0.85f;
+		gen.aspect = 13.0f / 6.0f;
+		gen.field_radius = glm::vec2(6.5f, 3.0f);
+		for (uint32_t c = 0; c < BreakoutGame::COLOR_COUNT; ++c) {
+			gen.colors.emplace_back(BreakoutGame::COLORS[c].first);
+		}
+		Level level(generate_level(gen).serialize(), "generated level");
+
+		std::vector< bool > rules;
+		if (options.discrete) rules.emplace_back(false);
+		if (options.swept) rules.emplace_back(true);
+		for (bool swept : rules) {
+			for (uint32_t ball_count : options.ball_counts) {
+				//----- set up: the main ball plus (ball_count - 1) extras -----
+				//(extras that reach the floor are replaced between frames, so the count holds steady)
+				BreakoutGame game;
+				game.swept = swept;
+				game.load_level(level);
+				game.launch();
+				auto top_up = [ball_count](BreakoutGame &g, std::mt19937 &mt) {
+					std::uniform_real_distribution< float > unit(0.0f, 1.0f);
+					while (g.extra_balls.size() + 1 < ball_count) {
+						//heading up from a random spot below the bricks:
+						glm::vec2 at = glm::vec2(
+							(unit(mt) * 2.0f - 1.0f) * (g.court_radius.x - g.ball_radius.x),
+							-g.court_radius.y + 1.0f + unit(mt) * 0.5f
+						);
+						float angle = 3.14159265f * (0.25f + 0.5f * unit(mt));
+						g.add_ball(at, 6.0f * glm::vec2(std::cos(angle), std::sin(angle)));
+					}
+				};
+				std::mt19937 mt(options.seed);
+				top_up(game, mt);
+
+				//the paddle follows the main ball (as in ScalingBench), and changes color now and then:
+				auto play = [](BreakoutGame &g, uint32_t frame) {
+					g.paddle.x = g.ball.x - 0.3f * g.paddle_radius.x;
+					if (frame % 60 == 59) g.cycle_paddle_color();
+					if (g.ball_reset) g.launch();
+					g.update(1.0f / 60.0f);
+				};
+
+				//----- check against brute force -----
+				std::string check = "not checked";
+				if (uint64_t(brick_count) * ball_count <= options.check_pairs) {
+					BreakoutGame pruned = game;
+					BreakoutGame brute = game;
+					brute.broadphase = false;
+					std::mt19937 pruned_mt = mt, brute_mt = mt;
+					check = "matches brute force";
+					for (uint32_t frame = 0; frame < options.check_frames; ++frame) {
+						play(pruned, frame);
+						top_up(pruned, pruned_mt);
+						play(brute, frame);
+						top_up(brute, brute_mt);
+						if (pruned.state_hash() != brute.state_hash()) {
+							check = "DIFFERS from brute force at frame " + std::to_string(frame);
+							matched = false;
+							break;
+						}
+					}
+				}
+
+				//----- measure, with each thread count -----
+				//(every thread count must play the same game, frame for frame)
+				std::vector< uint64_t > hashes; //per frame, from the first thread count
+				for (uint32_t t = 0; t < options.thread_counts.size(); ++t) {
+					uint32_t threads = options.thread_counts[t];
+					std::unique_ptr< ThreadPool > pool;
+					if (threads != 1) pool.reset(new ThreadPool(threads));
+					BreakoutGame timed = game;
+					timed.pool = pool.get();
+					std::mt19937 timed_mt = mt;
+
+					std::vector< float > update_ns;
+					update_ns.reserve(options.frames);
+					std::string same = "";
+					for (uint32_t frame = 0; frame < options.frames; ++frame) {
+						auto before = Clock::now();
+						play(timed, frame);
+						update_ns.emplace_back(std::chrono::duration< float, std::nano >(Clock::now() - before).count());
+						top_up(timed, timed_mt);
+
+						uint64_t hash = timed.state_hash();
+						if (t == 0) {
+							hashes.emplace_back(hash);
+						} else if (same == "" && hash != hashes[frame]) {
+							same = "; DIFFERS from " + std::to_string(options.thread_counts[0]) + " thread(s) at frame " + std::to_string(frame);
+							matched = false;
+						}
+					}
+					std::sort(update_ns.begin(), update_ns.end());
+
+					out << "Multi-ball (" << (swept ? "swept" : "discrete") << "): " << brick_count << " bricks, " << ball_count << " balls, " << (pool ? pool->size() : 1) << " thread(s): "
+						<< percentile(update_ns, 0.5f) << " ns/frame (p50), " << percentile(update_ns, 0.95f) << " ns/frame (p95); "
+						<< (level.brick_count - timed.bricks.size()) << " bricks broken; "
+						<< check << same << "." << std::endl;
+				}
+			}
+		}
+	}
+	return matched;
+}
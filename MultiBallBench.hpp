@@ -0,0 +1,39 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+/*
+ * The multi-ball benchmark plays Breakout with many balls at once (BreakoutGame::add_ball) on generated
+ * levels (see generate_level) and, for each (bricks, balls) combination, reports BreakoutGame::update
+ * time per frame, with each of several thread counts (see BreakoutGame::pool) -- checking that every
+ * thread count plays exactly the same game.
+ * (Extra balls that are lost are replaced between frames, so the ball count holds steady.)
+ * Where brute force is affordable, it also steps a copy of each game with BreakoutGame::broadphase off
+ * (every ball tested against every brick and ball) and checks the two stay bit-identical (state_hash).
+ *
+ * Each combination runs with both sets of rules (BreakoutGame::swept):
+ *  - discrete: contacts with bricks and balls are both found in parallel (and merged in a fixed order);
+ *  - swept (as BreakoutMode plays): each ball sweeps through the bricks in turn, on the calling thread,
+ *    so extra threads only speed up finding ball-vs-ball contacts.
+ *
+ * Needs no window (main.cpp runs this with --multiball-bench).
+ */
+
+struct MultiBallBenchOptions {
+	std::vector< uint32_t > brick_counts = std::vector< uint32_t >{10000, 100000};
+	std::vector< uint32_t > ball_counts = std::vector< uint32_t >{1, 100, 1000, 4000};
+	uint32_t seed = 0;
+	bool discrete = true; //run with BreakoutGame::swept off...
+	bool swept = true; //...and on
+	std::vector< uint32_t > thread_counts = std::vector< uint32_t >{1, 0}; //0 => one per hardware thread
+
+	uint32_t frames = 300; //frames measured per combination
+	//check against brute force when bricks * balls is at most this:
+	uint64_t check_pairs = 20000000;
+	uint32_t check_frames = 60; //frames checked per combination
+};
+
+//returns false if the sweep-and-prune and brute-force games (or games with different thread counts) ever differ:
+bool run_multiball_bench(MultiBallBenchOptions const &options, std::ostream &out);
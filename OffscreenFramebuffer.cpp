@@ -0,0 +1,50 @@
+#include "OffscreenFramebuffer.hpp"
+
+#include "gl_errors.hpp"
+
+#include <stdexcept>
+#include <string>
+
+OffscreenFramebuffer::OffscreenFramebuffer(glm::uvec2 const &size_) : size(size_) {
+	glGenRenderbuffers(1, &color_rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+
+	//(the window's framebuffer has depth + stencil, so modes may expect them)
+	glGenRenderbuffers(1, &depth_stencil_rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth_stencil_rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.x, size.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLint old_fb = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &old_fb);
+	glGenFramebuffers(1, &fb);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb);
+	glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rb);
+	glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_stencil_rb);
+	GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, old_fb);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		throw std::runtime_error("Offscreen framebuffer (" + std::to_string(size.x) + "x" + std::to_string(size.y) + ") is incomplete.");
+	}
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+OffscreenFramebuffer::~OffscreenFramebuffer() {
+	glDeleteFramebuffers(1, &fb);
+	glDeleteRenderbuffers(1, &color_rb);
+	glDeleteRenderbuffers(1, &depth_stencil_rb);
+}
+
+void OffscreenFramebuffer::bind() const {
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb);
+	glViewport(0, 0, size.x, size.y);
+}
+
+void OffscreenFramebuffer::read(std::vector< glm::u8vec4 > *pixels) const {
+	pixels->resize(size_t(size.x) * size.y);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fb);
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels->data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+ * OffscreenFramebuffer is a color (RGBA8) + depth/stencil framebuffer of a given size,
+ * for drawing frames that are never shown (--headless, and comparisons against SoftRaster).
+ * Needs a current OpenGL context to construct and destroy.
+ */
+
+struct OffscreenFramebuffer {
+	OffscreenFramebuffer(glm::uvec2 const &size);
+	~OffscreenFramebuffer();
+
+	OffscreenFramebuffer(OffscreenFramebuffer const &) = delete;
+	OffscreenFramebuffer &operator=(OffscreenFramebuffer const &) = delete;
+
+	//bind as the draw framebuffer and set the viewport to cover it:
+	void bind() const;
+
+	//read back the color buffer (lower left first, as glReadPixels does):
+	void read(std::vector< glm::u8vec4 > *pixels) const;
+
+	glm::uvec2 size;
+	GLuint fb = 0;
+	GLuint color_rb = 0;
+	GLuint depth_stencil_rb = 0;
+};
@@ -0,0 +1,138 @@
+#include "ParticleBench.hpp"
+
+#include "Particles.hpp"
+#include "ParticleProgram.hpp"
+#include "SoftRaster.hpp"
+#include "OffscreenFramebuffer.hpp"
+#include "percentile.hpp"
+#include "ThreadPool.hpp"
+
+#include "GL.hpp"
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+bool run_particle_bench(ParticleBenchOptions const &options, std::ostream &out) {
+	typedef std::chrono::high_resolution_clock Clock;
+	float const Budget = 1000.0f / 60.0f; //ms
+
+	//a Breakout-sized court, fit to the framebuffer:
+	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
+	float aspect = options.size.x / float(options.size.y);
+	float scale = std::min(aspect / court_radius.x, 1.0f / court_radius.y);
+	glm::mat4 court_to_clip = glm::mat4(
+		glm::vec4(scale / aspect, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, scale, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
+	);
+	glm::u8vec4 bg_color = glm::u8vec4(0xf3, 0xff, 0xc6, 0xff);
+
+	//bursts (like broken bricks) at random spots in the court until the pool is full:
+	Particles particles(options.particles);
+	std::mt19937 mt(0);
+	std::uniform_real_distribution< float > unit(0.0f, 1.0f);
+	auto refill = [&particles, &mt, &unit, &court_radius]() {
+		while (particles.count < particles.capacity) {
+			glm::vec2 at = glm::vec2(unit(mt) * 2.0f - 1.0f, unit(mt) * 2.0f - 1.0f) * court_radius;
+			glm::u8vec4 color = glm::u8vec4(mt() & 0xff, mt() & 0xff, mt() & 0xff, 0xff);
+			particles.burst(at, glm::vec2(0.5f, 0.3f), color, 64);
+		}
+	};
+	refill();
+
+	auto keep_going = [&options](uint32_t frames, Clock::time_point start) -> bool {
+		if (frames < options.min_frames) return true;
+		return std::chrono::duration< float >(Clock::now() - start).count() < options.seconds;
+	};
+	auto ms_since = [](Clock::time_point before) -> float {
+		return std::chrono::duration< float, std::milli >(Clock::now() - before).count();
+	};
+
+	out << "Particle benchmark: " << particles.capacity << " particles, " << options.size.x << "x" << options.size.y << ":\n";
+
+	//----- simulation + instanced OpenGL draw -----
+	std::vector< float > update_ms, draw_ms, frame_ms;
+	{
+		ParticleProgram program;
+		OffscreenFramebuffer framebuffer(options.size);
+		framebuffer.bind();
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_DEPTH_TEST);
+
+		auto start = Clock::now();
+		for (uint32_t frame = 0; keep_going(frame, start); ++frame) {
+			auto before_update = Clock::now();
+			particles.update(1.0f / 60.0f);
+			refill();
+			update_ms.emplace_back(ms_since(before_update));
+
+			auto before_draw = Clock::now();
+			glClearColor(bg_color.r / 255.0f, bg_color.g / 255.0f, bg_color.b / 255.0f, bg_color.a / 255.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+			program.draw(court_to_clip, particles);
+			glFinish(); //(count the rasterization, not just the submission)
+			draw_ms.emplace_back(ms_since(before_draw));
+
+			frame_ms.emplace_back(update_ms.back() + draw_ms.back());
+		}
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	}
+	std::sort(update_ms.begin(), update_ms.end());
+	std::sort(draw_ms.begin(), draw_ms.end());
+	std::sort(frame_ms.begin(), frame_ms.end());
+	out << "  update: " << percentile(update_ms, 0.5f) << " ms (p50), " << percentile(update_ms, 0.95f) << " ms (p95)\n";
+	out << "  OpenGL instanced draw: " << percentile(draw_ms, 0.5f) << " ms (p50), " << percentile(draw_ms, 0.95f) << " ms (p95)\n";
+	out << "  frame: " << percentile(frame_ms, 0.5f) << " ms (p50), " << percentile(frame_ms, 0.95f) << " ms (p95) -- "
+		<< (1000.0f / percentile(frame_ms, 0.5f)) << " frames/sec\n";
+
+	bool gl_fits = percentile(frame_ms, 0.95f) <= Budget;
+
+	//----- SoftRaster: the whole frame on the CPU (update, building the particles' rectangles, and rasterizing them) -----
+	bool soft_fits = false;
+	{
+		SoftRaster raster(options.threads);
+		uint32_t threads = (raster.pool ? raster.pool->size() : 1);
+		std::vector< SoftRaster::Rectangle > rectangles;
+		std::vector< glm::u8vec4 > pixels;
+		std::vector< float > soft_update_ms, build_ms, raster_ms, soft_frame_ms;
+		auto start = Clock::now();
+		for (uint32_t frame = 0; keep_going(frame, start); ++frame) {
+			auto before_update = Clock::now();
+			particles.update(1.0f / 60.0f);
+			refill();
+			soft_update_ms.emplace_back(ms_since(before_update));
+
+			auto before_build = Clock::now();
+			rectangles.clear();
+			particles.build_rectangles(&rectangles);
+			build_ms.emplace_back(ms_since(before_build));
+
+			auto before_raster = Clock::now();
+			raster.draw_rectangles(options.size, bg_color, court_to_clip, rectangles, &pixels);
+			raster_ms.emplace_back(ms_since(before_raster));
+
+			soft_frame_ms.emplace_back(soft_update_ms.back() + build_ms.back() + raster_ms.back());
+		}
+		std::sort(soft_update_ms.begin(), soft_update_ms.end());
+		std::sort(build_ms.begin(), build_ms.end());
+		std::sort(raster_ms.begin(), raster_ms.end());
+		std::sort(soft_frame_ms.begin(), soft_frame_ms.end());
+		out << "  SoftRaster on " << threads << " thread" << (threads == 1 ? "" : "s") << " (" << rectangles.size() << " rectangles):\n";
+		out << "    update: " << percentile(soft_update_ms, 0.5f) << " ms (p50), " << percentile(soft_update_ms, 0.95f) << " ms (p95)\n";
+		out << "    build triangles: " << percentile(build_ms, 0.5f) << " ms (p50), " << percentile(build_ms, 0.95f) << " ms (p95)\n";
+		out << "    rasterize: " << percentile(raster_ms, 0.5f) << " ms (p50), " << percentile(raster_ms, 0.95f) << " ms (p95)\n";
+		out << "    frame: " << percentile(soft_frame_ms, 0.5f) << " ms (p50), " << percentile(soft_frame_ms, 0.95f) << " ms (p95) -- "
+			<< (1000.0f / percentile(soft_frame_ms, 0.5f)) << " frames/sec\n";
+
+		soft_fits = percentile(soft_frame_ms, 0.95f) <= Budget;
+		out << "  " << (gl_fits ? "PASS" : "FAIL") << ": p95 update + OpenGL draw " << (gl_fits ? "fits" : "doesn't fit") << " in " << Budget << " ms.\n";
+		out << "  " << (soft_fits ? "PASS" : "FAIL") << ": p95 update + SoftRaster frame " << (soft_fits ? "fits" : "doesn't fit") << " in " << Budget << " ms"
+			<< " on " << threads << " thread" << (threads == 1 ? "" : "s") << (soft_fits ? "" : " (try more with --threads)") << ".\n";
+	}
+	out.flush();
+	return gl_fits && soft_fits;
+}
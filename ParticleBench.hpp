@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <cstdint>
+
+/*
+ * The particle benchmark keeps a Particles pool full (refilling it with bursts as particles die) and,
+ * for each frame, measures:
+ *  - Particles::update (SIMD integration + swap-remove compaction) plus the refill;
+ *  - ParticleProgram::draw (one instanced draw) into an offscreen framebuffer, waiting for it to finish;
+ *  - a whole software-rendered frame: the same update, building the particles' rectangles
+ *    (Particles::build_rectangles), and SoftRaster drawing them (on options.threads threads).
+ * It passes if the 95th percentiles of both frames (update + OpenGL draw, and update + build + SoftRaster)
+ * fit in a 60 fps frame; the report says how many threads SoftRaster used.
+ * (Run with Mesa's LIBGL_ALWAYS_SOFTWARE=1 to measure against a software rasterizer.)
+ *
+ * Needs a current OpenGL context (main.cpp runs this with --particle-bench).
+ */
+
+struct ParticleBenchOptions {
+	uint32_t particles = 100000; //live particles to keep
+	glm::uvec2 size = glm::uvec2(640, 480);
+	uint32_t threads = 0; //(for SoftRaster) 0 => one per hardware thread
+	uint32_t min_frames = 60;
+	float seconds = 2.0f; //(about) how long each renderer is measured
+};
+
+//returns false if either kind of frame doesn't fit in 1/60th of a second:
+bool run_particle_bench(ParticleBenchOptions const &options, std::ostream &out);
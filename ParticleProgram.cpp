@@ -0,0 +1,111 @@
+#include "ParticleProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+//for TRACE_SCOPE():
+#include "Trace.hpp"
+
+//for glm::value_ptr() :
+#include <glm/gtc/type_ptr.hpp>
+
+ParticleProgram::ParticleProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"uniform vec2 RADIUS;\n"
+		"uniform float FADE;\n"
+		"in float X;\n"
+		"in float Y;\n"
+		"in float Life;\n"
+		"in vec4 Color;\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		//triangle strip corners: (-,-), (+,-), (-,+), (+,+)
+		"	vec2 corner = vec2(float(gl_VertexID & 1) * 2.0 - 1.0, float(gl_VertexID >> 1) * 2.0 - 1.0);\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(vec2(X, Y) + corner * RADIUS, 0.0, 1.0);\n"
+		"	color = vec4(Color.rgb, Color.a * clamp(Life / FADE, 0.0, 1.0));\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	);
+
+	//look up the locations of vertex attributes:
+	X_float = glGetAttribLocation(program, "X");
+	Y_float = glGetAttribLocation(program, "Y");
+	Life_float = glGetAttribLocation(program, "Life");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	RADIUS_vec2 = glGetUniformLocation(program, "RADIUS");
+	FADE_float = glGetUniformLocation(program, "FADE");
+
+	glGenBuffers(1, &instance_buffer);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+ParticleProgram::~ParticleProgram() {
+	if (vertex_array) glDeleteVertexArrays(1, &vertex_array);
+	vertex_array = 0;
+	glDeleteBuffers(1, &instance_buffer);
+	instance_buffer = 0;
+	glDeleteProgram(program);
+	program = 0;
+}
+
+void ParticleProgram::draw(glm::mat4 const &object_to_clip, Particles const &particles) {
+	TRACE_SCOPE("ParticleProgram::draw");
+	if (particles.count == 0) return;
+
+	if (!vertex_array) {
+		glGenVertexArrays(1, &vertex_array);
+		glBindVertexArray(vertex_array);
+		//each attribute advances once per instance (particle), not per vertex:
+		GLuint attributes[4] = { X_float, Y_float, Life_float, Color_vec4 };
+		for (GLuint a : attributes) {
+			glEnableVertexAttribArray(a);
+			glVertexAttribDivisor(a, 1);
+		}
+		glBindVertexArray(0);
+	}
+
+	//upload the live part of each array, one after another:
+	// [x][y][life][color], each 'count' elements long
+	GLsizeiptr count = GLsizeiptr(particles.count);
+	GLsizeiptr floats = count * sizeof(float);
+	GLsizeiptr colors = count * sizeof(glm::u8vec4);
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	glBufferData(GL_ARRAY_BUFFER, 3 * floats + colors, nullptr, GL_STREAM_DRAW); //(orphan last frame's data)
+	glBufferSubData(GL_ARRAY_BUFFER, 0 * floats, floats, particles.x.data());
+	glBufferSubData(GL_ARRAY_BUFFER, 1 * floats, floats, particles.y.data());
+	glBufferSubData(GL_ARRAY_BUFFER, 2 * floats, floats, particles.life.data());
+	glBufferSubData(GL_ARRAY_BUFFER, 3 * floats, colors, particles.color.data());
+
+	glBindVertexArray(vertex_array);
+	glVertexAttribPointer(X_float, 1, GL_FLOAT, GL_FALSE, 0, (GLbyte *)0 + 0 * floats);
+	glVertexAttribPointer(Y_float, 1, GL_FLOAT, GL_FALSE, 0, (GLbyte *)0 + 1 * floats);
+	glVertexAttribPointer(Life_float, 1, GL_FLOAT, GL_FALSE, 0, (GLbyte *)0 + 2 * floats);
+	glVertexAttribPointer(Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (GLbyte *)0 + 3 * floats);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(program);
+	glUniformMatrix4fv(OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+	glUniform2fv(RADIUS_vec2, 1, glm::value_ptr(particles.radius));
+	glUniform1f(FADE_float, particles.fade);
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(particles.count));
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Particles.hpp"
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+//Shader program + instance buffer that draw a Particles pool with a single instanced draw call:
+// each particle is one instance of a four-vertex triangle strip (corners come from gl_VertexID),
+// and the pool's position, life, and color arrays are uploaded as they are (one after another in the
+// instance buffer) and read as per-instance attributes -- no per-particle vertices are built on the CPU.
+struct ParticleProgram {
+	ParticleProgram();
+	~ParticleProgram();
+
+	//draw the live particles in 'particles' (with whatever blending is current):
+	void draw(glm::mat4 const &object_to_clip, Particles const &particles);
+
+	GLuint program = 0;
+	//Attribute (per-instance variable) locations:
+	GLuint X_float = -1U;
+	GLuint Y_float = -1U;
+	GLuint Life_float = -1U;
+	GLuint Color_vec4 = -1U;
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint RADIUS_vec2 = -1U;
+	GLuint FADE_float = -1U;
+
+	//Buffer holding the particles' arrays (re-filled every draw):
+	GLuint instance_buffer = 0;
+
+	//Vertex array object reading instance_buffer, created by the first draw(),
+	// since VAOs are not shared between contexts (see ColorTextureBuffers::get_vertex_array):
+	// (attribute offsets depend on the particle count, so draw() sets them every time)
+	GLuint vertex_array = 0;
+};
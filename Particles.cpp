@@ -0,0 +1,128 @@
+#include "Particles.hpp"
+
+//for TRACE_SCOPE() and PERF_SCOPE():
+#include "Trace.hpp"
+#include "PerfCounters.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLES_SSE2
+#endif
+
+Particles::Particles(uint32_t capacity_) : capacity(capacity_) {
+	uint32_t padded = (capacity + 3) & ~3u;
+	x.resize(padded, 0.0f);
+	y.resize(padded, 0.0f);
+	vx.resize(padded, 0.0f);
+	vy.resize(padded, 0.0f);
+	life.resize(padded, 0.0f);
+	color.resize(padded, glm::u8vec4(0));
+}
+
+void Particles::burst(glm::vec2 const &center, glm::vec2 const &radius_, glm::u8vec4 const &color_, uint32_t count_) {
+	count_ = std::min(count_, capacity - count);
+	std::uniform_real_distribution< float > unit(0.0f, 1.0f);
+	for (uint32_t n = 0; n < count_; ++n) {
+		uint32_t i = count + n;
+		//start somewhere in the rectangle, heading away from its center (and a bit up):
+		glm::vec2 offset = glm::vec2(unit(mt) * 2.0f - 1.0f, unit(mt) * 2.0f - 1.0f);
+		float angle = std::atan2(offset.y, offset.x);
+		float s = speed * (0.5f + unit(mt));
+		x[i] = center.x + offset.x * radius_.x;
+		y[i] = center.y + offset.y * radius_.y;
+		vx[i] = s * std::cos(angle);
+		vy[i] = s * std::sin(angle) + 0.5f * speed;
+		life[i] = lifetime * (2.0f / 3.0f + (2.0f / 3.0f) * unit(mt));
+		color[i] = color_;
+	}
+	count += count_;
+}
+
+void Particles::update(float elapsed) {
+	TRACE_SCOPE("Particles::update");
+	PERF_SCOPE("Particles::update");
+
+	//----- integrate (all live particles, four at a time) -----
+	//(the arrays are padded to a multiple of four, so the last group may run into dead/unused slots -- harmless)
+	uint32_t groups_end = (count + 3) & ~3u;
+	bool any_died = false;
+#ifdef PARTICLES_SSE2
+	__m128 dt = _mm_set1_ps(elapsed);
+	__m128 dv = _mm_set1_ps(gravity * elapsed);
+	__m128 zero = _mm_setzero_ps();
+	int died = 0;
+	for (uint32_t i = 0; i < groups_end; i += 4) {
+		__m128 vy4 = _mm_add_ps(_mm_loadu_ps(&vy[i]), dv);
+		_mm_storeu_ps(&vy[i], vy4);
+		_mm_storeu_ps(&x[i], _mm_add_ps(_mm_loadu_ps(&x[i]), _mm_mul_ps(_mm_loadu_ps(&vx[i]), dt)));
+		_mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(vy4, dt)));
+		__m128 life4 = _mm_sub_ps(_mm_loadu_ps(&life[i]), dt);
+		_mm_storeu_ps(&life[i], life4);
+		int dead = _mm_movemask_ps(_mm_cmple_ps(life4, zero));
+		if (i + 4 > count) dead &= (1 << (count - i)) - 1; //(slots past the end were dead already)
+		died |= dead;
+	}
+	any_died = (died != 0);
+#else
+	for (uint32_t i = 0; i < groups_end; ++i) {
+		vy[i] += gravity * elapsed;
+		x[i] += vx[i] * elapsed;
+		y[i] += vy[i] * elapsed;
+		life[i] -= elapsed;
+		any_died = any_died || (i < count && life[i] <= 0.0f);
+	}
+#endif
+	if (!any_died) return;
+
+	//----- remove the dead (swap-remove: the last live particle takes each dead one's place) -----
+	for (uint32_t i = 0; i < count; ) {
+		if (life[i] > 0.0f) {
+			++i;
+			continue;
+		}
+		count -= 1;
+		x[i] = x[count];
+		y[i] = y[count];
+		vx[i] = vx[count];
+		vy[i] = vy[count];
+		life[i] = life[count];
+		color[i] = color[count];
+		//(don't advance: the moved particle may be dead too)
+	}
+}
+
+void Particles::build_vertices(std::vector< PosColTexVertex > *vertices) const {
+	vertices->reserve(vertices->size() + 6 * count);
+	for (uint32_t i = 0; i < count; ++i) {
+		glm::vec2 center = glm::vec2(x[i], y[i]);
+		glm::u8vec4 c = color[i];
+		//(same fade as ParticleProgram's vertex shader)
+		c.a = uint8_t(std::round(c.a * std::min(1.0f, std::max(0.0f, life[i] / fade))));
+
+		//split rectangle into two CCW-oriented triangles:
+		vertices->emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), c, glm::vec2(0.5f, 0.5f));
+		vertices->emplace_back(glm::vec3(center.x+radius.x, center.y-radius.y, 0.0f), c, glm::vec2(0.5f, 0.5f));
+		vertices->emplace_back(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), c, glm::vec2(0.5f, 0.5f));
+
+		vertices->emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), c, glm::vec2(0.5f, 0.5f));
+		vertices->emplace_back(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), c, glm::vec2(0.5f, 0.5f));
+		vertices->emplace_back(glm::vec3(center.x-radius.x, center.y+radius.y, 0.0f), c, glm::vec2(0.5f, 0.5f));
+	}
+}
+
+void Particles::build_rectangles(std::vector< SoftRaster::Rectangle > *rectangles) const {
+	rectangles->reserve(rectangles->size() + count);
+	for (uint32_t i = 0; i < count; ++i) {
+		glm::vec2 center = glm::vec2(x[i], y[i]);
+		SoftRaster::Rectangle rect;
+		rect.min = center - radius;
+		rect.max = center + radius;
+		rect.color = color[i];
+		//(same fade as ParticleProgram's vertex shader)
+		rect.color.a = uint8_t(std::round(rect.color.a * std::min(1.0f, std::max(0.0f, life[i] / fade))));
+		rectangles->emplace_back(rect);
+	}
+}
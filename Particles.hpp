@@ -0,0 +1,59 @@
+#pragma once
+
+#include "GLResources.hpp"
+#include "SoftRaster.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <random>
+#include <cstdint>
+
+/*
+ * Particles is a fixed-size pool of short-lived debris (e.g., the bits of a broken brick), with no OpenGL.
+ *
+ * Storage is structure-of-arrays -- one array per field, all allocated up front with room for 'capacity'
+ * (rounded up to a multiple of four) -- so update() integrates four particles per instruction
+ * (with SSE2, where available) and ParticleProgram can upload each array as-is as an instanced attribute.
+ * Live particles are always [0, count): a particle that dies is replaced by the last live one (swap-remove),
+ * and bursts that don't fit are cut short, so nothing allocates after construction.
+ */
+
+struct Particles {
+	Particles(uint32_t capacity = 8192);
+
+	//add up to 'count' particles spread over the rectangle at 'center' with 'radius', flying outward:
+	void burst(glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color, uint32_t count);
+
+	//move, fall, and age every particle by 'elapsed' seconds; remove those that have died:
+	void update(float elapsed);
+
+	//append two triangles per particle (as the instanced draw does, including fading) to 'vertices':
+	// (for renderers without instancing, e.g., SoftRaster)
+	void build_vertices(std::vector< PosColTexVertex > *vertices) const;
+
+	//append one rectangle per particle (the same squares and fading) to 'rectangles':
+	// (for SoftRaster::draw_rectangles -- a sixth of the data of build_vertices)
+	void build_rectangles(std::vector< SoftRaster::Rectangle > *rectangles) const;
+
+	void clear() { count = 0; }
+
+	//----- parameters -----
+	float gravity = -9.8f; //court units / s^2 (along y)
+	float speed = 3.0f; //initial speed of burst particles (court units / s), give or take half
+	float lifetime = 0.9f; //seconds, give or take a third
+	float fade = 0.3f; //particles fade out over their last 'fade' seconds
+	glm::vec2 radius = glm::vec2(0.04f); //(half-size of the square drawn for each particle)
+
+	//----- state -----
+	uint32_t capacity = 0;
+	uint32_t count = 0; //live particles are [0, count)
+
+	//(each has capacity rounded up to a multiple of four, so update() can always work four at a time)
+	std::vector< float > x, y; //position
+	std::vector< float > vx, vy; //velocity
+	std::vector< float > life; //seconds until the particle dies
+	std::vector< glm::u8vec4 > color;
+
+	std::mt19937 mt; //(for burst directions; particles are decoration, not game state)
+};
@@ -0,0 +1,88 @@
+#include "PauseMode.hpp"
+
+//for the GL_ERRORS() macro:
+#include "gl_errors.hpp"
+
+//for glm::value_ptr() :
+#include <glm/gtc/type_ptr.hpp>
+
+PauseMode::PauseMode() {
+}
+
+PauseMode::~PauseMode() {
+}
+
+bool PauseMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
+	if (evt.type == SDL_KEYDOWN && (evt.key.keysym.sym == SDLK_p || evt.key.keysym.sym == SDLK_ESCAPE)) {
+		//un-pause: the layer below becomes current (and live) again
+		// (hold a reference, since the stack's was the last one)
+		std::shared_ptr< Mode > keep = shared_from_this();
+		Mode::pop();
+		return true;
+	}
+	//(the paused game isn't Mode::current, so it doesn't see any other input;
+	// leave quitting, screenshots, and the like to the main loop)
+	return false;
+}
+
+void PauseMode::draw(glm::uvec2 const &drawable_size) {
+	//inline helper function for (pixel-space) rectangle drawing:
+	auto draw_rectangle = [this](glm::vec2 const &min, glm::vec2 const &max, glm::u8vec4 const &color) {
+		vertices.emplace_back(glm::vec3(min.x, min.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(max.x, min.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(max.x, max.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+
+		vertices.emplace_back(glm::vec3(min.x, min.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(max.x, max.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(min.x, max.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+	};
+
+	//---- compute vertices to draw ----
+	vertices.clear();
+
+	//dim everything below:
+	glm::vec2 size = glm::vec2(drawable_size);
+	draw_rectangle(glm::vec2(0.0f), size, dim_color);
+
+	//pause symbol (two bars) in the middle of the window:
+	glm::vec2 center = 0.5f * size;
+	float height = symbol_height * size.y;
+	float bar = 0.3f * height; //(bar width; the gap between the bars is the same)
+	draw_rectangle(center + glm::vec2(-1.5f * bar,-0.5f * height), center + glm::vec2(-0.5f * bar, 0.5f * height), symbol_color);
+	draw_rectangle(center + glm::vec2( 0.5f * bar,-0.5f * height), center + glm::vec2( 1.5f * bar, 0.5f * height), symbol_color);
+
+	//---- actual drawing ----
+
+	//pixels to clip space:
+	glm::mat4 pixel_to_clip = glm::mat4(
+		glm::vec4(2.0f / drawable_size.x, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 2.0f / drawable_size.y, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f)
+	);
+
+	//use alpha blending:
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	//don't use the depth test:
+	glDisable(GL_DEPTH_TEST);
+
+	//upload vertices to vertex_buffer:
+	glBindBuffer(GL_ARRAY_BUFFER, buffers->vertex_buffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(color_texture_program->program);
+	glUniformMatrix4fv(color_texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(pixel_to_clip));
+	glBindVertexArray(buffers->get_vertex_array());
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, white_tex->tex);
+
+	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
+}
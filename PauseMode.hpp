@@ -0,0 +1,36 @@
+#pragma once
+
+#include "GLResources.hpp"
+
+#include "Mode.hpp"
+#include "GL.hpp"
+
+#include <vector>
+#include <memory>
+
+/*
+ * PauseMode is a layer pushed over a game (BreakoutMode pushes one when 'P' is pressed):
+ * the game below is paused (Mode::push) and drawn dimmed, under a pause symbol.
+ * While it is on top, the game gets no input; 'P' (or Escape) pops it and the game carries on.
+ */
+
+struct PauseMode : Mode {
+	PauseMode();
+	virtual ~PauseMode();
+
+	//functions called by main loop:
+	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
+	virtual void draw(glm::uvec2 const &drawable_size) override;
+
+	//----- drawing -----
+	glm::u8vec4 dim_color = glm::u8vec4(0x00, 0x00, 0x00, 0x80); //(over the whole window)
+	glm::u8vec4 symbol_color = glm::u8vec4(0xff, 0xff, 0xff, 0xe0);
+	float symbol_height = 0.2f; //(fraction of the window's height)
+
+	typedef PosColTexVertex Vertex;
+	std::vector< Vertex > vertices; //(reused each frame)
+
+	std::shared_ptr< ColorTextureProgram > color_texture_program = get_shared< ColorTextureProgram >();
+	std::shared_ptr< ColorTextureBuffers > buffers = get_shared< ColorTextureBuffers >();
+	std::shared_ptr< WhiteTexture > white_tex = get_shared< WhiteTexture >();
+};
@@ -0,0 +1,229 @@
+#include "PerfCounters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#include <iomanip>
+
+std::atomic< bool > PerfCounters::is_enabled(false);
+
+//only the thread that called enable() reads the counters (and so only it touches the totals):
+static thread_local bool counting_thread = false;
+
+//the counters (as one group, led by the first one opened, so they are scheduled and read together):
+static int fds[PerfCounters::CounterCount] = {-1, -1, -1, -1, -1};
+static int leader = -1;
+static uint32_t slots[PerfCounters::CounterCount] = {0, 0, 0, 0, 0}; //position of each counter in a group read
+static uint32_t opened = 0;
+static bool counted[PerfCounters::CounterCount] = {false, false, false, false, false}; //(stays set after disable(), for reports)
+
+//fraction of the time the group was actually counting (below 1 when the kernel multiplexes counters):
+static double running_fraction = 1.0;
+
+static std::vector< char const * > scope_names; //(looked up by pointer; scope names are usually literals)
+static std::vector< PerfCounters::Totals > scope_totals;
+
+char const *PerfCounters::counter_name(uint32_t counter) {
+	switch (counter) {
+		case Cycles: return "cycles";
+		case Instructions: return "instructions";
+		case L1DMisses: return "l1d_misses";
+		case LLCMisses: return "llc_misses";
+		case BranchMisses: return "branch_misses";
+		default: return "unknown";
+	}
+}
+
+#ifdef __linux__
+static int open_counter(uint32_t type, uint64_t config, int group_fd) {
+	struct perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = (group_fd == -1 ? 1 : 0); //(the group starts when its leader is enabled)
+	attr.exclude_kernel = 1; //(allowed at perf_event_paranoid 2, and the game's time is in user space anyway)
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	//this thread, any cpu:
+	return int(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+#endif
+
+bool PerfCounters::enable() {
+	if (enabled()) return true;
+#ifdef __linux__
+	struct Event {
+		uint32_t type;
+		uint64_t config;
+	};
+	Event const events[CounterCount] = {
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	};
+	opened = 0;
+	for (uint32_t c = 0; c < CounterCount; ++c) {
+		fds[c] = open_counter(events[c].type, events[c].config, leader);
+		if (fds[c] == -1) {
+			std::cerr << "WARNING: can't count " << counter_name(c) << " (" << std::strerror(errno) << ")." << std::endl;
+			continue;
+		}
+		if (leader == -1) leader = fds[c];
+		counted[c] = true;
+		slots[c] = opened;
+		opened += 1;
+	}
+	if (leader == -1) {
+		std::cerr << "WARNING: no performance counters available (check /proc/sys/kernel/perf_event_paranoid); not counting." << std::endl;
+		return false;
+	}
+	ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	counting_thread = true;
+	is_enabled.store(true, std::memory_order_relaxed);
+	return true;
+#else
+	std::cerr << "WARNING: performance counters are only supported on Linux; not counting." << std::endl;
+	return false;
+#endif
+}
+
+void PerfCounters::disable() {
+	if (!enabled()) return;
+	is_enabled.store(false, std::memory_order_relaxed);
+	counting_thread = false;
+#ifdef __linux__
+	ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	for (uint32_t c = 0; c < CounterCount; ++c) {
+		if (fds[c] != -1) close(fds[c]);
+		fds[c] = -1;
+	}
+	leader = -1;
+#endif
+}
+
+bool PerfCounters::available(uint32_t counter) {
+	return counter < CounterCount && counted[counter];
+}
+
+bool PerfCounters::begin_scope(Reading *reading) {
+	if (!counting_thread) return false;
+#ifdef __linux__
+	//group read layout: nr, time_enabled, time_running, then one value per counter:
+	uint64_t data[3 + CounterCount];
+	ssize_t got = read(leader, data, sizeof(data));
+	if (got < ssize_t(3 * sizeof(uint64_t)) || data[0] != opened) return false;
+	reading->time_enabled = data[1];
+	reading->time_running = data[2];
+	running_fraction = (data[1] == 0 ? 1.0 : double(data[2]) / double(data[1]));
+	for (uint32_t c = 0; c < CounterCount; ++c) {
+		reading->counts[c] = (fds[c] == -1 ? 0 : data[3 + slots[c]]);
+	}
+	return true;
+#else
+	(void)reading;
+	return false;
+#endif
+}
+
+void PerfCounters::end_scope(char const *name, Reading const &begin) {
+	Reading end;
+	if (!begin_scope(&end)) return;
+
+	size_t index = 0;
+	while (index < scope_names.size() && scope_names[index] != name) ++index;
+	if (index == scope_names.size()) {
+		scope_names.emplace_back(name);
+		scope_totals.emplace_back();
+		scope_totals.back().name = name;
+	}
+	Totals &totals = scope_totals[index];
+	totals.calls += 1;
+
+	//scale up for the part of the scope the group wasn't scheduled:
+	// (if it never ran during the scope, there's nothing to scale -- count nothing)
+	uint64_t enabled = end.time_enabled - begin.time_enabled;
+	uint64_t running = end.time_running - begin.time_running;
+	if (running == 0 || end.time_running < begin.time_running) return;
+	double scale = double(enabled) / double(running);
+	for (uint32_t c = 0; c < CounterCount; ++c) {
+		if (end.counts[c] <= begin.counts[c]) continue; //(clamp at zero)
+		totals.counts[c] += uint64_t(double(end.counts[c] - begin.counts[c]) * scale + 0.5);
+	}
+}
+
+std::vector< PerfCounters::Totals > PerfCounters::totals() {
+	//merge scopes that share a name but not a pointer:
+	std::vector< Totals > merged;
+	for (auto const &t : scope_totals) {
+		size_t index = 0;
+		while (index < merged.size() && merged[index].name != t.name) ++index;
+		if (index == merged.size()) {
+			merged.emplace_back(t);
+		} else {
+			merged[index].calls += t.calls;
+			for (uint32_t c = 0; c < CounterCount; ++c) {
+				merged[index].counts[c] += t.counts[c];
+			}
+		}
+	}
+	return merged;
+}
+
+//a / b (0 if b is missing):
+static double ratio(uint64_t a, uint64_t b) {
+	return (b == 0 ? 0.0 : double(a) / double(b));
+}
+
+void PerfCounters::print_summary(std::ostream &out) {
+	out << "  performance counters per scope (inclusive of nested scopes; per call, and per thousand instructions):\n";
+	if (running_fraction < 0.99) {
+		out << "  (counters were multiplexed: counting " << int(running_fraction * 100.0) << "% of the time; values are scaled)\n";
+	}
+	std::ios::fmtflags flags = out.flags();
+	std::streamsize precision = out.precision();
+	out << std::fixed << std::setprecision(2);
+	for (auto const &t : totals()) {
+		out << "    " << t.name << ": " << t.calls << " calls";
+		if (available(Cycles)) out << ", " << ratio(t.counts[Cycles], t.calls) / 1000.0 << "k cycles";
+		if (available(Instructions)) out << ", " << ratio(t.counts[Instructions], t.calls) / 1000.0 << "k instructions";
+		if (available(Cycles) && available(Instructions)) out << ", IPC " << ratio(t.counts[Instructions], t.counts[Cycles]);
+		if (available(Instructions)) {
+			if (available(L1DMisses)) out << ", L1D MPKI " << 1000.0 * ratio(t.counts[L1DMisses], t.counts[Instructions]);
+			if (available(LLCMisses)) out << ", LLC MPKI " << 1000.0 * ratio(t.counts[LLCMisses], t.counts[Instructions]);
+			if (available(BranchMisses)) out << ", branch MPKI " << 1000.0 * ratio(t.counts[BranchMisses], t.counts[Instructions]);
+		}
+		out << "\n";
+	}
+	out.flags(flags);
+	out.precision(precision);
+}
+
+void PerfCounters::write_json(std::ostream &out) {
+	out << "[";
+	bool first = true;
+	for (auto const &t : totals()) {
+		out << (first ? "\n" : ",\n") << "\t\t{\"scope\": \"" << t.name << "\", \"calls\": " << t.calls;
+		first = false;
+		for (uint32_t c = 0; c < CounterCount; ++c) {
+			if (available(c)) out << ", \"" << counter_name(c) << "\": " << t.counts[c];
+		}
+		if (available(Cycles) && available(Instructions)) out << ", \"ipc\": " << ratio(t.counts[Instructions], t.counts[Cycles]);
+		if (available(Instructions)) {
+			if (available(L1DMisses)) out << ", \"l1d_mpki\": " << 1000.0 * ratio(t.counts[L1DMisses], t.counts[Instructions]);
+			if (available(LLCMisses)) out << ", \"llc_mpki\": " << 1000.0 * ratio(t.counts[LLCMisses], t.counts[Instructions]);
+			if (available(BranchMisses)) out << ", \"branch_mpki\": " << 1000.0 * ratio(t.counts[BranchMisses], t.counts[Instructions]);
+		}
+		out << "}";
+	}
+	out << (first ? "]" : "\n\t]");
+}
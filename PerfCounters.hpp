@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+/*
+ * PerfCounters reads hardware performance counters (Linux perf_event_open: cycles, instructions,
+ * L1 data cache read misses, last-level cache misses, branch misses) at the start and end of
+ * named scopes and totals the differences per scope name:
+ *
+ *   void Thing::update() {
+ *       PERF_SCOPE("Thing::update"); //counts until the end of the enclosing block
+ *       ...
+ *   }
+ *
+ * The counters are opt-in (main.cpp's --perf-counters, with --bench; Benchmark reports IPC and miss rates
+ * per scope) and only count the thread that called enable() -- scopes on other threads are ignored.
+ * A disabled scope costs one relaxed atomic load; an enabled one costs two read() system calls.
+ * Counts are inclusive: a scope's counts include those of scopes nested inside it.
+ *
+ * On other platforms (or if the kernel refuses -- see /proc/sys/kernel/perf_event_paranoid)
+ * enable() warns and returns false, and scopes do nothing.
+ */
+
+struct PerfCounters {
+	enum Counter : uint32_t {
+		Cycles,
+		Instructions,
+		L1DMisses,
+		LLCMisses,
+		BranchMisses,
+		CounterCount
+	};
+	static char const *counter_name(uint32_t counter);
+
+	//open counters for the calling thread; returns false (after printing a warning) if none could be opened:
+	static bool enable();
+	static void disable();
+	static bool enabled() { return is_enabled.load(std::memory_order_relaxed); }
+
+	//was 'counter' opened? (some CPUs and virtual machines lack some events):
+	static bool available(uint32_t counter);
+
+	//totals for one scope name:
+	struct Totals {
+		std::string name;
+		uint64_t calls = 0;
+		uint64_t counts[CounterCount] = {0, 0, 0, 0, 0};
+	};
+	//every scope seen so far, in order of first use:
+	static std::vector< Totals > totals();
+
+	//per-scope calls, cycles and instructions per call, IPC, and misses per thousand instructions:
+	static void print_summary(std::ostream &out);
+	//the same as a JSON array of objects:
+	static void write_json(std::ostream &out);
+
+	//----- recording -----
+	//raw counter values, along with how long the group had been enabled and actually counting (ns):
+	// (when the kernel multiplexes counters, a scope's count is scaled by the enabled/running ratio *over the scope*)
+	struct Reading {
+		uint64_t time_enabled;
+		uint64_t time_running;
+		uint64_t counts[CounterCount];
+	};
+
+	struct Scope {
+		Scope(char const *name_) {
+			name = (enabled() && begin_scope(&begin) ? name_ : nullptr);
+		}
+		~Scope() {
+			if (name) end_scope(name, begin);
+		}
+		Scope(Scope const &) = delete;
+		Scope &operator=(Scope const &) = delete;
+
+		char const *name;
+		Reading begin;
+	};
+
+	//read the counters (returns false if not on the counting thread):
+	static bool begin_scope(Reading *reading);
+	static void end_scope(char const *name, Reading const &begin);
+
+	static std::atomic< bool > is_enabled;
+};
+
+#define PERF_CONCAT2(A, B) A ## B
+#define PERF_CONCAT(A, B) PERF_CONCAT2(A, B)
+
+#define PERF_SCOPE(NAME) PerfCounters::Scope PERF_CONCAT(perf_scope_, __LINE__)(NAME)
@@ -0,0 +1,142 @@
+#include "PongFuzz.hpp"
+
+#include "PongGame.hpp"
+
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+bool run_pong_fuzz(PongFuzzOptions const &options, std::ostream &out) {
+	std::mt19937 mt(options.seed);
+	std::uniform_real_distribution< float > unit(0.0f, 1.0f);
+	bool passed = true;
+
+	//----- shots at the left paddle -----
+	uint32_t hits = 0, misses = 0, skipped = 0, failed = 0;
+	for (uint32_t shot = 0; shot < options.shots; ++shot) {
+		PongGame game;
+		game.seed(mt());
+		glm::vec2 reach = game.paddle_radius + game.ball_radius;
+		glm::vec2 court = game.court_radius - game.ball_radius;
+
+		//how fast (set with the score, as in play) and how far the ball goes this step:
+		game.left_score = mt() % (options.max_score + 1);
+		game.right_score = mt() % (options.max_score + 1);
+		float speed_multiplier = 4.0f * std::pow(2.0f, (game.left_score + game.right_score) / 4.0f);
+		float distance = 0.5f + 5.5f * unit(mt); //(short enough that a bounce off the paddle can't reach the far wall)
+		float angle = 3.14159265f * (0.75f + 0.5f * unit(mt)); //(heading left, +/- 45 degrees)
+		glm::vec2 direction = glm::vec2(std::cos(angle), std::sin(angle));
+		float elapsed = distance / speed_multiplier;
+
+		//start somewhere the ball reaches the left wall from, in front of the paddle and never touching the top or bottom:
+		glm::vec2 delta = distance * direction;
+		glm::vec2 start = glm::vec2(
+			-court.x - delta.x * (0.3f + 0.6f * unit(mt)),
+			(unit(mt) * 2.0f - 1.0f) * court.y
+		);
+		if (start.x < game.left_paddle.x + reach.x + 0.01f) { ++skipped; continue; }
+		if (std::abs(start.y + delta.y) > court.y) { ++skipped; continue; }
+		game.ball = start;
+		game.ball_velocity = direction;
+
+		//the paddle jumps anywhere (within the court) during the step:
+		float limit = game.court_radius.y - game.paddle_radius.y;
+		glm::vec2 paddle_from = glm::vec2(game.left_paddle.x, (unit(mt) * 2.0f - 1.0f) * limit);
+		glm::vec2 paddle_to = glm::vec2(game.left_paddle.x, (unit(mt) * 2.0f - 1.0f) * limit);
+		game.last_left_paddle = paddle_from;
+		game.left_paddle = paddle_to;
+
+		//oracle: sample the paths until the ball reaches the wall
+		// (anything closer than the paths move between samples is too close to call)
+		uint32_t const Samples = 4096;
+		float margin = glm::length(delta - (paddle_to - paddle_from)) / Samples + 1e-4f;
+		enum { Miss, Face, Unsure } expect = Miss;
+		bool was_face = false;
+		for (uint32_t i = 0; i <= Samples; ++i) {
+			float t = i / float(Samples);
+			glm::vec2 ball = start + t * delta;
+			if (ball.x < -court.x) break;
+			glm::vec2 offset = glm::abs(ball - glm::mix(paddle_from, paddle_to, t));
+			float gap = std::max(offset.x - reach.x, offset.y - reach.y);
+			bool face = (offset.y < reach.y - margin);
+			if (gap < 0.0f) {
+				expect = (face && was_face ? Face : Unsure);
+				break;
+			}
+			if (gap < margin) expect = Unsure;
+			was_face = face;
+		}
+		if (expect == Unsure) { ++skipped; continue; }
+
+		uint32_t right_score = game.right_score;
+		uint32_t left_score = game.left_score;
+		game.update(elapsed);
+
+		bool ok;
+		if (expect == Face) {
+			++hits;
+			ok = (game.right_score == right_score && game.left_score == left_score && game.ball_velocity.x > 0.0f
+				&& game.ball.x >= game.left_paddle.x + reach.x - 1e-3f);
+		} else {
+			++misses;
+			ok = (game.right_score == right_score + 1 && game.left_score == left_score);
+		}
+		if (!ok) {
+			if (failed < 10) {
+				out << "  shot " << shot << ": expected a " << (expect == Face ? "bounce off the paddle" : "goal")
+					<< " (ball from (" << start.x << ", " << start.y << ") by (" << delta.x << ", " << delta.y << "), paddle from y = "
+					<< paddle_from.y << " to " << paddle_to.y << ", speed x" << speed_multiplier << "), but the ball ended at ("
+					<< game.ball.x << ", " << game.ball.y << ") and the score went from " << left_score << "-" << right_score
+					<< " to " << game.left_score << "-" << game.right_score << ".\n";
+			}
+			++failed;
+			passed = false;
+		}
+	}
+	out << "Pong fuzz: " << options.shots << " shots -- " << hits << " off the paddle's face, " << misses << " past it, "
+		<< skipped << " too close to call; " << failed << " wrong.\n";
+
+	//----- rallies -----
+	uint32_t broken = 0;
+	{
+		PongGame game;
+		game.seed(options.seed);
+		glm::vec2 reach = game.paddle_radius + game.ball_radius;
+		glm::vec2 court = game.court_radius - game.ball_radius;
+		for (uint32_t frame = 0; frame < options.rally_frames; ++frame) {
+			//a new speed every frame (at these speeds, goals pile up fast enough to overflow it otherwise):
+			game.left_score = mt() % (options.max_score + 1);
+			game.right_score = mt() % (options.max_score + 1);
+			//the player sometimes tracks the ball and sometimes jumps anywhere:
+			if (unit(mt) < 0.5f) game.left_paddle.y = game.ball.y;
+			else game.left_paddle.y = (unit(mt) * 2.0f - 1.0f) * game.court_radius.y;
+
+			float elapsed = (unit(mt) < 0.1f ? 0.25f : 1.0f / 240.0f) * (0.5f + unit(mt));
+			game.update(elapsed);
+
+			//(a ball behind a paddle's center is in the goal, where the paddle can pass over it)
+			auto overlapping = [&](glm::vec2 const &paddle) -> bool {
+				if ((game.ball.x - paddle.x) * paddle.x > 0.0f) return false;
+				glm::vec2 offset = glm::abs(game.ball - paddle);
+				return offset.x < reach.x - 1e-3f && offset.y < reach.y - 1e-3f;
+			};
+			bool ok = !std::isnan(game.ball.x) && !std::isnan(game.ball.y)
+				&& !std::isnan(game.ball_velocity.x) && !std::isnan(game.ball_velocity.y)
+				&& std::abs(game.ball.x) <= court.x && std::abs(game.ball.y) <= court.y
+				&& !overlapping(game.left_paddle) && !overlapping(game.right_paddle);
+			if (!ok) {
+				if (broken < 10) {
+					out << "  rally frame " << frame << ": ball at (" << game.ball.x << ", " << game.ball.y << ") with velocity ("
+						<< game.ball_velocity.x << ", " << game.ball_velocity.y << "), paddles at y = " << game.left_paddle.y
+						<< " and " << game.right_paddle.y << ".\n";
+				}
+				++broken;
+				passed = false;
+			}
+		}
+	}
+	out << "Pong fuzz: " << options.rally_frames << " rally frames; " << broken << " left the ball outside the court, in a paddle, or NaN.\n";
+	out << "  " << (passed ? "PASS" : "FAIL") << "\n";
+	out.flush();
+	return passed;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+
+/*
+ * The Pong fuzz test fires random high-speed shots at the (moving) left paddle and checks each one
+ * against an oracle that samples the ball's and paddle's straight-line paths densely:
+ *  - a shot whose path crosses the paddle's face must bounce back without scoring;
+ *  - a shot whose path clears the paddle must reach the wall and score.
+ * (Shots that only graze the paddle, or catch its end, are too close to call and are skipped.)
+ * It then plays random rallies -- random frame times, score (so speed), and paddle jumps -- checking that
+ * the ball always ends a frame inside the court, not overlapping either paddle, and not NaN.
+ *
+ * Needs no window (main.cpp runs this with --fuzz-pong).
+ */
+
+struct PongFuzzOptions {
+	uint32_t shots = 100000;
+	uint32_t rally_frames = 100000;
+	uint32_t seed = 0;
+	uint32_t max_score = 48; //scores (each side) go up to this, so the ball goes up to 4 * 2^(max_score / 2) times its base speed
+};
+
+//returns false if any shot or rally frame breaks the rules above:
+bool run_pong_fuzz(PongFuzzOptions const &options, std::ostream &out);
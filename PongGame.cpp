@@ -0,0 +1,236 @@
+#include "PongGame.hpp"
+
+//for state_hash():
+#include "StateHash.hpp"
+
+//for swept collisions:
+#include "sweep_box.hpp"
+
+//for TRACE_SCOPE() and PERF_SCOPE():
+#include "Trace.hpp"
+#include "PerfCounters.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+PongGame::PongGame() {
+}
+
+void PongGame::update(float elapsed) {
+	TRACE_SCOPE("PongGame::update");
+	PERF_SCOPE("PongGame::update");
+
+	//----- paddle update -----
+
+	//(the paddles move from here to their new positions over the step; the left paddle
+	// was steered since the last update, so it is moving from where that update left it)
+	glm::vec2 paddles_from[2] = { last_left_paddle, right_paddle };
+
+	{ //right player ai:
+		ai_offset_update -= elapsed;
+		if (ai_offset_update < elapsed) {
+			//update again in [0.5,1.0) seconds:
+			ai_offset_update = (mt() / float(mt.max())) * 0.5f + 0.5f;
+			ai_offset = (mt() / float(mt.max())) * 2.5f - 1.25f;
+		}
+		if (right_paddle.y < ball.y + ai_offset) {
+			right_paddle.y = std::min(ball.y + ai_offset, right_paddle.y + 2.0f * elapsed);
+		} else {
+			right_paddle.y = std::max(ball.y + ai_offset, right_paddle.y - 2.0f * elapsed);
+		}
+	}
+
+	//clamp paddles to court:
+	right_paddle.y = std::max(right_paddle.y, -court_radius.y + paddle_radius.y);
+	right_paddle.y = std::min(right_paddle.y,  court_radius.y - paddle_radius.y);
+
+	left_paddle.y = std::max(left_paddle.y, -court_radius.y + paddle_radius.y);
+	left_paddle.y = std::min(left_paddle.y,  court_radius.y - paddle_radius.y);
+
+	last_left_paddle = left_paddle;
+
+	//----- ball update -----
+
+	//speed of ball doubles every four points:
+	float speed_multiplier = 4.0f * std::pow(2.0f, (left_score + right_score) / 4.0f);
+
+	//(no cap on speed: the ball's path is swept against the paddles' paths, so it can't pass through them)
+	sweep_ball(elapsed * speed_multiplier, paddles_from);
+
+	//---- collision handling ----
+	//(the sweep leaves the ball touching, not overlapping; these catch anything it couldn't resolve)
+
+	//paddles:
+	auto paddle_vs_ball = [this](glm::vec2 const &paddle) {
+		//compute area of overlap:
+		glm::vec2 min = glm::max(paddle - paddle_radius, ball - ball_radius);
+		glm::vec2 max = glm::min(paddle + paddle_radius, ball + ball_radius);
+
+		//if no overlap, no collision:
+		if (min.x > max.x || min.y > max.y) return;
+
+		//a ball behind the paddle's center is in the goal, so the paddle doesn't knock it back out:
+		if ((ball.x - paddle.x) * paddle.x > 0.0f) return;
+
+		//(no room between the paddle's end and the wall => the ball can only go out the front)
+		float room = court_radius.y - ball_radius.y - (std::abs(paddle.y) + paddle_radius.y + ball_radius.y);
+		bool pinned = (room < 0.0f && (ball.y > paddle.y) == (paddle.y > 0.0f));
+
+		if (max.x - min.x > max.y - min.y && !pinned) {
+			//wider overlap in x => bounce in y direction:
+			if (ball.y > paddle.y) {
+				ball.y = paddle.y + paddle_radius.y + ball_radius.y;
+				ball_velocity.y = std::abs(ball_velocity.y);
+			} else {
+				ball.y = paddle.y - paddle_radius.y - ball_radius.y;
+				ball_velocity.y = -std::abs(ball_velocity.y);
+			}
+		} else {
+			//wider overlap in y => bounce in x direction:
+			if (ball.x > paddle.x) {
+				ball.x = paddle.x + paddle_radius.x + ball_radius.x;
+				ball_velocity.x = std::abs(ball_velocity.x);
+			} else {
+				ball.x = paddle.x - paddle_radius.x - ball_radius.x;
+				ball_velocity.x = -std::abs(ball_velocity.x);
+			}
+			//warp y velocity based on offset from paddle center:
+			float vel = (ball.y - paddle.y) / (paddle_radius.y + ball_radius.y);
+			ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);
+		}
+	};
+	paddle_vs_ball(left_paddle);
+	paddle_vs_ball(right_paddle);
+
+	//court walls:
+	if (ball.y > court_radius.y - ball_radius.y) {
+		ball.y = court_radius.y - ball_radius.y;
+		if (ball_velocity.y > 0.0f) {
+			ball_velocity.y = -ball_velocity.y;
+		}
+	}
+	if (ball.y < -court_radius.y + ball_radius.y) {
+		ball.y = -court_radius.y + ball_radius.y;
+		if (ball_velocity.y < 0.0f) {
+			ball_velocity.y = -ball_velocity.y;
+		}
+	}
+
+	if (ball.x > court_radius.x - ball_radius.x) {
+		ball.x = court_radius.x - ball_radius.x;
+		if (ball_velocity.x > 0.0f) {
+			ball_velocity.x = -ball_velocity.x;
+			left_score += 1;
+		}
+	}
+	if (ball.x < -court_radius.x + ball_radius.x) {
+		ball.x = -court_radius.x + ball_radius.x;
+		if (ball_velocity.x < 0.0f) {
+			ball_velocity.x = -ball_velocity.x;
+			right_score += 1;
+		}
+	}
+}
+
+void PongGame::sweep_ball(float distance, glm::vec2 const paddles_from[2]) {
+	TRACE_SCOPE("PongGame::sweep_ball");
+
+	glm::vec2 paddles_to[2] = { left_paddle, right_paddle };
+	glm::vec2 reach = paddle_radius + ball_radius;
+	glm::vec2 court = court_radius - ball_radius; //(where the ball's center can go)
+
+	//move the ball along its path, stopping at whatever it reaches first, bouncing, and carrying on with the rest of the step:
+	float now = 0.0f; //how far through the step (paddles are at mix(from, to, now))
+	for (uint32_t contact = 0; contact < max_contacts && now < 1.0f; ++contact) {
+		float rest = 1.0f - now;
+		glm::vec2 delta = (rest * distance) * ball_velocity;
+
+		enum { Nothing, PaddleHit, WallHit } what = Nothing;
+		float time = 2.0f; //(as a fraction of the rest of the step)
+		uint32_t axis = 0;
+		uint32_t paddle = 0;
+
+		//paddles (in each paddle's frame of reference, the ball moves by delta minus the paddle's motion):
+		for (uint32_t p = 0; p < 2; ++p) {
+			glm::vec2 at = glm::mix(paddles_from[p], paddles_to[p], now);
+			if ((ball.x - at.x) * at.x > 0.0f) continue; //(behind the paddle, in the goal -- see update())
+			glm::vec2 moved = rest * (paddles_to[p] - paddles_from[p]);
+			float t;
+			uint32_t k;
+			if (sweep_box(ball, delta - moved, at, reach, &t, &k) && t < time) {
+				what = PaddleHit;
+				time = t;
+				axis = k;
+				paddle = p;
+			}
+		}
+
+		//court walls:
+		for (uint32_t k = 0; k < 2; ++k) {
+			if (delta[k] == 0.0f) continue;
+			float limit = (delta[k] > 0.0f ? court[k] : -court[k]);
+			if ((delta[k] > 0.0f ? ball[k] + delta[k] <= limit : ball[k] + delta[k] >= limit)) continue;
+			float t = std::max(0.0f, (limit - ball[k]) / delta[k]);
+			if (t < time) {
+				what = WallHit;
+				time = t;
+				axis = k;
+			}
+		}
+
+		if (what == Nothing) {
+			ball += delta;
+			break;
+		}
+
+		//move to the contact (exactly touching, along the axis of contact) and bounce:
+		ball += time * delta;
+		now += time * rest;
+
+		if (what == PaddleHit) {
+			glm::vec2 at = glm::mix(paddles_from[paddle], paddles_to[paddle], now);
+			float side = (ball[axis] > at[axis] ? 1.0f : -1.0f);
+			ball[axis] = at[axis] + side * reach[axis];
+			if (axis == 0) {
+				ball_velocity.x = side * std::abs(ball_velocity.x);
+				//warp y velocity based on offset from paddle center:
+				float vel = (ball.y - at.y) / (paddle_radius.y + ball_radius.y);
+				ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);
+			} else {
+				float paddle_velocity = (distance > 0.0f ? (paddles_to[paddle].y - paddles_from[paddle].y) / distance : 0.0f);
+				if (side * paddle_velocity > 0.0f && std::abs(paddles_to[paddle].y + side * reach.y) > court.y) {
+					//hit by the end of a paddle that will pin it against the wall: squirt out in front of the paddle instead:
+					float front = (ball.x > at.x ? 1.0f : -1.0f);
+					ball.x = at.x + front * reach.x;
+					ball_velocity.x = front * std::abs(ball_velocity.x);
+				} else {
+					//hit by the end of the paddle: leave at least as fast as the paddle is moving (so it doesn't catch up again):
+					ball_velocity.y = side * std::max(std::abs(ball_velocity.y), side * paddle_velocity);
+				}
+			}
+		} else { //WallHit
+			float side = (delta[axis] > 0.0f ? 1.0f : -1.0f);
+			ball[axis] = side * court[axis];
+			ball_velocity[axis] = -side * std::abs(ball_velocity[axis]);
+			if (axis == 0) {
+				//goal:
+				if (side > 0.0f) left_score += 1;
+				else right_score += 1;
+			}
+		}
+	}
+}
+
+uint64_t PongGame::state_hash() const {
+	StateHash hash;
+	hash.add(left_paddle);
+	hash.add(right_paddle);
+	hash.add(last_left_paddle);
+	hash.add(ball);
+	hash.add(ball_velocity);
+	hash.add(left_score);
+	hash.add(right_score);
+	hash.add(ai_offset);
+	hash.add(ai_offset_update);
+	return hash.value;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <random>
+#include <cstdint>
+
+/*
+ * PongGame holds the state and rules of single-player Pong (the left paddle is the player's; the right
+ * paddle is played by a simple AI), with no window or OpenGL dependencies.
+ * PongMode feeds it input and draws it.
+ */
+
+struct PongGame {
+	PongGame();
+
+	//----- input -----
+	//(the left paddle is steered by writing 'left_paddle.y' directly; update() keeps it in the court)
+
+	//----- simulation -----
+
+	void update(float elapsed);
+
+	//the ball's path through a step is swept against the paddles' paths (each paddle moves in a straight line
+	// over the step) and the walls, bouncing off whatever it reaches first -- up to max_contacts times per step --
+	// so it can't pass through a paddle however fast either is going:
+	uint32_t max_contacts = 32;
+	void sweep_ball(float distance, glm::vec2 const paddles_from[2]); //(moves the ball by distance * ball_velocity)
+
+	//bit-exact summary of the state (see StateHash.hpp):
+	uint64_t state_hash() const;
+
+	//----- game state -----
+
+	//each game has its own pseudo-random number generator (used by the AI):
+	std::mt19937 mt;
+	void seed(uint32_t seed_) { mt.seed(seed_); }
+
+	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
+	glm::vec2 paddle_radius = glm::vec2(0.2f, 1.0f);
+	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
+
+	glm::vec2 left_paddle = glm::vec2(-court_radius.x + 0.5f, 0.0f);
+	glm::vec2 right_paddle = glm::vec2( court_radius.x - 0.5f, 0.0f);
+	glm::vec2 last_left_paddle = left_paddle; //left paddle at the end of the last update
+
+	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
+	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
+
+	uint32_t left_score = 0;
+	uint32_t right_score = 0;
+
+	float ai_offset = 0.0f;
+	float ai_offset_update = 0.0f;
+};
@@ -1,13 +1,16 @@
-#include "ColorTextureProgram.hpp"
+#include "GLResources.hpp"
+#include "TrailProgram.hpp"
+#include "PongGame.hpp"
+#include "BallTrail.hpp"
 
 #include "Mode.hpp"
 #include "GL.hpp"
 
 #include <vector>
-#include <deque>
 
 /*
  * PongMode is a game mode that implements a single-player game of Pong.
+ * (the game itself lives in PongGame; this mode handles input and drawing)
  */
 
 struct PongMode : Mode {
@@ -18,57 +21,57 @@ struct PongMode : Mode {
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
 	virtual void draw(glm::uvec2 const &drawable_size) override;
+	virtual void resize(glm::uvec2 const &window_size, glm::uvec2 const &drawable_size) override;
+	virtual uint64_t state_hash() const override;
 
 	//----- game state -----
 
-	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
-	glm::vec2 paddle_radius = glm::vec2(0.2f, 1.0f);
-	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
-
-	glm::vec2 left_paddle = glm::vec2(-court_radius.x + 0.5f, 0.0f);
-	glm::vec2 right_paddle = glm::vec2( court_radius.x - 0.5f, 0.0f);
-
-	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
-	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
-
-	uint32_t left_score = 0;
-	uint32_t right_score = 0;
-
-	float ai_offset = 0.0f;
-	float ai_offset_update = 0.0f;
+	PongGame game;
 
 	//----- pretty rainbow trails -----
 
-	float trail_length = 1.3f;
-	std::deque< glm::vec3 > ball_trail; //stores (x,y,age), oldest elements first
+	BallTrail ball_trail; //(ball_trail.length is the trail length, in seconds)
 
 	//----- opengl assets / helpers ------
 
 	//draw functions will work on vectors of vertices, defined as follows:
-	struct Vertex {
-		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
-			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
-		glm::vec3 Position;
-		glm::u8vec4 Color;
-		glm::vec2 TexCoord;
-	};
-	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "PongMode::Vertex should be packed");
+	typedef PosColTexVertex Vertex;
 
 	//Shader program that draws transformed, vertices tinted with vertex colors:
-	ColorTextureProgram color_texture_program;
-
-	//Buffer used to hold vertex data during drawing:
-	GLuint vertex_buffer = 0;
+	std::shared_ptr< ColorTextureProgram > color_texture_program = get_shared< ColorTextureProgram >();
 
-	//Vertex Array Object that maps buffer locations to color_texture_program attribute locations:
-	GLuint vertex_buffer_for_color_texture_program = 0;
+	//Vertex buffer + vertex array object that maps it to color_texture_program attribute locations:
+	std::shared_ptr< ColorTextureBuffers > buffers = get_shared< ColorTextureBuffers >();
 
 	//Solid white texture:
-	GLuint white_tex = 0;
+	std::shared_ptr< WhiteTexture > white_tex = get_shared< WhiteTexture >();
+
+	//Program that draws the ball trail from its samples, and the trail's colors:
+	std::shared_ptr< TrailProgram > trail_program = get_shared< TrailProgram >();
+	std::shared_ptr< RainbowPaletteTexture > rainbow_palette = get_shared< RainbowPaletteTexture >();
+
+	//append the triangles that draw the current game state (in court space) to 'vertices':
+	// if 'trail_start' is given, the ball trail is left out (draw() has the GPU draw it) and
+	// *trail_start is where in 'vertices' it belongs; otherwise the trail is built on the CPU
+	// (draw() uploads and draws these; other renderers can use them directly)
+	void build_vertices(std::vector< Vertex > *vertices, size_t *trail_start = nullptr) const;
+
+	//draw()'s vertex list (a member, so drawing doesn't allocate once it has grown):
+	std::vector< Vertex > vertices;
+
+	//other useful drawing constants:
+	float wall_radius = 0.05f;
+	float shadow_offset = 0.07f;
+	float padding = 0.14f; //padding between outside of walls and edge of window
+	glm::vec2 score_radius = glm::vec2(0.1f, 0.1f);
+	glm::u8vec4 bg_color = glm::u8vec4(0xf3, 0xff, 0xc6, 0xff); //(some nice colors from the course web page)
+
+	//matrix that maps from court-space coordinates to clip coordinates (used as OBJECT_TO_CLIP):
+	glm::mat4 court_to_clip = glm::mat4(1.0f);
 
 	//matrix that maps from clip coordinates to court-space coordinates:
 	glm::mat3x2 clip_to_court = glm::mat3x2(1.0f);
-	// computed in draw() as the inverse of OBJECT_TO_CLIP
-	// (stored here so that the mouse handling code can use it to position the paddle)
+	// both computed in resize(), since they only depend on the window's aspect ratio
+	// (stored here so that the mouse handling code can use clip_to_court to position the paddle)
 
 };
@@ -0,0 +1,141 @@
+#include "ProfilerOverlay.hpp"
+
+//for the GL_ERRORS() macro:
+#include "gl_errors.hpp"
+
+//for glm::value_ptr() :
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+
+ProfilerOverlay::ProfilerOverlay() : history(History) {
+}
+
+ProfilerOverlay::~ProfilerOverlay() {
+}
+
+void ProfilerOverlay::frame(float update, float draw, float frame, AllocationTracker::Frame const &allocations) {
+	Sample &sample = history[next];
+	sample.update = update;
+	sample.draw = draw;
+	sample.frame = frame;
+	for (uint32_t i = 0; i < AllocationTracker::MaxScopes; ++i) {
+		sample.allocations[i] = uint32_t(std::min< uint64_t >(allocations.scopes[i].allocations, 0xffffffffu));
+	}
+	next = (next + 1) % History;
+}
+
+void ProfilerOverlay::draw(glm::uvec2 const &drawable_size) {
+	if (!visible) return;
+
+	const glm::u8vec4 panel_color = glm::u8vec4(0x00, 0x00, 0x00, 0xa0);
+	const glm::u8vec4 update_color = glm::u8vec4(0x40, 0x90, 0xff, 0xff);
+	const glm::u8vec4 draw_color = glm::u8vec4(0xff, 0xa0, 0x30, 0xff);
+	const glm::u8vec4 other_color = glm::u8vec4(0x90, 0x90, 0x90, 0xff);
+	const glm::u8vec4 line_color = glm::u8vec4(0xff, 0xff, 0xff, 0xc0);
+	const glm::u8vec4 clipped_color = glm::u8vec4(0xff, 0x30, 0x30, 0xff);
+	//allocation scope colors (scope 0, "(unscoped)", is gray):
+	const glm::u8vec4 scope_colors[] = {
+		glm::u8vec4(0x90, 0x90, 0x90, 0xff), glm::u8vec4(0xff, 0xe0, 0x40, 0xff),
+		glm::u8vec4(0x40, 0x90, 0xff, 0xff), glm::u8vec4(0xff, 0xa0, 0x30, 0xff),
+		glm::u8vec4(0x60, 0xe0, 0x60, 0xff), glm::u8vec4(0xe0, 0x60, 0xe0, 0xff),
+		glm::u8vec4(0x40, 0xe0, 0xe0, 0xff), glm::u8vec4(0xff, 0x80, 0x80, 0xff),
+	};
+	const uint32_t scope_color_count = sizeof(scope_colors) / sizeof(scope_colors[0]);
+
+	//inline helper function for (pixel-space) rectangle drawing:
+	auto draw_rectangle = [this](glm::vec2 const &min, glm::vec2 const &max, glm::u8vec4 const &color) {
+		vertices.emplace_back(glm::vec3(min.x, min.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(max.x, min.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(max.x, max.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+
+		vertices.emplace_back(glm::vec3(min.x, min.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(max.x, max.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		vertices.emplace_back(glm::vec3(min.x, max.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+	};
+
+	//stacked bar: draw [base, base + height) clipped to the graph, returns the new base:
+	auto stack_bar = [&](float x, float graph_bottom, float base, float height, glm::u8vec4 const &color) -> float {
+		float top = std::min(base + height, graph_height);
+		if (top > base) draw_rectangle(glm::vec2(x, graph_bottom + base), glm::vec2(x + bar_width, graph_bottom + top), color);
+		return base + height;
+	};
+
+	//---- compute vertices to draw ----
+	vertices.clear();
+
+	bool show_allocations = AllocationTracker::enabled();
+	float width = History * bar_width;
+	float height = graph_height * (show_allocations ? 2.0f : 1.0f) + margin * (show_allocations ? 3.0f : 2.0f);
+
+	//panel in the upper left corner (pixel coordinates, origin at lower left):
+	glm::vec2 panel_min = glm::vec2(margin, float(drawable_size.y) - margin - height);
+	draw_rectangle(panel_min, glm::vec2(margin + width + 2.0f * margin, float(drawable_size.y) - margin), panel_color);
+
+	float left = panel_min.x + margin;
+	//frame times on top, allocations below:
+	float time_bottom = panel_min.y + height - margin - graph_height;
+	float alloc_bottom = panel_min.y + margin;
+
+	for (uint32_t i = 0; i < History; ++i) {
+		Sample const &sample = history[(next + i) % History];
+		float x = left + i * bar_width;
+
+		float base = 0.0f;
+		float other = std::max(0.0f, sample.frame - sample.update - sample.draw);
+		base = stack_bar(x, time_bottom, base, sample.update * 1000.0f * pixels_per_ms, update_color);
+		base = stack_bar(x, time_bottom, base, sample.draw * 1000.0f * pixels_per_ms, draw_color);
+		base = stack_bar(x, time_bottom, base, other * 1000.0f * pixels_per_ms, other_color);
+		if (base > graph_height) draw_rectangle(glm::vec2(x, time_bottom + graph_height - 2.0f), glm::vec2(x + bar_width, time_bottom + graph_height), clipped_color);
+
+		if (show_allocations) {
+			base = 0.0f;
+			for (uint32_t s = 0; s < AllocationTracker::MaxScopes; ++s) {
+				if (sample.allocations[s] == 0) continue;
+				base = stack_bar(x, alloc_bottom, base, sample.allocations[s] * pixels_per_allocation, scope_colors[s % scope_color_count]);
+			}
+			if (base > graph_height) draw_rectangle(glm::vec2(x, alloc_bottom + graph_height - 2.0f), glm::vec2(x + bar_width, alloc_bottom + graph_height), clipped_color);
+		}
+	}
+
+	//1/60th of a second:
+	float budget = 1000.0f / 60.0f * pixels_per_ms;
+	if (budget < graph_height) {
+		draw_rectangle(glm::vec2(left, time_bottom + budget), glm::vec2(left + width, time_bottom + budget + 1.0f), line_color);
+	}
+
+	//---- actual drawing ----
+
+	//pixels to clip space:
+	glm::mat4 pixel_to_clip = glm::mat4(
+		glm::vec4(2.0f / drawable_size.x, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 2.0f / drawable_size.y, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f)
+	);
+
+	//use alpha blending:
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	//don't use the depth test:
+	glDisable(GL_DEPTH_TEST);
+
+	//upload vertices to vertex_buffer:
+	glBindBuffer(GL_ARRAY_BUFFER, buffers->vertex_buffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(color_texture_program->program);
+	glUniformMatrix4fv(color_texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(pixel_to_clip));
+	glBindVertexArray(buffers->get_vertex_array());
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, white_tex->tex);
+
+	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
+}
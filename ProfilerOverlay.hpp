@@ -0,0 +1,57 @@
+#pragma once
+
+#include "GLResources.hpp"
+#include "AllocationTracker.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+/*
+ * ProfilerOverlay graphs the last few seconds of frames over the top-left corner of the window
+ * (main.cpp draws it after the mode stack; F3 shows/hides it):
+ *  - frame time, as stacked bars of update (blue), draw (orange), and everything else (gray),
+ *    with a line at 1/60th of a second;
+ *  - heap allocations per frame (when AllocationTracker is enabled -- see --allocs),
+ *    as bars stacked by allocation scope (one color per scope; unscoped allocations are gray).
+ *
+ * It isn't a layer on the mode stack, so showing it doesn't change input handling or state hashes.
+ */
+
+struct ProfilerOverlay {
+	ProfilerOverlay();
+	~ProfilerOverlay();
+
+	//record one frame (times in seconds):
+	void frame(float update, float draw, float frame, AllocationTracker::Frame const &allocations);
+
+	//draw over the currently bound framebuffer:
+	void draw(glm::uvec2 const &drawable_size);
+
+	bool visible = false;
+
+	//----- history -----
+	static const uint32_t History = 240; //frames shown
+	struct Sample {
+		float update = 0.0f, draw = 0.0f, frame = 0.0f;
+		uint32_t allocations[AllocationTracker::MaxScopes] = {0};
+	};
+	std::vector< Sample > history; //ring of History samples, oldest at 'next'
+	uint32_t next = 0;
+
+	//----- drawing -----
+	float bar_width = 2.0f; //pixels per frame
+	float pixels_per_ms = 4.0f;
+	float pixels_per_allocation = 2.0f;
+	float graph_height = 100.0f; //(taller bars are clipped, with a red cap)
+	float margin = 8.0f;
+
+	typedef PosColTexVertex Vertex;
+	std::vector< Vertex > vertices; //(reused each frame)
+
+	std::shared_ptr< ColorTextureProgram > color_texture_program = get_shared< ColorTextureProgram >();
+	std::shared_ptr< ColorTextureBuffers > buffers = get_shared< ColorTextureBuffers >();
+	std::shared_ptr< WhiteTexture > white_tex = get_shared< WhiteTexture >();
+};
@@ -0,0 +1,149 @@
+#include "ScalingBench.hpp"
+
+#include "BreakoutMode.hpp"
+#include "Level.hpp"
+#include "percentile.hpp"
+
+#include "GL.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+//resident set size of this process, in bytes (or 0 if unknown):
+static size_t resident_bytes() {
+#ifdef __linux__
+	std::ifstream statm("/proc/self/statm");
+	size_t total = 0, resident = 0;
+	if (statm >> total >> resident) return resident * size_t(sysconf(_SC_PAGESIZE));
+#endif
+	return 0;
+}
+
+void run_scaling_bench(ScalingBenchOptions const &options, std::string const &json_file) {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	std::ofstream json(json_file);
+	if (!json) throw std::runtime_error("Failed to open '" + json_file + "' for writing benchmark results.");
+
+	//keep running 'step' until the frame/time limits say to stop:
+	auto keep_going = [&options](uint32_t frames, Clock::time_point start) -> bool {
+		if (frames < options.min_frames) return true;
+		if (frames >= options.max_frames) return false;
+		return std::chrono::duration< float >(Clock::now() - start).count() < options.seconds;
+	};
+
+	json << "{\n";
+	json << "\t\"benchmark\": \"breakout-scaling\",\n";
+	json << "\t\"seed\": " << options.seed << ",\n";
+	json << "\t\"drawable_size\": [" << options.drawable_size.x << ", " << options.drawable_size.y << "],\n";
+	json << "\t\"results\": [\n";
+
+	for (uint32_t count_index = 0; count_index < options.brick_counts.size(); ++count_index) {
+		uint32_t brick_count = options.brick_counts[count_index];
+		std::cout << "Scaling benchmark: " << brick_count << " bricks..." << std::endl;
+
+		//----- generate + load level -----
+		LevelGenOptions gen;
+		gen.seed = options.seed;
+		gen.brick_count = brick_count;
+		gen.density = 0.85f;
+		gen.aspect = 13.0f / 6.0f;
+		gen.field_radius = glm::vec2(6.5f, 3.0f); //(shrink bricks to fit the usual court)
+		for (uint32_t c = 0; c < BreakoutGame::COLOR_COUNT; ++c) {
+			gen.colors.emplace_back(BreakoutGame::COLORS[c].first);
+		}
+
+		auto before_generate = Clock::now();
+		std::vector< uint8_t > level_bytes = generate_level(gen).serialize();
+		auto after_generate = Clock::now();
+		size_t level_size = level_bytes.size();
+		Level level(std::move(level_bytes), "generated level");
+
+		BreakoutGame game;
+		auto before_load = Clock::now();
+		game.load_level(level);
+		auto after_load = Clock::now();
+
+		//----- simulation -----
+		//the paddle follows the ball (a little off-center, so the ball goes sideways)
+		// and changes color now and then, so the ball breaks bricks of every color:
+		Samples update_ns;
+		game.launch();
+		auto start = Clock::now();
+		for (uint32_t frame = 0; keep_going(frame, start); ++frame) {
+			game.paddle.x = game.ball.x - 0.3f * game.paddle_radius.x;
+			if (frame % 60 == 59) game.cycle_paddle_color();
+			if (game.ball_reset) game.launch();
+
+			auto before = Clock::now();
+			game.update(1.0f / 60.0f);
+			auto after = Clock::now();
+			update_ns.values.emplace_back(std::chrono::duration< float, std::nano >(after - before).count());
+		}
+		int bricks_broken = game.score;
+
+		//----- rendering -----
+		//(draws the simulated state into the current framebuffer; nothing is shown)
+		BreakoutMode mode;
+		mode.game = game;
+		mode.resize(options.drawable_size, options.drawable_size);
+		glViewport(0, 0, options.drawable_size.x, options.drawable_size.y);
+
+		Samples build_ms, draw_ms;
+		std::vector< BreakoutMode::Vertex > vertices;
+		start = Clock::now();
+		for (uint32_t frame = 0; keep_going(frame, start); ++frame) {
+			//vertex build alone:
+			vertices.clear();
+			auto before_build = Clock::now();
+			mode.build_vertices(&vertices);
+			auto after_build = Clock::now();
+			build_ms.values.emplace_back(std::chrono::duration< float, std::milli >(after_build - before_build).count());
+
+			//the whole draw (build + upload + draw call submission):
+			auto before_draw = Clock::now();
+			mode.draw(options.drawable_size);
+			auto after_draw = Clock::now();
+			draw_ms.values.emplace_back(std::chrono::duration< float, std::milli >(after_draw - before_draw).count());
+
+			//(don't let the GPU queue up work between frames)
+			glFinish();
+		}
+		size_t upload_bytes = vertices.size() * sizeof(BreakoutMode::Vertex);
+
+		//----- memory -----
+		size_t brick_bytes = game.bricks.capacity() * sizeof(BreakoutGame::Brick);
+		size_t vertex_bytes = vertices.capacity() * sizeof(BreakoutMode::Vertex);
+		size_t rss = resident_bytes();
+
+		//----- report -----
+		json << "\t\t{\n";
+		json << "\t\t\t\"bricks\": " << brick_count << ",\n";
+		json << "\t\t\t\"generate_ms\": " << std::chrono::duration< double, std::milli >(after_generate - before_generate).count() << ",\n";
+		json << "\t\t\t\"load_ms\": " << std::chrono::duration< double, std::milli >(after_load - before_load).count() << ",\n";
+		json << "\t\t\t\"bricks_broken\": " << bricks_broken << ",\n";
+		json << "\t\t\t\"update_ns_per_frame\": "; update_ns.write_json(json); json << ",\n";
+		json << "\t\t\t\"vertex_build_ms\": "; build_ms.write_json(json); json << ",\n";
+		json << "\t\t\t\"draw_cpu_ms\": "; draw_ms.write_json(json); json << ",\n";
+		json << "\t\t\t\"upload_bytes_per_frame\": " << upload_bytes << ",\n";
+		json << "\t\t\t\"memory_bytes\": {\"level\": " << level_size << ", \"bricks\": " << brick_bytes
+			<< ", \"vertices\": " << vertex_bytes << ", \"process_rss\": " << rss << "}\n";
+		json << "\t\t}" << (count_index + 1 < options.brick_counts.size() ? "," : "") << "\n";
+
+		std::cout << "  update: " << percentile(update_ns.values, 0.5f) << " ns/frame (p50);"
+			<< " draw: " << percentile(draw_ms.values, 0.5f) << " ms/frame (p50);"
+			<< " upload: " << upload_bytes << " bytes/frame." << std::endl;
+	}
+
+	json << "\t]\n";
+	json << "}\n";
+
+	std::cout << "Wrote scaling benchmark results to '" << json_file << "'." << std::endl;
+}
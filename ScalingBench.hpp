@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * The scaling benchmark generates Breakout levels with more and more bricks (see generate_level)
+ * and, for each, measures:
+ *  - the headless simulation (BreakoutGame::update), in ns per frame;
+ *  - the renderer (BreakoutMode::draw), in CPU ms per frame, and the bytes it uploads per frame;
+ *  - the memory used by the level file, the game's bricks, and the vertices (plus process RSS, where available).
+ * Results are written as JSON, for tracking over time.
+ *
+ * The draw part needs a current OpenGL context (main.cpp runs this with --scaling-bench).
+ */
+
+struct ScalingBenchOptions {
+	std::vector< uint32_t > brick_counts = std::vector< uint32_t >{1000, 10000, 100000, 1000000};
+	uint32_t seed = 0; //passed to generate_level
+
+	//each measurement runs for at least min_frames and until it has taken (about) 'seconds':
+	uint32_t min_frames = 10;
+	uint32_t max_frames = 2000;
+	float seconds = 0.5f;
+
+	glm::uvec2 drawable_size = glm::uvec2(640, 480);
+};
+
+//run the benchmark (printing progress to std::cout) and write results to 'json_file':
+void run_scaling_bench(ScalingBenchOptions const &options, std::string const &json_file);
@@ -0,0 +1,311 @@
+#include "SoftRaster.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFT_RASTER_SSE
+#include <emmintrin.h>
+#endif
+
+SoftRaster::SoftRaster(uint32_t threads) {
+	if (threads != 1) pool.reset(new ThreadPool(threads));
+}
+
+SoftRaster::~SoftRaster() {
+}
+
+//x / 255, rounded to nearest (exact for x in [0, 255 * 255]):
+static inline uint32_t div255(uint32_t x) {
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+//std::ceil, without the library call (for |x| < 2^23, where floats convert to int32_t exactly):
+static inline int32_t ceil_int(float x) {
+	int32_t i = int32_t(x); //(rounds toward zero)
+	return i + (float(i) < x ? 1 : 0);
+}
+
+//blend 'color' over 'rows' rows of 'count' pixels starting at 'dst', 'stride' pixels apart
+// (src * a + dst * (1 - a), on every channel including alpha):
+static void blend_rows(glm::u8vec4 *dst, int32_t stride, int32_t count, int32_t rows, glm::u8vec4 const &color) {
+	if (color.a == 0xff) {
+		for (int32_t y = 0; y < rows; ++y, dst += stride) {
+			std::fill(dst, dst + count, color);
+		}
+		return;
+	}
+	if (color.a == 0) return;
+
+	uint32_t a = color.a;
+	uint32_t inv = 0xff - a;
+#ifdef SOFT_RASTER_SSE
+	//four pixels (sixteen channels) at a time, as two halves of eight 16-bit channels:
+	__m128i src = _mm_set_epi16(
+		short(color.a * a), short(color.b * a), short(color.g * a), short(color.r * a),
+		short(color.a * a), short(color.b * a), short(color.g * a), short(color.r * a)
+	);
+	__m128i scale = _mm_set1_epi16(short(inv));
+	__m128i round = _mm_set1_epi16(128);
+	__m128i zero = _mm_setzero_si128();
+	auto blend_half = [&](__m128i d) -> __m128i {
+		__m128i x = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(d, scale), src), round);
+		return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+	};
+	for (int32_t y = 0; y < rows; ++y, dst += stride) {
+		int32_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128i d = _mm_loadu_si128(reinterpret_cast< __m128i const * >(dst + i));
+			__m128i lo = blend_half(_mm_unpacklo_epi8(d, zero));
+			__m128i hi = blend_half(_mm_unpackhi_epi8(d, zero));
+			_mm_storeu_si128(reinterpret_cast< __m128i * >(dst + i), _mm_packus_epi16(lo, hi));
+		}
+		//(the rest one pixel at a time -- the same arithmetic, so the same result as the scalar loop below)
+		for (; i < count; ++i) {
+			int32_t pixel;
+			std::memcpy(&pixel, static_cast< void const * >(dst + i), 4);
+			__m128i d = blend_half(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero));
+			pixel = _mm_cvtsi128_si32(_mm_packus_epi16(d, d));
+			std::memcpy(static_cast< void * >(dst + i), &pixel, 4);
+		}
+	}
+#else
+	for (int32_t y = 0; y < rows; ++y, dst += stride) {
+		for (int32_t i = 0; i < count; ++i) {
+			glm::u8vec4 &d = dst[i];
+			d.r = uint8_t(div255(color.r * a + d.r * inv));
+			d.g = uint8_t(div255(color.g * a + d.g * inv));
+			d.b = uint8_t(div255(color.b * a + d.b * inv));
+			d.a = uint8_t(div255(color.a * a + d.a * inv));
+		}
+	}
+#endif
+}
+
+void SoftRaster::draw(glm::uvec2 const &size, glm::u8vec4 const &clear_color, glm::mat4 const &object_to_clip,
+	std::vector< PosColTexVertex > const &vertices, std::vector< glm::u8vec4 > *pixels) {
+	begin(size, clear_color, object_to_clip, pixels);
+
+	//----- set up triangles -----
+	triangles.reserve(vertices.size() / 3);
+	for (size_t v = 0; v + 2 < vertices.size(); v += 3) {
+		//vertices [v, v+6) might be a rectangle as draw_rectangle makes them -- (l,b) (r,b) (r,t), (l,b) (r,t) (l,t), one color:
+		if (v + 5 < vertices.size()) {
+			PosColTexVertex const *q = &vertices[v];
+			glm::vec3 const &lb = q[0].Position, &rb = q[1].Position, &rt = q[2].Position, &lt = q[5].Position;
+			if (q[3].Position == lb && q[4].Position == rt && q[3].Color == q[0].Color
+			 && lb.y == rb.y && rb.x == rt.x && rt.y == lt.y && lt.x == lb.x
+			 && add_rectangle(lb, rb, rt, lt, q[0].Color)) {
+				v += 3; //(both triangles done)
+				continue;
+			}
+		}
+		add_triangle(vertices[v].Position, vertices[v + 1].Position, vertices[v + 2].Position, vertices[v].Color);
+	}
+
+	finish();
+}
+
+void SoftRaster::draw_rectangles(glm::uvec2 const &size, glm::u8vec4 const &clear_color, glm::mat4 const &object_to_clip,
+	std::vector< Rectangle > const &rectangles, std::vector< glm::u8vec4 > *pixels) {
+	begin(size, clear_color, object_to_clip, pixels);
+
+	for (Rectangle const &r : rectangles) {
+		glm::vec3 lb = glm::vec3(r.min.x, r.min.y, 0.0f), rb = glm::vec3(r.max.x, r.min.y, 0.0f);
+		glm::vec3 rt = glm::vec3(r.max.x, r.max.y, 0.0f), lt = glm::vec3(r.min.x, r.max.y, 0.0f);
+		if (add_rectangle(lb, rb, rt, lt, r.color)) continue;
+		//(as the two triangles draw_rectangle makes)
+		add_triangle(lb, rb, rt, r.color);
+		add_triangle(lb, rt, lt, r.color);
+	}
+
+	finish();
+}
+
+void SoftRaster::begin(glm::uvec2 const &size, glm::u8vec4 const &clear_color, glm::mat4 const &object_to_clip_,
+	std::vector< glm::u8vec4 > *pixels) {
+	pixels->resize(size_t(size.x) * size.y);
+	target_size = size;
+	target_clear = clear_color;
+	target = pixels->data();
+	object_to_clip = object_to_clip_;
+
+	//if object_to_clip keeps window x and y apart (no rotation, skew, depth, or perspective),
+	// window x only depends on x and window y on y -- so to_window can skip most of the product,
+	// and add_rectangle needn't transform a rectangle's other two corners to see that it stays axis-aligned:
+	glm::mat4 const &m = object_to_clip;
+	separable = (m[0][1] == 0.0f && m[0][3] == 0.0f && m[1][0] == 0.0f && m[1][3] == 0.0f
+		&& m[2][0] == 0.0f && m[2][1] == 0.0f && m[2][3] == 0.0f);
+
+	tiles = glm::uvec2((size.x + TileSize - 1) / TileSize, (size.y + TileSize - 1) / TileSize);
+	bins.resize(tiles.x * tiles.y);
+	for (auto &bin : bins) {
+		bin.clear(); //(keeps capacity from frame to frame)
+	}
+	triangles.clear();
+}
+
+glm::vec2 SoftRaster::to_window(glm::vec3 const &position) const {
+	glm::mat4 const &m = object_to_clip;
+	glm::vec4 clip;
+	if (separable) {
+		//(the full product, less the terms that are always zero)
+		clip = glm::vec4(m[0][0] * position.x, m[1][1] * position.y, 0.0f, m[3][3]);
+		clip.x += m[3][0];
+		clip.y += m[3][1];
+	} else {
+		clip = m * glm::vec4(position, 1.0f);
+	}
+	return glm::vec2(
+		(clip.x / clip.w * 0.5f + 0.5f) * target_size.x,
+		(clip.y / clip.w * 0.5f + 0.5f) * target_size.y
+	);
+}
+
+void SoftRaster::bin(Binned const &binned) {
+	//(bounds are clamped to the target, so never negative)
+	for (uint32_t ty = uint32_t(binned.min.y) / TileSize; ty <= uint32_t(binned.max.y - 1) / TileSize; ++ty) {
+		for (uint32_t tx = uint32_t(binned.min.x) / TileSize; tx <= uint32_t(binned.max.x - 1) / TileSize; ++tx) {
+			bins[ty * tiles.x + tx].emplace_back(binned);
+		}
+	}
+}
+
+bool SoftRaster::add_rectangle(glm::vec3 const &lb, glm::vec3 const &rb, glm::vec3 const &rt, glm::vec3 const &lt, glm::u8vec4 const &color) {
+	glm::vec2 min = to_window(lb), max = to_window(rt);
+	if (!separable) {
+		glm::vec2 p1 = to_window(rb), p5 = to_window(lt);
+		if (!(p1.y == min.y && p1.x == max.x && p5.x == min.x && p5.y == max.y)) return false; //(not axis-aligned)
+	}
+	if (!(min.x < max.x && min.y < max.y)) return false; //(mirrored, empty, or not finite)
+	if (!(std::abs(min.x) < 1e6f && std::abs(min.y) < 1e6f && std::abs(max.x) < 1e6f && std::abs(max.y) < 1e6f)) return false;
+
+	//pixel (x,y) is covered if its center is inside: min <= (x,y) + 0.5 < max;
+	// but where an edge is within rounding error of pixel centers, leave it to the triangles' tie-breaking rule:
+	auto near_center = [](float e) -> bool {
+		float f = e - 0.5f;
+		float nearest = float(int32_t(f + (f < 0.0f ? -0.5f : 0.5f))); //(|f| < 1e6, so this can't overflow)
+		return std::abs(f - nearest) < 1e-3f;
+	};
+	if (near_center(min.x) || near_center(min.y) || near_center(max.x) || near_center(max.y)) return false;
+
+	Binned rect;
+	rect.min = glm::ivec2(
+		std::max(0, ceil_int(min.x - 0.5f)),
+		std::max(0, ceil_int(min.y - 0.5f))
+	);
+	rect.max = glm::ivec2(
+		std::min(int32_t(target_size.x), ceil_int(max.x - 0.5f)),
+		std::min(int32_t(target_size.y), ceil_int(max.y - 0.5f))
+	);
+	rect.color = color;
+	rect.triangle = -1U;
+	if (rect.min.x < rect.max.x && rect.min.y < rect.max.y) bin(rect);
+	return true;
+}
+
+void SoftRaster::add_triangle(glm::vec3 const &a, glm::vec3 const &b, glm::vec3 const &c, glm::u8vec4 const &color) {
+	//to window coordinates:
+	glm::vec2 p[3] = { to_window(a), to_window(b), to_window(c) };
+
+	float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+	if (area == 0.0f || !std::isfinite(area)) return;
+	if (area < 0.0f) std::swap(p[1], p[2]); //(make counterclockwise; the modes don't cull)
+
+	Triangle tri;
+	for (uint32_t e = 0; e < 3; ++e) {
+		glm::vec2 const &from = p[e];
+		glm::vec2 const &to = p[(e + 1) % 3];
+		tri.A[e] = -(to.y - from.y);
+		tri.B[e] = (to.x - from.x);
+		//compute C from the same endpoint no matter which way the edge runs,
+		// so triangles sharing an edge get exactly opposite edge functions:
+		glm::vec2 const &base = (from.x < to.x || (from.x == to.x && from.y < to.y) ? from : to);
+		tri.C[e] = -(tri.A[e] * base.x + tri.B[e] * base.y);
+	}
+	glm::vec2 lo = glm::min(p[0], glm::min(p[1], p[2]));
+	glm::vec2 hi = glm::max(p[0], glm::max(p[1], p[2]));
+	Binned binned;
+	//(clamped as floats, since vertices can be far outside the window)
+	binned.min = glm::ivec2(
+		int32_t(std::floor(std::max(lo.x, 0.0f))),
+		int32_t(std::floor(std::max(lo.y, 0.0f)))
+	);
+	binned.max = glm::ivec2(
+		int32_t(std::ceil(std::min(hi.x, float(target_size.x)))),
+		int32_t(std::ceil(std::min(hi.y, float(target_size.y))))
+	);
+	if (binned.min.x >= binned.max.x || binned.min.y >= binned.max.y) return;
+	binned.color = color;
+	binned.triangle = uint32_t(triangles.size());
+
+	triangles.emplace_back(tri);
+	bin(binned);
+}
+
+void SoftRaster::finish() {
+	//----- draw tiles -----
+	if (pool) {
+		for (uint32_t tile = 0; tile < bins.size(); ++tile) {
+			pool->submit([this, tile]() { draw_tile(tile); });
+		}
+		pool->wait();
+	} else {
+		for (uint32_t tile = 0; tile < bins.size(); ++tile) {
+			draw_tile(tile);
+		}
+	}
+
+	target = nullptr;
+}
+
+void SoftRaster::draw_tile(uint32_t tile) {
+	glm::ivec2 tile_min = glm::ivec2(tile % tiles.x, tile / tiles.x) * int32_t(TileSize);
+	glm::ivec2 tile_max = glm::min(tile_min + int32_t(TileSize), glm::ivec2(target_size));
+	int32_t stride = int32_t(target_size.x);
+
+	for (int32_t y = tile_min.y; y < tile_max.y; ++y) {
+		glm::u8vec4 *row = target + y * stride;
+		std::fill(row + tile_min.x, row + tile_max.x, target_clear);
+	}
+
+	for (Binned const &binned : bins[tile]) {
+		int32_t min_y = std::max(binned.min.y, tile_min.y);
+		int32_t max_y = std::min(binned.max.y, tile_max.y);
+		if (binned.triangle == -1U) {
+			int32_t x0 = std::max(binned.min.x, tile_min.x);
+			int32_t x1 = std::min(binned.max.x, tile_max.x);
+			if (min_y < max_y) blend_rows(target + min_y * stride + x0, stride, x1 - x0, max_y - min_y, binned.color);
+			continue;
+		}
+		Triangle const &tri = triangles[binned.triangle];
+		for (int32_t y = min_y; y < max_y; ++y) {
+			//the span of pixel centers inside all three edges on this row:
+			// (left bounds are inclusive, right bounds exclusive -- so shared edges cover each pixel once)
+			float cy = y + 0.5f;
+			int32_t x0 = std::max(binned.min.x, tile_min.x);
+			int32_t x1 = std::min(binned.max.x, tile_max.x);
+			for (uint32_t e = 0; e < 3 && x0 < x1; ++e) {
+				float K = tri.B[e] * cy + tri.C[e];
+				//(bounds are clamped as floats, since nearly-horizontal edges can put them far outside the tile)
+				if (tri.A[e] > 0.0f) {
+					//inside for x >= -K / A:
+					float bound = std::ceil(-K / tri.A[e] - 0.5f);
+					if (bound > float(x0)) x0 = (bound < float(x1) ? int32_t(bound) : x1);
+				} else if (tri.A[e] < 0.0f) {
+					//inside for x < -K / A:
+					float bound = std::ceil(-K / tri.A[e] - 0.5f);
+					if (bound < float(x1)) x1 = (bound > float(x0) ? int32_t(bound) : x0);
+				} else if (K < 0.0f || (K == 0.0f && tri.B[e] < 0.0f)) {
+					//horizontal edge with the row outside (or on it, for edges that run right-to-left):
+					x1 = x0;
+				}
+			}
+			if (x0 < x1) blend_rows(target + y * stride + x0, stride, x1 - x0, 1, binned.color);
+		}
+	}
+}
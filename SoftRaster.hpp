@@ -0,0 +1,93 @@
+#pragma once
+
+#include "GLResources.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+struct ThreadPool;
+
+/*
+ * SoftRaster draws the same triangle lists the modes build for OpenGL (see BreakoutMode::build_vertices)
+ * into a CPU framebuffer -- no OpenGL context needed -- with the same blending as the modes use
+ * (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA; the modes draw untextured, flat-colored rectangles,
+ * so each triangle takes the color of its first vertex).
+ *
+ * The framebuffer is split into TileSize x TileSize tiles; triangles are binned to the tiles they touch,
+ * and tiles are drawn independently (in parallel on a ThreadPool, if there are multiple threads),
+ * each one a row of spans at a time, blended four pixels at once with SSE2 where available.
+ * Bins hold each primitive's bounds and color (rectangles need nothing else), so drawing a tile
+ * reads its bin front to back instead of chasing indices around the whole triangle list.
+ *
+ * Pixel centers are sampled: a pixel is covered if its center is inside the triangle
+ * (with a tie-breaking rule so triangles sharing an edge never both cover a pixel).
+ *
+ * Pairs of triangles that make an axis-aligned rectangle (as the modes' draw_rectangle and
+ * Particles::build_vertices emit them) are drawn as one rectangle -- a span per row, with no edge functions --
+ * unless an edge lies (nearly) on a row or column of pixel centers, where the triangles' tie-breaking
+ * decides; so the pixels covered are always the same as drawing the two triangles.
+ */
+
+struct SoftRaster {
+	//draw with 'threads' threads (0 => one per hardware thread; 1 => on the calling thread):
+	SoftRaster(uint32_t threads = 0);
+	~SoftRaster();
+
+	//clear 'pixels' (resized to size.x * size.y) to 'clear_color' and draw 'vertices' as triangles,
+	// mapped to clip space by 'object_to_clip';
+	// pixels are stored row-major starting from the lower left (as glReadPixels does; save with LowerLeftOrigin):
+	void draw(glm::uvec2 const &size, glm::u8vec4 const &clear_color, glm::mat4 const &object_to_clip,
+		std::vector< PosColTexVertex > const &vertices, std::vector< glm::u8vec4 > *pixels);
+
+	//an axis-aligned rectangle (in object space):
+	struct Rectangle {
+		glm::vec2 min, max;
+		glm::u8vec4 color;
+	};
+	//as draw(), for a list of rectangles -- the same pixels as drawing each one as draw_rectangle's two triangles,
+	// from a sixth of the data (e.g., Particles::build_rectangles, for lots of small particles):
+	void draw_rectangles(glm::uvec2 const &size, glm::u8vec4 const &clear_color, glm::mat4 const &object_to_clip,
+		std::vector< Rectangle > const &rectangles, std::vector< glm::u8vec4 > *pixels);
+
+	static const uint32_t TileSize = 64;
+
+	//----- internals -----
+	std::unique_ptr< ThreadPool > pool;
+
+	//triangle's edges, ready to rasterize:
+	struct Triangle {
+		//edges as A * x + B * y + C >= 0 inside (window coordinates):
+		float A[3], B[3], C[3];
+	};
+	std::vector< Triangle > triangles;
+
+	//something to draw in a tile:
+	struct Binned {
+		glm::ivec2 min, max; //pixel bounds (max is exclusive)
+		glm::u8vec4 color;
+		uint32_t triangle; //index into 'triangles', or -1U for a rectangle (which covers exactly [min, max))
+	};
+	std::vector< std::vector< Binned > > bins; //what touches each tile, in drawing order
+	glm::uvec2 tiles = glm::uvec2(0);
+
+	//(what draw() is working on, so tile jobs only need to know their tile)
+	glm::uvec2 target_size = glm::uvec2(0);
+	glm::u8vec4 target_clear = glm::u8vec4(0);
+	glm::u8vec4 *target = nullptr;
+	glm::mat4 object_to_clip = glm::mat4(1.0f);
+	bool separable = false; //(does object_to_clip keep window x and y apart? see begin())
+
+	//set up a draw, add what to draw, then draw it:
+	void begin(glm::uvec2 const &size, glm::u8vec4 const &clear_color, glm::mat4 const &object_to_clip, std::vector< glm::u8vec4 > *pixels);
+	//add the rectangle with these corners as a rectangle, if it can be (else returns false -- draw it as triangles):
+	bool add_rectangle(glm::vec3 const &lb, glm::vec3 const &rb, glm::vec3 const &rt, glm::vec3 const &lt, glm::u8vec4 const &color);
+	void add_triangle(glm::vec3 const &a, glm::vec3 const &b, glm::vec3 const &c, glm::u8vec4 const &color);
+	void finish();
+
+	glm::vec2 to_window(glm::vec3 const &position) const;
+	void bin(Binned const &binned); //add to the bins of the tiles it touches
+	void draw_tile(uint32_t tile);
+};
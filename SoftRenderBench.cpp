@@ -0,0 +1,112 @@
+#include "SoftRenderBench.hpp"
+
+#include "SoftRaster.hpp"
+#include "BreakoutMode.hpp"
+#include "OffscreenFramebuffer.hpp"
+#include "load_save_png.hpp"
+
+#include "GL.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+
+//frames per second SoftRaster manages on 'threads' threads, measured for about 'seconds':
+static double measure_fps(uint32_t threads, float seconds, glm::uvec2 const &size, BreakoutMode const &mode, std::vector< BreakoutMode::Vertex > const &vertices) {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	SoftRaster raster(threads);
+	std::vector< glm::u8vec4 > pixels;
+	uint32_t frames = 0;
+	auto before = Clock::now();
+	double elapsed = 0.0;
+	while (frames < 10 || elapsed < seconds) {
+		raster.draw(size, mode.bg_color, mode.court_to_clip, vertices, &pixels);
+		frames += 1;
+		elapsed = std::chrono::duration< double >(Clock::now() - before).count();
+	}
+	return frames / elapsed;
+}
+
+bool run_soft_render(SoftRenderOptions const &options, std::ostream &out) {
+	//----- play a bit, so there is something to draw -----
+	BreakoutMode mode(options.level_file);
+	mode.game.autopilot = true;
+	mode.game.seed(options.seed);
+	for (uint32_t frame = 0; frame < options.frames_played; ++frame) {
+		mode.update(1.0f / 60.0f); //(the mode, not just the game, so the ball has a trail)
+	}
+	mode.resize(options.size, options.size);
+
+	std::vector< BreakoutMode::Vertex > vertices;
+	mode.build_vertices(&vertices);
+
+	//----- speed -----
+	uint32_t threads = (options.threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : options.threads);
+	double fps_one = measure_fps(1, options.seconds, options.size, mode, vertices);
+	out << "SoftRaster: " << options.size.x << "x" << options.size.y << ", " << (vertices.size() / 3) << " triangles:\n";
+	out << "  1 thread: " << fps_one << " frames/sec\n";
+	if (threads > 1) {
+		double fps_all = measure_fps(threads, options.seconds, options.size, mode, vertices);
+		out << "  " << threads << " threads: " << fps_all << " frames/sec\n";
+	}
+
+	SoftRaster raster(1);
+	std::vector< glm::u8vec4 > soft;
+	raster.draw(options.size, mode.bg_color, mode.court_to_clip, vertices, &soft);
+
+	//----- against OpenGL -----
+	//(GL rasterization rules and blending precision are implementation-specific,
+	// so expect differences of a count or so along edges and in blended colors)
+	{
+		OffscreenFramebuffer framebuffer(options.size);
+		framebuffer.bind();
+		mode.draw(options.size);
+		std::vector< glm::u8vec4 > gl;
+		framebuffer.read(&gl);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		uint32_t differ = 0, max_difference = 0;
+		for (size_t i = 0; i < soft.size(); ++i) {
+			uint32_t difference = 0;
+			for (uint32_t c = 0; c < 4; ++c) {
+				difference = std::max(difference, uint32_t(std::abs(int32_t(soft[i][c]) - int32_t(gl[i][c]))));
+			}
+			if (difference > 1) differ += 1;
+			max_difference = std::max(max_difference, difference);
+		}
+		out << "  vs OpenGL: " << differ << " of " << soft.size() << " pixels differ by more than 1 (max difference " << max_difference << ").\n";
+	}
+
+	//----- golden images -----
+	bool matched = true;
+	if (options.golden_file != "") {
+		glm::uvec2 golden_size;
+		std::vector< glm::u8vec4 > golden;
+		load_png(options.golden_file, &golden_size, &golden, LowerLeftOrigin);
+		if (golden_size != options.size) {
+			out << "  golden '" << options.golden_file << "' is " << golden_size.x << "x" << golden_size.y << ", not " << options.size.x << "x" << options.size.y << ".\n";
+			matched = false;
+		} else {
+			uint32_t differ = 0;
+			for (size_t i = 0; i < soft.size(); ++i) {
+				if (soft[i] != golden[i]) differ += 1;
+			}
+			if (differ == 0) {
+				out << "  matches golden '" << options.golden_file << "'.\n";
+			} else {
+				out << "  " << differ << " pixels differ from golden '" << options.golden_file << "'.\n";
+				matched = false;
+			}
+		}
+	}
+	if (options.png_file != "") {
+		save_png(options.png_file, options.size, soft.data(), LowerLeftOrigin);
+		out << "  wrote frame to '" << options.png_file << "'.\n";
+	}
+	out.flush();
+
+	return matched;
+}
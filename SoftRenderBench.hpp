@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <iostream>
+#include <cstdint>
+
+/*
+ * The software-render check plays a few seconds of Breakout on autopilot, then draws the
+ * final frame with SoftRaster and:
+ *  - reports SoftRaster's frames/sec (on one thread and on 'threads' threads);
+ *  - compares the frame against OpenGL's rendering of the same vertices (drawn into an offscreen framebuffer);
+ *  - writes it as a PNG (a "golden" image) and/or compares it against a previously-written golden.
+ *
+ * BreakoutMode needs a current OpenGL context to construct (main.cpp runs this with --soft-render).
+ */
+
+struct SoftRenderOptions {
+	glm::uvec2 size = glm::uvec2(640, 480);
+	std::string level_file = ""; //(empty => built-in level)
+	uint32_t seed = 0;
+	uint32_t frames_played = 180; //autopilot frames (at 60fps) before the frame is captured
+	uint32_t threads = 0; //0 => one per hardware thread
+	float seconds = 1.0f; //time spent measuring each thread count
+
+	std::string png_file = ""; //if set, write the frame here
+	std::string golden_file = ""; //if set, the frame must match this PNG exactly
+};
+
+//returns false if the frame doesn't match the golden image:
+bool run_soft_render(SoftRenderOptions const &options, std::ostream &out);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+//StateHash accumulates a 64-bit FNV-1a hash over raw bytes.
+// Modes use it to summarize their simulation state bit-exactly (see Mode::state_hash):
+struct StateHash {
+	uint64_t value = 14695981039346656037ULL;
+
+	void add_bytes(void const *data, size_t size) {
+		uint8_t const *bytes = reinterpret_cast< uint8_t const * >(data);
+		for (size_t i = 0; i < size; ++i) {
+			value ^= bytes[i];
+			value *= 1099511628211ULL;
+		}
+	}
+
+	//NOTE: only use with types without padding (floats, ints, glm vectors):
+	template< typename T >
+	void add(T const &t) {
+		add_bytes(&t, sizeof(T));
+	}
+};
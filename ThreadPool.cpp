@@ -0,0 +1,111 @@
+#include "ThreadPool.hpp"
+
+#include "Trace.hpp"
+
+#include <algorithm>
+
+//index of the pool worker running on this thread (if any), so that jobs that submit jobs keep them local:
+static thread_local ThreadPool *local_pool = nullptr;
+static thread_local uint32_t local_index = 0;
+
+ThreadPool::ThreadPool(uint32_t count) : queued(0), pending(0), next_queue(0) {
+	if (count == 0) count = std::max(1u, std::thread::hardware_concurrency());
+	queues.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		queues.emplace_back(new Queue());
+	}
+	threads.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		threads.emplace_back(&ThreadPool::worker, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		done_cv.wait(lock, [this](){ return pending == 0; });
+		quit = true;
+	}
+	work_cv.notify_all();
+	for (auto &thread : threads) {
+		thread.join();
+	}
+}
+
+void ThreadPool::submit(std::function< void() > const &job) {
+	uint32_t index;
+	if (local_pool == this) index = local_index;
+	else index = next_queue++ % uint32_t(queues.size());
+
+	pending += 1;
+	{
+		std::unique_lock< std::mutex > lock(queues[index]->mutex);
+		queues[index]->jobs.emplace_back(job);
+	}
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		queued += 1;
+	}
+	work_cv.notify_one();
+}
+
+void ThreadPool::wait() {
+	std::unique_lock< std::mutex > lock(mutex);
+	done_cv.wait(lock, [this](){ return pending == 0; });
+	if (error) {
+		std::exception_ptr e = error;
+		error = nullptr;
+		std::rethrow_exception(e);
+	}
+}
+
+bool ThreadPool::take(uint32_t index, std::function< void() > *job) {
+	{ //newest job from own queue (likely still warm in cache):
+		Queue &queue = *queues[index];
+		std::unique_lock< std::mutex > lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			*job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			return true;
+		}
+	}
+	//otherwise steal the oldest job from another queue:
+	for (uint32_t offset = 1; offset < queues.size(); ++offset) {
+		Queue &queue = *queues[(index + offset) % queues.size()];
+		std::unique_lock< std::mutex > lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			*job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::worker(uint32_t index) {
+	local_pool = this;
+	local_index = index;
+	Trace::set_thread_name("pool worker " + std::to_string(index));
+
+	std::function< void() > job;
+	while (true) {
+		if (take(index, &job)) {
+			queued -= 1;
+			try {
+				job();
+			} catch (...) {
+				std::unique_lock< std::mutex > lock(mutex);
+				if (!error) error = std::current_exception();
+			}
+			job = nullptr;
+			if (--pending == 0) {
+				std::unique_lock< std::mutex > lock(mutex);
+				done_cv.notify_all();
+			}
+		} else {
+			std::unique_lock< std::mutex > lock(mutex);
+			work_cv.wait(lock, [this](){ return quit || queued > 0; });
+			if (quit && queued == 0) break;
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <cstdint>
+
+/*
+ * ThreadPool runs jobs on a fixed set of worker threads.
+ *
+ * Each worker has its own job queue: submitted jobs are dealt out round-robin
+ * (or, if submitted from a worker, go onto that worker's own queue);
+ * workers take jobs from the back of their own queue and, when it runs dry,
+ * steal from the front of the others' -- so uneven jobs still keep every thread busy.
+ *
+ * Usage:
+ *   ThreadPool pool; //one worker per hardware thread
+ *   for (...) pool.submit([=](){ ... });
+ *   pool.wait(); //returns when every job has finished (rethrows the first exception a job threw)
+ */
+
+struct ThreadPool {
+	//start 'count' workers (0 => one per hardware thread):
+	ThreadPool(uint32_t count = 0);
+	~ThreadPool(); //waits for queued jobs to finish
+
+	ThreadPool(ThreadPool const &) = delete;
+	ThreadPool &operator=(ThreadPool const &) = delete;
+
+	void submit(std::function< void() > const &job);
+	void wait();
+
+	uint32_t size() const { return uint32_t(threads.size()); }
+
+	//----- internals -----
+	struct Queue {
+		std::mutex mutex;
+		std::deque< std::function< void() > > jobs;
+	};
+	std::vector< std::unique_ptr< Queue > > queues; //one per worker
+	std::vector< std::thread > threads;
+
+	std::mutex mutex; //protects 'quit', 'error' and pairs with the condition variables
+	std::condition_variable work_cv; //signaled when jobs are queued (or on quit)
+	std::condition_variable done_cv; //signaled when the last pending job finishes
+	std::atomic< uint32_t > queued; //jobs sitting in queues
+	std::atomic< uint32_t > pending; //jobs submitted but not yet finished
+	std::atomic< uint32_t > next_queue; //round-robin position for submits from outside the pool
+	bool quit = false;
+	std::exception_ptr error; //first exception thrown by a job
+
+	bool take(uint32_t index, std::function< void() > *job); //own queue first, then steal
+	void worker(uint32_t index);
+};
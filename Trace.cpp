@@ -0,0 +1,148 @@
+#include "Trace.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <algorithm>
+
+std::atomic< bool > Trace::is_enabled(false);
+
+namespace {
+
+struct Span {
+	char const *name;
+	uint64_t begin_ns;
+	uint64_t end_ns;
+};
+
+//one per thread that has recorded (or been named); written only by its thread:
+struct Ring {
+	static const uint64_t Capacity = 1 << 16; //spans (power of two)
+	Ring(uint32_t tid_) : tid(tid_), spans(Capacity) { }
+	uint32_t tid;
+	std::vector< Span > spans;
+	std::atomic< uint64_t > head{0}; //spans ever recorded (next slot is head % Capacity)
+
+	std::mutex name_mutex; //(names are set rarely; the mutex just keeps write_json from reading a half-written one)
+	std::string name;
+};
+
+//every thread's ring; rings outlive their threads, so spans from finished threads can still be written:
+std::mutex rings_mutex;
+std::vector< std::unique_ptr< Ring > > &rings() {
+	static std::vector< std::unique_ptr< Ring > > list;
+	return list;
+}
+
+//(rings are made on a thread's first span, so naming threads -- e.g., every pool worker -- costs nothing untraced)
+thread_local Ring *local_ring = nullptr;
+thread_local std::string local_name; //name set before the ring existed
+
+Ring &get_local_ring() {
+	if (!local_ring) {
+		std::unique_lock< std::mutex > lock(rings_mutex);
+		rings().emplace_back(new Ring(uint32_t(rings().size()) + 1));
+		local_ring = rings().back().get();
+		local_ring->name = local_name;
+	}
+	return *local_ring;
+}
+
+std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+//names are literals in practice, but escape anything that would break the JSON:
+void write_escaped(std::ostream &out, std::string const &str) {
+	for (char c : str) {
+		if (c == '"' || c == '\\') out << '\\' << c;
+		else if (uint8_t(c) < 0x20) out << ' ';
+		else out << c;
+	}
+}
+
+}
+
+void Trace::enable() {
+	is_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Trace::disable() {
+	is_enabled.store(false, std::memory_order_relaxed);
+}
+
+uint64_t Trace::now_ns() {
+	return uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now() - origin).count());
+}
+
+void Trace::set_thread_name(std::string const &name) {
+	if (local_ring) {
+		std::unique_lock< std::mutex > lock(local_ring->name_mutex);
+		local_ring->name = name;
+	} else {
+		local_name = name;
+	}
+}
+
+void Trace::record(char const *name, uint64_t begin_ns, uint64_t end_ns) {
+	Ring &ring = get_local_ring();
+	uint64_t index = ring.head.load(std::memory_order_relaxed);
+	Span &span = ring.spans[index & (Ring::Capacity - 1)];
+	span.name = name;
+	span.begin_ns = begin_ns;
+	span.end_ns = end_ns;
+	ring.head.store(index + 1, std::memory_order_release);
+}
+
+void Trace::write_json(std::string const &filename) {
+	std::ofstream out(filename);
+	if (!out) throw std::runtime_error("Failed to open '" + filename + "' for writing a trace.");
+
+	out << std::fixed;
+	out.precision(3); //(timestamps are in microseconds; keep nanoseconds)
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	bool first = true;
+	auto separator = [&first, &out]() {
+		if (!first) out << ",\n";
+		first = false;
+	};
+
+	std::unique_lock< std::mutex > lock(rings_mutex);
+	std::vector< Span > spans;
+	for (auto const &ring_ptr : rings()) {
+		Ring &ring = *ring_ptr;
+
+		{ //thread name:
+			std::unique_lock< std::mutex > name_lock(ring.name_mutex);
+			if (!ring.name.empty()) {
+				separator();
+				out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring.tid << ", \"args\": {\"name\": \"";
+				write_escaped(out, ring.name);
+				out << "\"}}";
+			}
+		}
+
+		//copy out the spans, then drop any the owning thread may have overwritten while we copied:
+		uint64_t head = ring.head.load(std::memory_order_acquire);
+		uint64_t begin = (head > Ring::Capacity ? head - Ring::Capacity : 0);
+		spans.clear();
+		for (uint64_t i = begin; i < head; ++i) {
+			spans.emplace_back(ring.spans[i & (Ring::Capacity - 1)]);
+		}
+		uint64_t after = ring.head.load(std::memory_order_acquire);
+		uint64_t valid = (after > Ring::Capacity ? after - Ring::Capacity : 0);
+		size_t skip = size_t(std::min< uint64_t >(spans.size(), (valid > begin ? valid - begin : 0)));
+
+		for (size_t i = skip; i < spans.size(); ++i) {
+			Span const &span = spans[i];
+			separator();
+			out << "{\"name\": \"";
+			write_escaped(out, span.name);
+			out << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ring.tid
+				<< ", \"ts\": " << (span.begin_ns / 1000.0)
+				<< ", \"dur\": " << ((span.end_ns - span.begin_ns) / 1000.0) << "}";
+		}
+	}
+	out << "\n]}\n";
+}
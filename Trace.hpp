@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+/*
+ * Trace records nested, named time spans ("scopes") from any thread, and writes them
+ * in Chrome's trace-event JSON format (open in chrome://tracing or ui.perfetto.dev):
+ *
+ *   void Thing::update() {
+ *       TRACE_SCOPE("Thing::update"); //span lasts until the end of the enclosing block
+ *       ...
+ *   }
+ *
+ * Tracing is off until Trace::enable() (main.cpp's --trace); a disabled scope costs one relaxed atomic load.
+ * Defining TRACE_DISABLED compiles scopes out entirely.
+ *
+ * Each thread records into its own fixed-size ring buffer (no locks; only the owning thread writes),
+ * so when a ring wraps the oldest spans are dropped. Trace::write_json() can be called
+ * at any time (e.g., from a key press) and writes whatever the rings currently hold.
+ *
+ * Scope names must outlive the trace (string literals are ideal).
+ */
+
+struct Trace {
+	static void enable();
+	static void disable();
+	static bool enabled() { return is_enabled.load(std::memory_order_relaxed); }
+
+	//name the calling thread in the trace (e.g., "main", "pool worker 3"):
+	static void set_thread_name(std::string const &name);
+
+	//write every recorded span (and thread names) to 'filename':
+	static void write_json(std::string const &filename);
+
+	//----- recording -----
+	struct Scope {
+		Scope(char const *name_) : name(enabled() ? name_ : nullptr) {
+			if (name) begin = now_ns();
+		}
+		~Scope() {
+			if (name) record(name, begin, now_ns());
+		}
+		Scope(Scope const &) = delete;
+		Scope &operator=(Scope const &) = delete;
+
+		char const *name;
+		uint64_t begin = 0;
+	};
+
+	static uint64_t now_ns(); //nanoseconds since the program started
+	static void record(char const *name, uint64_t begin_ns, uint64_t end_ns);
+
+	static std::atomic< bool > is_enabled;
+};
+
+#define TRACE_CONCAT2(A, B) A ## B
+#define TRACE_CONCAT(A, B) TRACE_CONCAT2(A, B)
+
+#ifdef TRACE_DISABLED
+#define TRACE_SCOPE(NAME) do { } while (0)
+#else
+#define TRACE_SCOPE(NAME) Trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(NAME)
+#endif
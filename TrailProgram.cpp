@@ -0,0 +1,134 @@
+#include "TrailProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+//for glm::value_ptr() :
+#include <glm/gtc/type_ptr.hpp>
+
+#include <string>
+
+RainbowPaletteTexture::RainbowPaletteTexture() {
+	std::vector< glm::u8vec4 > const &colors = rainbow_colors();
+	size = uint32_t(colors.size());
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, GLsizei(size), 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, colors.data());
+	//(read with texelFetch, so filtering doesn't matter -- but without mipmaps it must not ask for them)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+RainbowPaletteTexture::~RainbowPaletteTexture() {
+	glDeleteTextures(1, &tex);
+	tex = 0;
+}
+
+TrailProgram::TrailProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"uniform vec3 SAMPLES[" + std::to_string(MaxSamples) + "];\n" //xy: position, z: age (oldest first)
+		"uniform int SAMPLE_COUNT;\n"
+		"uniform float LENGTH;\n"
+		"uniform vec2 RADIUS;\n"
+		"uniform int SEGMENTS;\n"
+		"uniform sampler2D PALETTE;\n"
+		"out vec4 color;\n"
+		"const vec2 CORNERS[6] = vec2[6](vec2(-1.0,-1.0), vec2(1.0,-1.0), vec2(1.0,1.0), vec2(-1.0,-1.0), vec2(1.0,1.0), vec2(-1.0,1.0));\n"
+		"void main() {\n"
+		"	int quad = gl_VertexID / 6;\n"
+		"	int segment = SEGMENTS - 1 - quad;\n" //(oldest segment first)
+		"	float t = float(segment + 1) / float(SEGMENTS) * LENGTH;\n"
+		//first sample after the oldest that is no older than t:
+		"	int lo = 1;\n"
+		"	int hi = SAMPLE_COUNT;\n"
+		"	while (lo < hi) {\n"
+		"		int mid = (lo + hi) / 2;\n"
+		"		if (SAMPLES[mid].z > t) lo = mid + 1;\n"
+		"		else hi = mid;\n"
+		"	}\n"
+		"	if (lo >= SAMPLE_COUNT) {\n"
+		//(no trail here: collapse the quad)
+		"		gl_Position = vec4(0.0, 0.0, 0.0, 1.0);\n"
+		"		color = vec4(0.0);\n"
+		"		return;\n"
+		"	}\n"
+		"	vec3 a = SAMPLES[lo-1];\n"
+		"	vec3 b = SAMPLES[lo];\n"
+		"	vec2 at = (b.z == a.z ? b.xy : (t - a.z) / (b.z - a.z) * (b.xy - a.xy) + a.xy);\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(at + CORNERS[gl_VertexID - quad * 6] * RADIUS, 0.0, 1.0);\n"
+		"	color = texelFetch(PALETTE, ivec2(segment, 0), 0);\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	);
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	SAMPLES_vec3_array = glGetUniformLocation(program, "SAMPLES");
+	SAMPLE_COUNT_int = glGetUniformLocation(program, "SAMPLE_COUNT");
+	LENGTH_float = glGetUniformLocation(program, "LENGTH");
+	RADIUS_vec2 = glGetUniformLocation(program, "RADIUS");
+	SEGMENTS_int = glGetUniformLocation(program, "SEGMENTS");
+	GLuint PALETTE_sampler2D = glGetUniformLocation(program, "PALETTE");
+
+	//set PALETTE to always refer to texture binding zero:
+	glUseProgram(program);
+	glUniform1i(PALETTE_sampler2D, 0);
+	glUseProgram(0);
+}
+
+TrailProgram::~TrailProgram() {
+	if (empty_vertex_array) glDeleteVertexArrays(1, &empty_vertex_array);
+	empty_vertex_array = 0;
+	glDeleteProgram(program);
+	program = 0;
+}
+
+void TrailProgram::draw(glm::mat4 const &object_to_clip, BallTrail const &trail, glm::vec2 const &radius, RainbowPaletteTexture const &palette) {
+	if (trail.count < 2 || palette.size == 0) return;
+
+	//the newest MaxSamples samples, as (x, y, age):
+	uint32_t count = (trail.count < MaxSamples ? trail.count : MaxSamples);
+	uint32_t first = trail.count - count;
+	glm::vec3 samples[MaxSamples];
+	for (uint32_t i = 0; i < count; ++i) {
+		samples[i] = glm::vec3(trail[first + i].position, trail.age(first + i));
+	}
+
+	if (!empty_vertex_array) glGenVertexArrays(1, &empty_vertex_array);
+
+	glUseProgram(program);
+	glUniformMatrix4fv(OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+	glUniform3fv(SAMPLES_vec3_array, GLsizei(count), glm::value_ptr(samples[0]));
+	glUniform1i(SAMPLE_COUNT_int, GLint(count));
+	glUniform1f(LENGTH_float, trail.length);
+	glUniform2fv(RADIUS_vec2, 1, glm::value_ptr(radius));
+	glUniform1i(SEGMENTS_int, GLint(palette.size));
+
+	glBindVertexArray(empty_vertex_array);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, palette.tex);
+
+	glDrawArrays(GL_TRIANGLES, 0, GLsizei(6 * palette.size));
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "BallTrail.hpp"
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+//Palette texture holding rainbow_colors() (one texel per trail segment):
+struct RainbowPaletteTexture {
+	RainbowPaletteTexture();
+	~RainbowPaletteTexture();
+
+	GLuint tex = 0;
+	uint32_t size = 0; //texels (trail segments)
+};
+
+//Shader program that draws a ball trail entirely on the GPU:
+// the trail's samples (position + age) are uploaded as a uniform array, and each of the palette's segments
+// is a quad whose vertex shader finds the ball's position at that segment's age (the same
+// interpolation as BallTrail::position_at) and takes its color from the palette texture.
+//No vertex buffers: quads come from gl_VertexID.
+struct TrailProgram {
+	TrailProgram();
+	~TrailProgram();
+
+	//samples beyond this many (the oldest) aren't uploaded:
+	// (each takes one vec4 uniform slot; OpenGL 3.3 guarantees at least 256)
+	static const uint32_t MaxSamples = 160;
+
+	//draw 'trail' as squares of 'radius', oldest segment first (with whatever blending is current):
+	void draw(glm::mat4 const &object_to_clip, BallTrail const &trail, glm::vec2 const &radius, RainbowPaletteTexture const &palette);
+
+	GLuint program = 0;
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint SAMPLES_vec3_array = -1U;
+	GLuint SAMPLE_COUNT_int = -1U;
+	GLuint LENGTH_float = -1U;
+	GLuint RADIUS_vec2 = -1U;
+	GLuint SEGMENTS_int = -1U;
+	//Textures:
+	//TEXTURE0 - the palette
+
+	//(attribute-less) vertex array object, created by the first draw(),
+	// since VAOs are not shared between contexts (see ColorTextureBuffers::get_vertex_array):
+	GLuint empty_vertex_array = 0;
+};
@@ -0,0 +1,144 @@
+//convert-level turns a PNG (one pixel per brick) or text description of a level
+// into the binary level format that BreakoutMode loads (see Level.hpp).
+//It can also generate stress-test levels (see generate_level).
+
+#include "Level.hpp"
+#include "BreakoutGame.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <chrono>
+
+int main(int argc, char **argv) {
+	LevelGridOptions options;
+	std::string in_file, out_file;
+
+	bool generate = false;
+	LevelGenOptions gen;
+	for (uint32_t c = 0; c < BreakoutGame::COLOR_COUNT; ++c) {
+		gen.colors.emplace_back(BreakoutGame::COLORS[c].first);
+	}
+	const char *pattern_names[] = {"solid", "checker", "stripes", "diamond", "clusters"};
+	const char *color_mix_names[] = {"random", "rows", "columns"};
+
+	auto usage = [&]() {
+		std::cerr << "Usage:\n\t" << argv[0] << " [options] <in.png|in.txt> <out.level>\n"
+			"\t" << argv[0] << " [options] --generate <brick count> <out.level>\n"
+			"Options:\n"
+			"\t--brick-radius <x> <y>  half-size of each brick (default: " << options.brick_radius.x << " " << options.brick_radius.y << ")\n"
+			"\t--gap <g>               space between bricks (default: " << options.gap << ")\n"
+			"\t--center <x> <y>        court position of the center of the grid (default: " << options.center.x << " " << options.center.y << ")\n"
+			"\t--court-radius <x> <y>  minimum half-size of the court (default: " << options.court_radius.x << " " << options.court_radius.y << ")\n"
+			"Generator options:\n"
+			"\t--seed <n>              random seed (default: " << gen.seed << ")\n"
+			"\t--density <d>           fraction of pattern cells with bricks (default: " << gen.density << ")\n"
+			"\t--pattern <p>           solid, checker, stripes, diamond, or clusters (default: " << pattern_names[gen.pattern] << ")\n"
+			"\t--color-mix <m>         random, rows, or columns (default: " << color_mix_names[gen.color_mix] << ")\n"
+			"\t--color-weights <w...>  relative frequency of each game color with random mix (" << gen.colors.size() << " numbers)\n"
+			"\t--aspect <a>            width/height of the brick field (default: " << gen.aspect << ")\n"
+			"\t--field-radius <x> <y>  shrink/grow bricks so the field has this half-size (default: keep brick radius)\n"
+			<< std::endl;
+	};
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--brick-radius" && argi + 2 < argc) {
+			options.brick_radius = glm::vec2(std::stof(argv[argi+1]), std::stof(argv[argi+2]));
+			argi += 2;
+		} else if (arg == "--gap" && argi + 1 < argc) {
+			options.gap = std::stof(argv[argi+1]);
+			argi += 1;
+		} else if (arg == "--center" && argi + 2 < argc) {
+			options.center = glm::vec2(std::stof(argv[argi+1]), std::stof(argv[argi+2]));
+			argi += 2;
+		} else if (arg == "--court-radius" && argi + 2 < argc) {
+			options.court_radius = glm::vec2(std::stof(argv[argi+1]), std::stof(argv[argi+2]));
+			argi += 2;
+		} else if (arg == "--generate" && argi + 1 < argc) {
+			generate = true;
+			gen.brick_count = uint32_t(std::stoul(argv[argi+1]));
+			argi += 1;
+		} else if (arg == "--seed" && argi + 1 < argc) {
+			gen.seed = uint32_t(std::stoul(argv[argi+1]));
+			argi += 1;
+		} else if (arg == "--density" && argi + 1 < argc) {
+			gen.density = std::stof(argv[argi+1]);
+			argi += 1;
+		} else if (arg == "--pattern" && argi + 1 < argc) {
+			uint32_t p = 0;
+			while (p < 5 && pattern_names[p] != std::string(argv[argi+1])) ++p;
+			if (p == 5) {
+				usage();
+				return 1;
+			}
+			gen.pattern = LevelGenOptions::Pattern(p);
+			argi += 1;
+		} else if (arg == "--color-mix" && argi + 1 < argc) {
+			uint32_t m = 0;
+			while (m < 3 && color_mix_names[m] != std::string(argv[argi+1])) ++m;
+			if (m == 3) {
+				usage();
+				return 1;
+			}
+			gen.color_mix = LevelGenOptions::ColorMix(m);
+			argi += 1;
+		} else if (arg == "--color-weights" && argi + int(gen.colors.size()) < argc) {
+			gen.color_weights.clear();
+			for (uint32_t c = 0; c < gen.colors.size(); ++c) {
+				gen.color_weights.emplace_back(std::stof(argv[argi+1+c]));
+			}
+			argi += int(gen.colors.size());
+		} else if (arg == "--aspect" && argi + 1 < argc) {
+			gen.aspect = std::stof(argv[argi+1]);
+			argi += 1;
+		} else if (arg == "--field-radius" && argi + 2 < argc) {
+			gen.field_radius = glm::vec2(std::stof(argv[argi+1]), std::stof(argv[argi+2]));
+			argi += 2;
+		} else if (arg.size() > 2 && arg.substr(0,2) == "--") {
+			usage();
+			return 1;
+		} else if (in_file.empty() && !generate) {
+			in_file = arg;
+		} else if (out_file.empty()) {
+			out_file = arg;
+		} else {
+			usage();
+			return 1;
+		}
+	}
+	if ((in_file.empty() && !generate) || out_file.empty()) {
+		usage();
+		return 1;
+	}
+
+	try {
+		LevelData level;
+		if (generate) {
+			gen.grid = options;
+			level = generate_level(gen);
+		} else if (in_file.size() >= 4 && in_file.substr(in_file.size() - 4) == ".png") {
+			level = level_from_png(in_file, options);
+		} else {
+			std::ifstream in(in_file);
+			if (!in) throw std::runtime_error("Failed to open '" + in_file + "'.");
+			level = level_from_text(in, options, in_file);
+		}
+		level.save(out_file);
+
+		//check the result by loading it the same way the game does:
+		auto before = std::chrono::high_resolution_clock::now();
+		Level check(out_file);
+		auto after = std::chrono::high_resolution_clock::now();
+
+		std::cout << "Wrote " << check.brick_count << " bricks (" << check.palette_count << " colors, court radius "
+			<< check.court_radius.x << "x" << check.court_radius.y << ") to '" << out_file << "'; loading took "
+			<< std::chrono::duration< double >(after - before).count() * 1000.0 << "ms." << std::endl;
+	} catch (std::exception const &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
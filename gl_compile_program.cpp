@@ -1,5 +1,7 @@
 #include "gl_compile_program.hpp"
 
+#include "Trace.hpp"
+
 #include <vector>
 #include <string>
 #include <stdexcept>
@@ -31,6 +33,7 @@ GLuint gl_compile_program(
 	std::string const &vertex_shader_source,
 	std::string const &fragment_shader_source
 	) {
+	TRACE_SCOPE("gl_compile_program");
 
 	GLuint vertex_shader = gl_compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
 	GLuint fragment_shader = gl_compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
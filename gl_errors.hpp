@@ -1,17 +1,19 @@
 #pragma once
 
 #include "GL.hpp"
-#include <iostream>
+#include "Log.hpp"
 
 #define STR2(X) # X
 #define STR(X) STR2(X)
 
-inline void gl_errors(std::string const &where) {
+//(takes a C string, so the GL_ERRORS() in every draw doesn't build a std::string;
+// errors go through Log, so an error repeated every frame doesn't flood -- or slow -- the frame)
+inline void gl_errors(char const *where) {
 	GLenum err = 0;
 	while ((err = glGetError()) != GL_NO_ERROR) {
 		#define CHECK( ERR ) \
 			if (err == ERR) { \
-				std::cerr << "WARNING: gl error '" #ERR "' at " << where << std::endl; \
+				Log::write(Log::Warning, "gl error '" #ERR "' at %s", where); \
 			} else
 
 		CHECK( GL_INVALID_ENUM )
@@ -22,7 +24,7 @@ inline void gl_errors(std::string const &where) {
 		CHECK( GL_STACK_UNDERFLOW )
 		CHECK( GL_STACK_OVERFLOW )
 		{
-			std::cerr << "WARNING: gl error '" << err << "'" << std::endl;
+			Log::write(Log::Warning, "gl error '%u' at %s", unsigned(err), where);
 		}
 		#undef CHECK
 	}
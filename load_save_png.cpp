@@ -1,5 +1,8 @@
 #include "load_save_png.hpp"
 
+#include "Trace.hpp"
+#include "Log.hpp"
+
 #include <png.h>
 
 #include <iostream>
@@ -7,7 +10,7 @@
 #include <cassert>
 #include <vector>
 
-#define LOG_ERROR( X ) std::cerr << X << std::endl
+#define LOG_ERROR( X ) Log::write(Log::Error, "%s", X)
 
 using std::vector;
 
@@ -15,6 +18,7 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin);
 
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
+	TRACE_SCOPE("load_png");
 	assert(size);
 
 	std::ifstream file(filename.c_str(), std::ios::binary);
@@ -27,6 +31,7 @@ void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 >
 }
 
 void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin) {
+	TRACE_SCOPE("save_png");
 	std::ofstream file(filename.c_str(), std::ios::binary);
 	save_png(file, size.x, size.y, data, origin);
 }
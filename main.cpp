@@ -4,12 +4,70 @@
 //The 'GameMode' mode plays the game:
 #include "BreakoutMode.hpp"
 
+//...and the classic (selected with --mode pong):
+#include "PongMode.hpp"
+
 //GL.hpp will include a non-namespace-polluting set of opengl prototypes:
 #include "GL.hpp"
 
 //for screenshots:
 #include "load_save_png.hpp"
 
+//for constructing modes in the background:
+#include "ModeLoader.hpp"
+
+//for measuring input-to-photon latency:
+#include "InputLatency.hpp"
+
+//for recording and replaying input:
+#include "InputRecording.hpp"
+
+//for benchmarking with generated levels:
+#include "ScalingBench.hpp"
+
+//for running many automated games:
+#include "BatchRunner.hpp"
+
+//for benchmarking the training environments:
+#include "Env.hpp"
+
+//for checking the software renderer:
+#include "SoftRenderBench.hpp"
+
+//for benchmarking the brick debris particles:
+#include "ParticleBench.hpp"
+
+//for benchmarking multi-ball collisions:
+#include "MultiBallBench.hpp"
+
+//for fuzzing Pong's swept collisions:
+#include "PongFuzz.hpp"
+
+//...and Breakout's:
+#include "BreakoutFuzz.hpp"
+
+//for checking BreakoutLanes against BreakoutGame:
+#include "LanesFuzz.hpp"
+
+//for drawing without a window (--headless):
+#include "OffscreenFramebuffer.hpp"
+
+//for measuring frame times (--bench):
+#include "Benchmark.hpp"
+
+//for recording timelines (--trace):
+#include "Trace.hpp"
+
+//for writing warnings (e.g., GL errors) off the main thread:
+#include "Log.hpp"
+
+//for hardware performance counters (--perf-counters):
+#include "PerfCounters.hpp"
+
+//for counting heap allocations (--allocs) and graphing frames (F3):
+#include "AllocationTracker.hpp"
+#include "ProfilerOverlay.hpp"
+
 //Includes for libSDL:
 #include <SDL.h>
 
@@ -19,6 +77,7 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <thread>
 
 int main(int argc, char **argv) {
 #ifdef _WIN32
@@ -26,10 +85,235 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command-line options ------------
+
+	std::string latency_csv = ""; //if set, track input latency and write it to this file
+	bool latency_gpu = false; //also track when the GPU finished each frame
+	std::string record_file = ""; //if set, record input + frame times to this file
+	std::string replay_file = ""; //if set, replay input + frame times from this file (instead of live input)
+	std::string level_file = ""; //if set, play this level (made with convert-level) instead of the built-in one
+	std::string scaling_bench_json = ""; //if set, run the scaling benchmark (instead of the game) and write results here
+	BatchOptions batch; //with --batch, play batch.games automated games (instead of the game)
+	bool run_batch_games = false;
+	EnvBenchOptions env_bench; //with --env-bench, step env_bench.count environments (instead of the game)
+	bool run_env_bench_steps = false;
+	SoftRenderOptions soft_render; //with --soft-render or --soft-render-check, check the software renderer (instead of the game)
+	bool run_multiball_bench_frames = false; //with --multiball-bench, benchmark (and check) multi-ball updates instead of playing
+	PongFuzzOptions pong_fuzz; //with --fuzz-pong, fuzz Pong's collisions (instead of playing)
+	bool run_pong_fuzz_shots = false;
+	BreakoutFuzzOptions breakout_fuzz; //with --fuzz-breakout, fuzz Breakout's swept collisions (instead of playing)
+	bool run_breakout_fuzz_frames = false;
+	LanesFuzzOptions lanes_fuzz; //with --fuzz-lanes, check BreakoutLanes against BreakoutGame (instead of playing)
+	bool run_lanes_fuzz_frames = false;
+	bool run_particle_bench_frames = false;
+	ParticleBenchOptions particle_bench; //with --particle-bench, benchmark particles (instead of the game)
+	bool run_soft_render_check = false;
+	bool headless = false; //if set, draw into an offscreen framebuffer of headless_size (no visible window, no vsync)
+	glm::uvec2 headless_size = glm::uvec2(640, 480);
+	std::string headless_png = ""; //(with --headless) save the last frame here
+	uint32_t max_frames = 0; //if nonzero, quit after this many frames
+	float max_seconds = 0.0f; //if nonzero, quit after this many seconds
+	std::string mode_name = "breakout"; //which mode to start in ("breakout" or "pong")
+	bool no_vsync = false; //if set, don't wait for vsync
+	std::string bench_json = ""; //if set, measure update/draw/frame times (with a fixed time step) and write a summary here
+	bool use_scripted_input = false; //if set, input comes from scripted_input() (live input is ignored)
+	bool perf_counters = false; //(with --bench) count cycles, instructions, and cache/branch misses per scope
+	bool track_allocations = false; //if set, count heap allocations per frame (shown in the F3 overlay and --bench results)
+	float allocation_budget = -1.0f; //(with --bench) if >= 0, fail if steady-state allocations per frame exceed this
+	std::string trace_json = ""; //if set, record a timeline of traced scopes and write it here (in Chrome's trace format)
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--latency" && argi + 1 < argc) {
+			latency_csv = argv[++argi];
+		} else if (arg == "--latency-gpu") {
+			latency_gpu = true;
+		} else if (arg == "--record" && argi + 1 < argc) {
+			record_file = argv[++argi];
+		} else if (arg == "--replay" && argi + 1 < argc) {
+			replay_file = argv[++argi];
+		} else if (arg == "--level" && argi + 1 < argc) {
+			level_file = argv[++argi];
+		} else if (arg == "--scaling-bench" && argi + 1 < argc) {
+			scaling_bench_json = argv[++argi];
+		} else if (arg == "--batch" && argi + 1 < argc) {
+			run_batch_games = true;
+			batch.games = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--threads" && argi + 1 < argc) {
+			batch.threads = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--seed" && argi + 1 < argc) {
+			batch.seed = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--batch-csv" && argi + 1 < argc) {
+			batch.csv_file = argv[++argi];
+		} else if (arg == "--lanes" && argi + 1 < argc) {
+			batch.lanes = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--validate-lanes") {
+			batch.validate = true;
+		} else if (arg == "--env-bench" && argi + 2 < argc) {
+			run_env_bench_steps = true;
+			env_bench.game = argv[++argi];
+			env_bench.count = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--env-frame" && argi + 1 < argc) {
+			env_bench.frame_png = argv[++argi];
+		} else if (arg == "--soft-render" && argi + 1 < argc) {
+			run_soft_render_check = true;
+			soft_render.png_file = argv[++argi];
+		} else if (arg == "--soft-render-check" && argi + 1 < argc) {
+			run_soft_render_check = true;
+			soft_render.golden_file = argv[++argi];
+		} else if (arg == "--multiball-bench") {
+			run_multiball_bench_frames = true;
+		} else if (arg == "--fuzz-pong" && argi + 1 < argc) {
+			run_pong_fuzz_shots = true;
+			pong_fuzz.shots = uint32_t(std::stoul(argv[++argi]));
+			pong_fuzz.rally_frames = pong_fuzz.shots;
+		} else if (arg == "--fuzz-breakout" && argi + 1 < argc) {
+			run_breakout_fuzz_frames = true;
+			breakout_fuzz.frames = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--fuzz-lanes" && argi + 1 < argc) {
+			run_lanes_fuzz_frames = true;
+			lanes_fuzz.frames = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--particle-bench" && argi + 1 < argc) {
+			run_particle_bench_frames = true;
+			particle_bench.particles = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--headless" && argi + 1 < argc) {
+			headless = true;
+			std::string size = argv[++argi];
+			size_t x = size.find('x');
+			if (x == std::string::npos) {
+				std::cerr << "Expecting --headless <width>x<height> (e.g., 640x480), not '" << size << "'." << std::endl;
+				return 1;
+			}
+			headless_size = glm::uvec2(std::stoul(size.substr(0, x)), std::stoul(size.substr(x + 1)));
+		} else if (arg == "--headless-png" && argi + 1 < argc) {
+			headless_png = argv[++argi];
+		} else if (arg == "--frames" && argi + 1 < argc) {
+			max_frames = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--seconds" && argi + 1 < argc) {
+			max_seconds = std::stof(argv[++argi]);
+		} else if (arg == "--mode" && argi + 1 < argc) {
+			mode_name = argv[++argi];
+			if (mode_name != "breakout" && mode_name != "pong") {
+				std::cerr << "Unknown mode '" << mode_name << "' (expecting 'breakout' or 'pong')." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--no-vsync") {
+			no_vsync = true;
+		} else if (arg == "--bench" && argi + 1 < argc) {
+			bench_json = argv[++argi];
+		} else if (arg == "--scripted-input") {
+			use_scripted_input = true;
+		} else if (arg == "--perf-counters") {
+			perf_counters = true;
+		} else if (arg == "--allocs") {
+			track_allocations = true;
+		} else if (arg == "--alloc-budget" && argi + 1 < argc) {
+			track_allocations = true;
+			allocation_budget = std::stof(argv[++argi]);
+		} else if (arg == "--trace" && argi + 1 < argc) {
+			trace_json = argv[++argi];
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [options]\n"
+				"Options:\n"
+				"\t--latency <file.csv>  measure input-to-photon latency of every input event; summarize it, and write the most recent 65536 to <file.csv>\n"
+				"\t--latency-gpu         (with --latency) also record when the GPU finished each frame\n"
+				"\t--record <file>       record input events and frame times to <file>\n"
+				"\t--replay <file>       play back input events and frame times from <file> (live input is ignored)\n"
+				"\t--perf-counters       (with --bench) also report IPC and cache/branch miss rates per scope (Linux perf_event counters)\n"
+				"\t--allocs              count heap allocations per frame and per scope, sampling stacks (F3 graphs them; --bench reports them)\n"
+				"\t--alloc-budget <n>    (with --bench) as --allocs, and fail if steady-state allocations per frame average more than <n>\n"
+				"\t--trace <file.json>   record a timeline of each frame's phases (and loading, on every thread); write it to <file.json>\n"
+				"\t                      (F9 writes the timeline so far; open in chrome://tracing or ui.perfetto.dev)\n"
+				"\t--level <file>        play the level in <file> (see convert-level)\n"
+				"\t--scaling-bench <file.json>  benchmark simulation + drawing with 1k-1M generated bricks; write results to <file.json>\n"
+				"\t--batch <n>           play <n> automated games (no window) and report games/sec and outcomes\n"
+				"\t--threads <t>         (with --batch, --env-bench, --soft-render, --particle-bench, or --multiball-bench) threads to use (default: one per hardware thread)\n"
+				"\t--seed <s>            (with --batch, --env-bench, --soft-render, --fuzz-pong, --fuzz-breakout, or --fuzz-lanes) game i uses seed <s>+i (default: 0)\n"
+				"\t--batch-csv <file>    (with --batch) write each game's outcome to <file>\n"
+				"\t--lanes <8|16>        (with --batch) step games in groups of 8 or 16 with BreakoutLanes\n"
+				"\t--validate-lanes      (with --batch --lanes) check every lane against BreakoutGame, every frame\n"
+				"\t--env-bench <breakout|pong> <n>  step <n> training environments with random actions and report steps/sec\n"
+				"\t--env-frame <file.png>  (with --env-bench) also render 84x84 frames; save game 0's last one to <file.png>\n"
+				"\t--soft-render <file.png>  draw a frame with the software renderer, report its speed and difference from OpenGL, and save it to <file.png>\n"
+				"\t--soft-render-check <golden.png>  as --soft-render, but fail unless the frame matches <golden.png> exactly\n"
+				"\t--multiball-bench    time BreakoutGame::update with 1-4000 balls and 10k-100k generated bricks, on 1 and --threads threads\n"
+				"\t                      (with both the discrete and the swept rules),\n"
+				"\t                      failing unless sweep-and-prune matches brute force and every thread count matches\n"
+				"\t--fuzz-pong <n>       fire <n> random high-speed shots at a moving Pong paddle and play <n> random rally frames,\n"
+				"\t                      failing if the ball ever passes through a paddle, misses a goal, or leaves the court\n"
+				"\t--fuzz-breakout <n>   play <n> swept-collision Breakout steps at random speeds on random generated levels,\n"
+				"\t                      failing if the ball ever ends a step inside a brick or passes through one\n"
+				"\t--fuzz-lanes <n>      play <n> steps of BreakoutLanes next to BreakoutGames, with random input on random generated levels,\n"
+				"\t                      failing if any lane's state ever differs from its BreakoutGame's\n"
+				"\t--particle-bench <n>  keep <n> brick-debris particles alive; report update and draw times (OpenGL instanced and SoftRaster),\n"
+				"\t                      failing unless both frames fit in 1/60s -- SoftRaster's on --threads threads (try 100000, with LIBGL_ALWAYS_SOFTWARE=1)\n"
+				"\t--headless <w>x<h>    no visible window: draw each frame into a <w>x<h> offscreen framebuffer, without vsync\n"
+				"\t                      (uses SDL's 'offscreen' video driver -- EGL -- so works without a display; Mesa works without a GPU)\n"
+				"\t--headless-png <file.png>  (with --headless) save the last frame to <file.png>\n"
+				"\t--frames <n>          quit after <n> frames (with --headless, default 600)\n"
+				"\t--seconds <s>         quit after <s> seconds\n"
+				"\t--mode <breakout|pong>  start in this mode (default: breakout; Tab switches between them while playing)\n"
+				"\t--no-vsync            don't wait for vsync (run uncapped)\n"
+				"\t--bench <file.json>   step with a fixed 1/60s and report update/draw/frame time percentiles; write them to <file.json>\n"
+				"\t--scripted-input      feed the mode a fixed sequence of mouse motion, clicks, and key presses (live input is ignored)\n"
+				<< std::endl;
+			return 1;
+		}
+	}
+
+	//------------  batch runs (no window needed) ------------
+
+	if (run_batch_games) {
+		batch.level_file = level_file;
+		return run_batch(batch, std::cout) ? 0 : 1;
+	}
+
+	if (run_env_bench_steps) {
+		env_bench.threads = batch.threads;
+		env_bench.seed = batch.seed;
+		env_bench.level_file = level_file;
+		run_env_bench(env_bench, std::cout);
+		return 0;
+	}
+
+	if (run_multiball_bench_frames) {
+		MultiBallBenchOptions options;
+		options.seed = batch.seed;
+		if (batch.threads != 0) options.thread_counts = std::vector< uint32_t >{1, batch.threads};
+		return run_multiball_bench(options, std::cout) ? 0 : 1;
+	}
+
+	if (run_pong_fuzz_shots) {
+		pong_fuzz.seed = batch.seed;
+		return run_pong_fuzz(pong_fuzz, std::cout) ? 0 : 1;
+	}
+
+	if (run_breakout_fuzz_frames) {
+		breakout_fuzz.seed = batch.seed;
+		return run_breakout_fuzz(breakout_fuzz, std::cout) ? 0 : 1;
+	}
+
+	if (run_lanes_fuzz_frames) {
+		lanes_fuzz.seed = batch.seed;
+		return run_lanes_fuzz(lanes_fuzz, std::cout) ? 0 : 1;
+	}
+
 	//------------  initialization ------------
 
+	//warnings from here on (e.g., GL errors) are written by a background thread:
+	Log::start();
+
+	//headless runs use SDL's offscreen (EGL) video driver unless another one was asked for:
+	if (headless) {
+		if (!SDL_getenv("SDL_VIDEODRIVER")) SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+		if (max_frames == 0 && replay_file == "") max_frames = 600;
+	}
+
 	//Initialize SDL library:
-	SDL_Init(SDL_INIT_VIDEO);
+	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+		std::cerr << "Error initializing SDL: " << SDL_GetError() << std::endl;
+		return 1;
+	}
 
 	//Ask for an OpenGL context version 3.3, core profile, enable debug:
 	SDL_GL_ResetAttributes();
@@ -46,13 +330,13 @@ int main(int argc, char **argv) {
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
 	//create window:
+	// (headless runs still need one to hold the context, but never show it)
 	SDL_Window *window = SDL_CreateWindow(
 		"Breakout Color", //TODO: remember to set a title for your game!
 		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
 		640, 480, //TODO: modify window size if you'd like
 		SDL_WINDOW_OPENGL
-		| SDL_WINDOW_RESIZABLE //uncomment to allow resizing
-		| SDL_WINDOW_ALLOW_HIGHDPI //uncomment for full resolution on high-DPI screens
+		| (headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI)
 	);
 
 	//prevent exceedingly tiny windows when resizing:
@@ -76,7 +360,10 @@ int main(int argc, char **argv) {
 	init_GL();
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
-	if (SDL_GL_SetSwapInterval(-1) != 0) {
+	// (headless runs want crazy FPS)
+	if (headless || no_vsync) {
+		SDL_GL_SetSwapInterval(0);
+	} else if (SDL_GL_SetSwapInterval(-1) != 0) {
 		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
 		if (SDL_GL_SetSwapInterval(1) != 0) {
 			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
@@ -86,8 +373,91 @@ int main(int argc, char **argv) {
 	//Hide mouse cursor (note: showing can be useful for debugging):
 	//SDL_ShowCursor(SDL_DISABLE);
 
+	//------------ benchmarks (run instead of the game) --------------
+	if (scaling_bench_json != "") {
+		int w,h;
+		SDL_GL_GetDrawableSize(window, &w, &h);
+		ScalingBenchOptions options;
+		options.drawable_size = glm::uvec2(w, h);
+		run_scaling_bench(options, scaling_bench_json);
+
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		return 0;
+	}
+	if (run_soft_render_check) {
+		soft_render.level_file = level_file;
+		soft_render.threads = batch.threads;
+		soft_render.seed = batch.seed;
+		bool matched = run_soft_render(soft_render, std::cout);
+
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		return matched ? 0 : 1;
+	}
+	if (run_particle_bench_frames) {
+		particle_bench.threads = batch.threads;
+		bool fits = run_particle_bench(particle_bench, std::cout);
+
+		SDL_GL_DeleteContext(context);
+		SDL_DestroyWindow(window);
+		return fits ? 0 : 1;
+	}
+
+	//------------ background mode loader --------------
+	//(Mode::set_current_async uses this to construct modes on a worker thread with a shared context)
+	std::unique_ptr< ModeLoader > loader(new ModeLoader(window));
+
+	//------------ instrumentation --------------
+	std::unique_ptr< InputLatency > latency;
+	if (latency_csv != "") latency.reset(new InputLatency(latency_gpu));
+
+	std::unique_ptr< InputRecorder > recorder;
+	if (record_file != "") recorder.reset(new InputRecorder(record_file));
+
+	std::unique_ptr< InputReplayer > replayer;
+	if (replay_file != "") replayer.reset(new InputReplayer(replay_file));
+
+	std::unique_ptr< Benchmark > bench;
+	if (bench_json != "") bench.reset(new Benchmark(bench_json));
+	if (perf_counters) {
+		if (!bench) {
+			std::cerr << "--perf-counters reports with --bench; ignoring it." << std::endl;
+		} else {
+			PerfCounters::enable(); //(warns and carries on if the counters aren't available)
+		}
+	}
+
+	std::unique_ptr< ProfilerOverlay > overlay(new ProfilerOverlay());
+	if (track_allocations) {
+		AllocationTracker::enable();
+		if (bench) bench->allocation_budget = allocation_budget;
+	}
+
+	Trace::set_thread_name("main");
+	if (trace_json != "") Trace::enable();
+	std::vector< SDL_Event > scripted_events;
+
+	//------------ offscreen target --------------
+	std::unique_ptr< OffscreenFramebuffer > offscreen;
+	if (headless) offscreen.reset(new OffscreenFramebuffer(headless_size));
+
 	//------------ create game mode + make current --------------
-	Mode::set_current(std::make_shared< BreakoutMode >());
+	//(modes are constructed by the loader, both here and when Tab switches games while playing)
+	auto switch_to = [&level_file](std::string const &name) {
+		Mode::set_current_async([name, level_file]() -> std::shared_ptr< Mode > {
+			if (name == "pong") return std::make_shared< PongMode >();
+			else return std::make_shared< BreakoutMode >(level_file);
+		});
+	};
+	std::string playing = mode_name;
+	switch_to(playing);
+	//there's nothing to draw until the first mode is ready, so wait for it
+	// (replays and benchmarks also expect it from the first frame):
+	while (!Mode::current) {
+		loader->poll(); //(re-throws if the mode failed to construct -- e.g., a bad level file)
+		if (!Mode::current) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
 
 	//------------ main loop ------------
 
@@ -98,28 +468,111 @@ int main(int argc, char **argv) {
 	//On non-highDPI displays, window_size will always equal drawable_size.
 	auto on_resize = [&](){
 		int w,h;
-		SDL_GetWindowSize(window, &w, &h);
-		window_size = glm::uvec2(w, h);
 		SDL_GL_GetDrawableSize(window, &w, &h);
 		drawable_size = glm::uvec2(w, h);
+		if (offscreen) drawable_size = offscreen->size;
 		glViewport(0, 0, drawable_size.x, drawable_size.y);
+		//(when replaying, modes see the window sizes from the recording instead)
+		if (replayer) return;
+		SDL_GetWindowSize(window, &w, &h);
+		window_size = glm::uvec2(w, h);
+		if (offscreen) window_size = offscreen->size;
+		//let modes update anything that depends on the window size (e.g., court transforms):
+		Mode::set_size(window_size, drawable_size);
+		if (recorder) recorder->resize(window_size, drawable_size);
 	};
 	on_resize();
 
+	//pass an input event to the current mode (recording it, if recording):
+	auto dispatch = [&](SDL_Event const &evt) -> bool {
+		if (!Mode::current) return false;
+		if (recorder) recorder->event(evt);
+		return Mode::current->handle_event(evt, window_size);
+	};
+
+	//Mouse motion is coalesced: rather than passing every SDL_MOUSEMOTION to the mode,
+	// the latest mouse position is sampled right before update and again right before draw
+	// (so paddles track the mouse as of this frame, not as of the oldest queued event).
+	glm::ivec2 latched_mouse = glm::ivec2(-1); //position most recently passed to the mode
+	std::weak_ptr< Mode > latched_mode; //...and the mode it was passed to
+	auto send_motion = [&](int32_t x, int32_t y, uint32_t state) {
+		if (!Mode::current) return;
+		//a mode that has just become current (e.g., after Tab switches games) hasn't seen the mouse yet:
+		if (latched_mode.lock() != Mode::current) {
+			latched_mouse = glm::ivec2(-1);
+			latched_mode = Mode::current;
+		}
+		if (latched_mouse == glm::ivec2(x, y)) return;
+		SDL_Event motion;
+		motion.type = SDL_MOUSEMOTION;
+		motion.motion.timestamp = SDL_GetTicks();
+		motion.motion.windowID = SDL_GetWindowID(window);
+		motion.motion.which = 0;
+		motion.motion.state = state;
+		motion.motion.x = x;
+		motion.motion.y = y;
+		motion.motion.xrel = (latched_mouse.x < 0 ? 0 : x - latched_mouse.x);
+		motion.motion.yrel = (latched_mouse.y < 0 ? 0 : y - latched_mouse.y);
+		latched_mouse = glm::ivec2(x, y);
+		dispatch(motion);
+	};
+	auto latch_mouse = [&]() {
+		if (replayer) return;
+		if (SDL_GetMouseFocus() != window) return;
+		int x, y;
+		uint32_t state = SDL_GetMouseState(&x, &y);
+		send_motion(x, y, state);
+	};
+
+	//when replaying, each frame's inputs, elapsed time, and expected state come from the recording:
+	std::vector< InputReplayer::Input > replay_inputs;
+	float replay_elapsed = 0.0f;
+	uint64_t replay_hash = 0;
+
+	uint32_t frames = 0;
+	auto first_frame = std::chrono::high_resolution_clock::now();
+
 	//This will loop until the current mode is set to null:
 	while (Mode::current) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
 
+		auto frame_start = std::chrono::high_resolution_clock::now();
+		float update_seconds = 0.0f, draw_seconds = 0.0f; //(for --bench)
+
+		//(0) swap in any mode that has finished loading in the background:
+		loader->poll();
+
 		{ //(1) process any events that are pending
+			TRACE_SCOPE("events");
+			ALLOC_SCOPE("events");
 			static SDL_Event evt;
+			SDL_Event pending_motion = SDL_Event(); //most recent un-delivered motion event
+			bool have_pending_motion = false;
 			while (SDL_PollEvent(&evt) == 1) {
+				if (latency) latency->tag(evt);
 				//handle resizing:
 				if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
 					on_resize();
 				}
+				//when replaying (or scripting input), live input is ignored:
+				if ((replayer || use_scripted_input) && (evt.type == SDL_MOUSEMOTION || evt.type == SDL_MOUSEBUTTONDOWN || evt.type == SDL_MOUSEBUTTONUP
+				              || evt.type == SDL_MOUSEWHEEL || evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP)) {
+					continue;
+				}
+				//coalesce mouse motion:
+				if (evt.type == SDL_MOUSEMOTION) {
+					pending_motion = evt;
+					have_pending_motion = true;
+					continue;
+				}
+				//...but make sure buttons see the mouse where it was when they were pressed:
+				if (have_pending_motion && (evt.type == SDL_MOUSEBUTTONDOWN || evt.type == SDL_MOUSEBUTTONUP)) {
+					send_motion(pending_motion.motion.x, pending_motion.motion.y, pending_motion.motion.state);
+					have_pending_motion = false;
+				}
 				//handle input:
-				if (Mode::current && Mode::current->handle_event(evt, window_size)) {
+				if (dispatch(evt)) {
 					// mode handled it; great
 				} else if (evt.type == SDL_QUIT) {
 					Mode::set_current(nullptr);
@@ -138,12 +591,65 @@ int main(int argc, char **argv) {
 						px.a = 0xff;
 					}
 					save_png(filename, glm::uvec2(w,h), data.data(), LowerLeftOrigin);
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F9 && trace_json != "") {
+					// --- trace key ---
+					Trace::write_json(trace_json);
+					std::cout << "Wrote trace so far to '" << trace_json << "'." << std::endl;
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F3) {
+					// --- profiler overlay key ---
+					overlay->visible = !overlay->visible;
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_TAB && !recorder && !bench) {
+					// --- switch game key ---
+					//(the current game keeps playing until the other one has loaded;
+					// not while recording, since the frame the switch lands on isn't repeatable)
+					playing = (playing == "pong" ? "breakout" : "pong");
+					switch_to(playing);
 				}
 			}
 			if (!Mode::current) break;
+
+			//deliver motion that wasn't followed by a button (latch_mouse won't, if the mouse has left the window):
+			if (have_pending_motion) {
+				send_motion(pending_motion.motion.x, pending_motion.motion.y, pending_motion.motion.state);
+				have_pending_motion = false;
+			}
+
+			//late-latch mouse position before update:
+			latch_mouse();
+
+			//feed in recorded input:
+			if (replayer) {
+				if (!replayer->next_frame(&replay_inputs, &replay_elapsed, &replay_hash)) {
+					Mode::set_current(nullptr);
+					break;
+				}
+				for (auto const &input : replay_inputs) {
+					if (input.is_resize) {
+						window_size = input.window_size;
+						Mode::set_size(input.window_size, input.drawable_size);
+					} else {
+						dispatch(input.evt);
+					}
+				}
+				if (!Mode::current) break;
+			}
+
+			//feed in scripted input:
+			if (use_scripted_input) {
+				scripted_input(frames, window_size, &scripted_events);
+				for (auto const &evt : scripted_events) {
+					dispatch(evt);
+				}
+				if (!Mode::current) break;
+			}
+
+			if (latency) latency->mark_handled();
 		}
 
-		{ //(2) call the current mode's "update" function to deal with elapsed time:
+		{ //(2) call the "update" function of every (un-paused) mode on the stack to deal with elapsed time:
+			TRACE_SCOPE("update");
+			PERF_SCOPE("update");
+			ALLOC_SCOPE("update");
 			auto current_time = std::chrono::high_resolution_clock::now();
 			static auto previous_time = current_time;
 			float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
@@ -153,29 +659,149 @@ int main(int argc, char **argv) {
 			//lag to avoid spiral of death:
 			elapsed = std::min(0.1f, elapsed);
 
-			Mode::current->update(elapsed);
+			//benchmarks use a fixed time step, so runs are repeatable:
+			if (bench) elapsed = 1.0f / 60.0f;
+
+			//replays use the recorded elapsed time, not the wall clock:
+			if (replayer) elapsed = replay_elapsed;
+
+			auto before_update = std::chrono::high_resolution_clock::now();
+			Mode::update_stack(elapsed);
+			update_seconds = std::chrono::duration< float >(std::chrono::high_resolution_clock::now() - before_update).count();
 			if (!Mode::current) break;
+
+			if (recorder || replayer) {
+				uint64_t hash = Mode::stack_state_hash();
+				if (recorder) recorder->frame(elapsed, hash);
+				if (replayer) replayer->check(replay_hash, hash);
+			}
+
+			if (latency) latency->mark_update();
+		}
+
+		{ //(3) call the "draw" function of the modes on the stack (bottom-to-top) to produce output:
+			TRACE_SCOPE("draw");
+			PERF_SCOPE("draw");
+			ALLOC_SCOPE("draw");
+
+			//late-latch mouse position again before draw:
+			SDL_PumpEvents();
+			latch_mouse();
+
+			if (offscreen) offscreen->bind();
+			auto before_draw = std::chrono::high_resolution_clock::now();
+			Mode::draw_stack(drawable_size);
+			draw_seconds = std::chrono::duration< float >(std::chrono::high_resolution_clock::now() - before_draw).count();
+			overlay->draw(drawable_size);
+
+			if (latency) latency->mark_draw();
 		}
 
-		{ //(3) call the current mode's "draw" function to produce output:
+		if (offscreen) {
+			TRACE_SCOPE("finish");
+			ALLOC_SCOPE("swap");
+			//Nothing to show, but wait for the frame to finish (as a swap would) so frames don't pile up:
+			glFinish();
+		} else {
+			TRACE_SCOPE("swap");
+			ALLOC_SCOPE("swap");
+			//Wait until the recently-drawn frame is shown before doing it all again:
+			SDL_GL_SwapWindow(window);
+		}
+
+		if (latency) latency->mark_swap();
 
-			Mode::current->draw(drawable_size);
+		auto frame_end = std::chrono::high_resolution_clock::now();
+		float frame_seconds = std::chrono::duration< float >(frame_end - frame_start).count();
+		if (bench) bench->frame(update_seconds, draw_seconds, frame_seconds);
+
+		AllocationTracker::Frame allocations;
+		if (AllocationTracker::enabled()) {
+			AllocationTracker::end_frame(&allocations);
+			if (bench) bench->allocations(allocations);
 		}
+		overlay->frame(update_seconds, draw_seconds, frame_seconds, allocations);
 
-		//Wait until the recently-drawn frame is shown before doing it all again:
-		SDL_GL_SwapWindow(window);
+		frames += 1;
+		if (max_frames != 0 && frames >= max_frames) break;
+		if (max_seconds != 0.0f && std::chrono::duration< float >(frame_end - first_frame).count() >= max_seconds) break;
+	}
+
+	//the loop may have stopped (--frames, --seconds) with modes still on the stack;
+	// free them -- and their OpenGL resources -- now, while the context is still current:
+	Mode::set_current(nullptr);
+
+	if (offscreen) {
+		double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - first_frame).count();
+		std::cout << "Drew " << frames << " frames (" << offscreen->size.x << "x" << offscreen->size.y << ", headless) in " << seconds << "s: "
+			<< (frames / seconds) << " frames/sec." << std::endl;
+		if (headless_png != "") {
+			std::vector< glm::u8vec4 > data;
+			offscreen->read(&data);
+			save_png(headless_png, offscreen->size, data.data(), LowerLeftOrigin);
+			std::cout << "Wrote the last frame to '" << headless_png << "'." << std::endl;
+		}
+		offscreen.reset();
 	}
 
 
 	//------------  teardown ------------
 
+	int exit_code = 0;
+
+	if (trace_json != "") {
+		Trace::disable();
+		Trace::write_json(trace_json);
+		std::cout << "Wrote trace to '" << trace_json << "'." << std::endl;
+	}
+
+	if (bench) {
+		std::vector< std::pair< std::string, std::string > > settings;
+		settings.emplace_back("mode", "\"" + mode_name + "\"");
+		settings.emplace_back("drawable_size", "[" + std::to_string(drawable_size.x) + ", " + std::to_string(drawable_size.y) + "]");
+		settings.emplace_back("headless", headless ? "true" : "false");
+		settings.emplace_back("vsync", (headless || no_vsync) ? "false" : "true");
+		settings.emplace_back("input", replayer ? "\"replay\"" : (use_scripted_input ? "\"scripted\"" : "\"live\""));
+		if (!bench->finish(std::cout, settings)) exit_code = 1;
+		bench.reset();
+		PerfCounters::disable();
+	} else if (AllocationTracker::enabled()) {
+		std::cout << "Allocations:\n";
+		AllocationTracker::print_top_stacks(std::cout, 5);
+	}
+
+	recorder.reset();
+
+	if (replayer) {
+		std::cout << "Replayed " << replayer->frames << " frames from '" << replay_file << "'";
+		if (replayer->diverged_frames) {
+			std::cout << "; " << replayer->diverged_frames << " diverged from the recording (first at frame " << replayer->first_divergence << ")." << std::endl;
+		} else {
+			std::cout << "; all matched the recording." << std::endl;
+		}
+		replayer.reset();
+	}
+
+	if (latency) {
+		latency->print_summary(std::cout);
+		latency->write_csv(latency_csv);
+		std::cout << "Wrote the last " << latency->samples.size() << " input latency samples to '" << latency_csv << "'." << std::endl;
+		latency.reset();
+	}
+
+	AllocationTracker::disable();
+	overlay.reset();
+	loader.reset();
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
 	SDL_DestroyWindow(window);
 	window = NULL;
 
-	return 0;
+	Log::stop();
+
+	return exit_code;
 
 #ifdef _WIN32
 	} catch (std::exception const &e) {
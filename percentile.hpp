@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <ostream>
+#include <cmath>
+
+//percentile of a list of samples, with linear interpolation between ranks:
+// 'p' is in [0,1] (e.g., 0.95f for p95); 'sorted' must be sorted ascending.
+inline float percentile(std::vector< float > const &sorted, float p) {
+	if (sorted.empty()) return 0.0f;
+	float rank = p * float(sorted.size() - 1);
+	size_t lo = size_t(std::floor(rank));
+	size_t hi = std::min(lo + 1, sorted.size() - 1);
+	float t = rank - float(lo);
+	return sorted[lo] + t * (sorted[hi] - sorted[lo]);
+}
+
+//summary of a list of per-frame samples (for benchmark output):
+struct Samples {
+	std::vector< float > values;
+	//write {"frames", "mean", "p50", "p95", "p99", "max"} as a JSON object (sorts 'values'):
+	void write_json(std::ostream &out) {
+		std::sort(values.begin(), values.end());
+		double sum = 0.0;
+		for (float v : values) sum += v;
+		out << "{\"frames\": " << values.size()
+			<< ", \"mean\": " << (values.empty() ? 0.0 : sum / values.size())
+			<< ", \"p50\": " << percentile(values, 0.5f)
+			<< ", \"p95\": " << percentile(values, 0.95f)
+			<< ", \"p99\": " << percentile(values, 0.99f)
+			<< ", \"max\": " << (values.empty() ? 0.0f : values.back()) << "}";
+	}
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+
+//swept (continuous) collision of a moving point with a box, for bouncing balls:
+// (test a ball's center against the box grown by the ball's radius; for a moving box,
+//  pass the point's motion relative to the box)
+//
+//sets 'time' to when (as a fraction of 'delta') the point 'from' moving by 'delta' reaches the box at 'center'
+// with 'radius', and 'axis' to the axis (0 = x, 1 = y) it crosses to get in;
+// returns false if it doesn't get there during the move (or starts inside the box):
+inline bool sweep_box(glm::vec2 const &from, glm::vec2 const &delta, glm::vec2 const &center, glm::vec2 const &radius, float *time, uint32_t *axis) {
+	float enter = -std::numeric_limits< float >::infinity();
+	float exit = std::numeric_limits< float >::infinity();
+	*axis = 2;
+	for (uint32_t k = 0; k < 2; ++k) {
+		float lo = center[k] - radius[k] - from[k];
+		float hi = center[k] + radius[k] - from[k];
+		if (delta[k] == 0.0f) {
+			if (lo > 0.0f || hi < 0.0f) return false; //(never within the box's extent on this axis)
+			continue;
+		}
+		float a = lo / delta[k];
+		float b = hi / delta[k];
+		if (a > b) std::swap(a, b);
+		if (a > enter) {
+			enter = a;
+			*axis = k;
+		}
+		exit = std::min(exit, b);
+	}
+	if (*axis == 2 || enter < 0.0f || enter > 1.0f || enter > exit) return false;
+	*time = enter;
+	return true;
+}